@@ -3,6 +3,7 @@
  */
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include "cachelab.h"
 #include <time.h>
@@ -10,6 +11,9 @@
 trans_func_t func_list[MAX_TRANS_FUNCS];
 int func_counter = 0; 
 
+kernel_entry_t kernel_list[MAX_KERNELS];
+int kernel_counter = 0;
+
 /* 
  * printSummary - Summarize the cache simulation statistics. Student cache simulators
  *                must call this function in order to be properly autograded. 
@@ -81,3 +85,27 @@ void registerTransFunction(void (*trans)(int M, int N, int[N][M], int[M][N]),
     func_list[func_counter].num_evictions =0;
     func_counter++;
 }
+
+/* 
+ * registerKernel - Add a kernel descriptor to the kernel list, pairing
+ *     it with the other build of the same kernel if that is already there
+ */
+void registerKernel(const kernel_desc_t* k, int instrumented)
+{
+    int i;
+
+    for (i = 0; i < kernel_counter; i++)
+        if (strcmp(kernel_list[i].name, k->name) == 0)
+            break;
+    if (i == kernel_counter) {
+        assert(kernel_counter < MAX_KERNELS);
+        kernel_list[i].name = k->name;
+        kernel_list[i].native = NULL;
+        kernel_list[i].sim = NULL;
+        kernel_counter++;
+    }
+    if (instrumented)
+        kernel_list[i].sim = k;
+    else
+        kernel_list[i].native = k;
+}
@@ -5,6 +5,8 @@
 #ifndef CACHELAB_TOOLS_H
 #define CACHELAB_TOOLS_H
 
+#include <stddef.h>
+
 #define MAX_TRANS_FUNCS 100
 
 typedef struct trans_func{
@@ -34,4 +36,77 @@ void correctTrans(int M, int N, int A[N][M], int B[M][N]);
 void registerTransFunction(
     void (*trans)(int M,int N,int[N][M],int[M][N]), char* desc);
 
+/* Block visiting orders for trans_blocked() */
+#define TRANS_BLOCK_ROWS 0     /* blocks of A row by row */
+#define TRANS_BLOCK_COLS 1     /* blocks of A column by column */
+
+/* Element strategies inside a block for trans_blocked() */
+#define TRANS_ROWS       0     /* read A row-wise */
+#define TRANS_COLS       1     /* read A column-wise */
+#define TRANS_ROWS_DEFER 2     /* row-wise, diagonal element stored last */
+#define TRANS_ROWS_REGS  3     /* up to 8 elements of a row held in locals */
+#define TRANS_SPLIT8     4     /* 8x8 blocks as 4x4 quadrants, B as buffer */
+#define TRANS_QUAD4      5     /* 8x8 blocks as 4x4 quadrants, row registers */
+#define TRANS_PAIRS      6     /* 2x4 tiles held in locals */
+#define TRANS_TILE8      7     /* up to 8x8 tiles in 64 locals (not 12) */
+#define TRANS_NSTRATEGIES 8
+
+/* Blocked transpose parameterized by block shape and strategy
+   (transblock.c) */
+void trans_blocked(int M, int N, int A[N][M], int B[M][N],
+                   int bw, int bh, int block_order, int strategy);
+
+/* Transpose the h x w tile of A at A[i][j] (h, w <= 8) in locals, the
+   base case of trans_recursive() (trans.c) */
+void trans_tile(int M, int N, int A[N][M], int B[M][N],
+                int i, int j, int h, int w);
+
+/* The cache-oblivious transpose in trans.c, for comparison */
+void trans_recursive(int M, int N, int A[N][M], int B[M][N]);
+
+/* Register the kernel in trans-tuned.c for an MxN transpose, if any.
+   Called by test-trans and tracegen, which know the shape */
+void registerTunedFunctions(int M, int N);
+
+/*
+ * Kernel descriptors, for evaluating memory-bound kernels other than
+ * transpose with kernelbench. A kernel works on one block of memory
+ * that the driver allocates (mem_size bytes, page aligned) and fills
+ * with init; run must give the same outputs each time it is called on
+ * the same inputs. Kernels in the same group compute the same outputs,
+ * so their checksums must agree.
+ */
+#define MAX_KERNELS 64
+
+typedef struct kernel_desc {
+    const char* name;
+    const char* group;
+    const char* description;
+    int default_n;                          /* problem size if -n is not given */
+    size_t (*mem_size)(int n);
+    void (*init)(void* mem, int n);         /* deterministic inputs */
+    void (*run)(void* mem, int n);
+    unsigned long long (*checksum)(const void* mem, int n);  /* of the outputs */
+} kernel_desc_t;
+
+/* A registered kernel: the native build and the build instrumented for
+   the cache model (either may be missing) */
+typedef struct kernel_entry {
+    const char* name;
+    const kernel_desc_t* native;
+    const kernel_desc_t* sim;
+} kernel_entry_t;
+
+/* Add a kernel to the kernel list. Descriptors with the same name from
+   the native and instrumented builds share one entry */
+void registerKernel(const kernel_desc_t* k, int instrumented);
+
+/* Register every kernel in kernels.c, from the native build
+   (kernels.o) and from the instrumented build (kernels-sim.o) */
+void registerKernels();
+void registerSimKernels();
+
+extern kernel_entry_t kernel_list[MAX_KERNELS];
+extern int kernel_counter;
+
 #endif /* CACHELAB_TOOLS_H */
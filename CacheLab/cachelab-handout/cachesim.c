@@ -0,0 +1,82 @@
+/*
+ * cachesim.c - An embedded LRU cache model
+ *
+ * Tags are stored shifted left by one with the valid bit in bit 0, so
+ * a lookup is a single compare per way.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "cachesim.h"
+
+/* 
+ * cache_sim_create - Allocate an empty cache
+ */
+cache_sim_t* cache_sim_create(int s, int E, int b)
+{
+    cache_sim_t* c = (cache_sim_t*)calloc(1, sizeof(cache_sim_t));
+    size_t lines = ((size_t)1 << s) * E;
+
+    c->s = s;
+    c->E = E;
+    c->b = b;
+    c->tags = (unsigned long long*)calloc(lines, sizeof(unsigned long long));
+    c->stamps = (unsigned long long*)calloc(lines, sizeof(unsigned long long));
+    return c;
+}
+
+/* 
+ * cache_sim_reset - Invalidate every line and zero the counters
+ */
+void cache_sim_reset(cache_sim_t* c)
+{
+    size_t lines = ((size_t)1 << c->s) * c->E;
+
+    memset(c->tags, 0, lines * sizeof(unsigned long long));
+    memset(c->stamps, 0, lines * sizeof(unsigned long long));
+    c->timer = 0;
+    c->hits = c->misses = c->evictions = 0;
+}
+
+/* 
+ * cache_sim_access - Look up addr, filling the LRU line on a miss
+ */
+void cache_sim_access(cache_sim_t* c, unsigned long long addr)
+{
+    unsigned long long block = addr >> c->b;
+    unsigned long long key = ((block >> c->s) << 1) | 1;
+    size_t base = (size_t)(block & ((1ULL << c->s) - 1)) * c->E;
+    unsigned long long* tags = c->tags + base;
+    unsigned long long* stamps = c->stamps + base;
+    int i, victim = 0;
+
+    c->timer++;
+    for (i = 0; i < c->E; i++) {
+        if (tags[i] == key) {
+            c->hits++;
+            stamps[i] = c->timer;
+            return;
+        }
+    }
+
+    /* Miss: use the first invalid line, else the least recently used */
+    c->misses++;
+    for (i = 0; i < c->E; i++) {
+        if (!(tags[i] & 1)) {
+            victim = i;
+            break;
+        }
+        if (stamps[i] < stamps[victim])
+            victim = i;
+    }
+    if (i == c->E)
+        c->evictions++;
+    tags[victim] = key;
+    stamps[victim] = c->timer;
+}
+
+void cache_sim_free(cache_sim_t* c)
+{
+    free(c->tags);
+    free(c->stamps);
+    free(c);
+}
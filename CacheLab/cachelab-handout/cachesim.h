@@ -0,0 +1,30 @@
+/*
+ * cachesim.h - An embedded LRU cache model, so that tools can count
+ *     hits, misses and evictions without going through csim-ref.
+ */
+
+#ifndef CACHELAB_CACHESIM_H
+#define CACHELAB_CACHESIM_H
+
+typedef struct {
+    int s, E, b;                 /* cache geometry, as for csim */
+    unsigned long long* tags;    /* 2^s sets of E tags, valid bit in bit 0 */
+    unsigned long long* stamps;  /* LRU time stamp per line */
+    unsigned long long timer;
+    unsigned int hits;
+    unsigned int misses;
+    unsigned int evictions;
+} cache_sim_t;
+
+/* Allocate an empty cache with 2^s sets of E lines of 2^b bytes */
+cache_sim_t* cache_sim_create(int s, int E, int b);
+
+/* Invalidate every line and zero the counters */
+void cache_sim_reset(cache_sim_t* c);
+
+/* Simulate one access to addr */
+void cache_sim_access(cache_sim_t* c, unsigned long long addr);
+
+void cache_sim_free(cache_sim_t* c);
+
+#endif /* CACHELAB_CACHESIM_H */
@@ -2,7 +2,9 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <string.h>
 #include "cachelab.h"
+#include "tracefmt.h"
 
 int s = 0, E = 0, b = 0;
 char* trace_file = NULL;
@@ -21,46 +23,109 @@ typedef struct {
 } CacheSet;
 
 typedef struct {
+    int s, E;
     CacheSet* sets;
 } Cache;
 
 Cache cache;
 
-void allocateCache() {
-    int S = (1 << s);
-    cache.sets = (CacheSet*)malloc(sizeof(CacheSet) * S);
+/* Result of a lookup in a Cache */
+#define LOOKUP_HIT   0
+#define LOOKUP_MISS  1
+#define LOOKUP_EVICT 2
+
+/*
+ * TLB model: up to two levels of set-associative TLBs in front of a
+ * page walker. Each level is a Cache keyed by the virtual page number.
+ */
+#define MAX_TLB_LEVELS 2
+#define VADDR_BITS 48      /* x86-64 virtual address width */
+#define PT_INDEX_BITS 9    /* bits translated per page-table level */
+#define HUGE_PAGE_BITS 21  /* 2 MB huge pages */
+
+typedef struct {
+    int entries, ways;
+    Cache c;
+    int hits, misses;
+} TlbLevel;
+
+typedef struct {
+    int page_bits;
+    int nlevels;
+    TlbLevel level[MAX_TLB_LEVELS];
+    int accesses, walks;
+    unsigned long long walk_cycles;
+} Tlb;
+
+char* tlb_spec = NULL;
+int page_bits = 12;
+int walk_latency = 20;   /* cycles per page-table level */
+int huge_compare = 0;
+Tlb tlb, huge_tlb;
+
+/*
+ * Miss attribution: counters aggregated per key (instruction address,
+ * cache line or page) in an open-addressing hash table.
+ */
+typedef struct {
+    unsigned long long key;
+    int used;
+    int accesses, misses, evictions;
+} AttrEntry;
+
+typedef struct {
+    AttrEntry* entries;
+    unsigned long long mask;  /* capacity - 1, capacity is a power of 2 */
+    unsigned long long count;
+} AttrTable;
+
+int top_n = 0;                  /* -A: report the top_n entries, 0 disables */
+unsigned long long cur_iaddr = 0;
+int have_iaddr = 0;
+AttrTable by_instr, by_line, by_page;
+AttrEntry no_iaddr;             /* accesses before any I record */
+int* set_misses = NULL;
+int* set_evictions = NULL;
+
+void allocateCache(Cache* c, int sbits, int ways) {
+    int S = (1 << sbits);
+    c->s = sbits;
+    c->E = ways;
+    c->sets = (CacheSet*)malloc(sizeof(CacheSet) * S);
     for (int i = 0; i < S; i++) {
-        cache.sets[i].lines = (CacheLine*)malloc(sizeof(CacheLine) * E);
-        for (int j = 0; j < E; j++) {
-            cache.sets[i].lines[j].valid = 0;
-            cache.sets[i].lines[j].tag = 0;
-            cache.sets[i].lines[j].last_access = 0;
+        c->sets[i].lines = (CacheLine*)malloc(sizeof(CacheLine) * ways);
+        for (int j = 0; j < ways; j++) {
+            c->sets[i].lines[j].valid = 0;
+            c->sets[i].lines[j].tag = 0;
+            c->sets[i].lines[j].last_access = 0;
         }
     }
 }
 
-void freeCache() {
-    int S = (1 << s);
-    for (int i = 0; i < S; i++) free(cache.sets[i].lines);
-    free(cache.sets);
+void freeCache(Cache* c) {
+    int S = (1 << c->s);
+    for (int i = 0; i < S; i++) free(c->sets[i].lines);
+    free(c->sets);
 }
 
-void accessCache(unsigned long long address) {
-    unsigned long long set_index = (address >> b) & ((1 << s) - 1);
-    unsigned long long tag = address >> (s + b);
-    CacheSet* set = &cache.sets[set_index];
+/*
+ * lookupCache - Look up key (a block or page number) in c with LRU
+ * replacement, filling the line on a miss.
+ */
+int lookupCache(Cache* c, unsigned long long key) {
+    unsigned long long set_index = key & ((1ULL << c->s) - 1);
+    unsigned long long tag = key >> c->s;
+    CacheSet* set = &c->sets[set_index];
 
     global_timer++;
     int empty = -1, lru = 0;
     unsigned int min_time = -1;
 
-    for (int i = 0; i < E; i++) {
+    for (int i = 0; i < c->E; i++) {
         if (set->lines[i].valid) {
             if (set->lines[i].tag == tag) { // Hit
-                hit_count++;
                 set->lines[i].last_access = global_timer;
-                if (verbose) printf(" hit");
-                return;
+                return LOOKUP_HIT;
             }
             if (set->lines[i].last_access < min_time) { // LRU ã
                 min_time = set->lines[i].last_access;
@@ -72,22 +137,269 @@ void accessCache(unsigned long long address) {
         }
     }
 
+    int target = (empty != -1) ? empty : lru;
+    set->lines[target].valid = 1;
+    set->lines[target].tag = tag;
+    set->lines[target].last_access = global_timer;
+    return (empty != -1) ? LOOKUP_MISS : LOOKUP_EVICT;
+}
+
+int accessCache(unsigned long long address) {
+    int result = lookupCache(&cache, address >> b);
+
+    if (result == LOOKUP_HIT) {
+        hit_count++;
+        if (verbose) printf(" hit");
+        return result;
+    }
     miss_count++; // Miss
     if (verbose) printf(" miss");
-
-    int target = (empty != -1) ? empty : lru;
-    if (empty == -1) {
+    if (result == LOOKUP_EVICT) {
         eviction_count++; // Eviction
         if (verbose) printf(" eviction");
     }
+    return result;
+}
 
-    set->lines[target].valid = 1;
-    set->lines[target].tag = tag;
-    set->lines[target].last_access = global_timer;
+void initAttrTable(AttrTable* t) {
+    t->mask = 1023;
+    t->count = 0;
+    t->entries = (AttrEntry*)calloc(t->mask + 1, sizeof(AttrEntry));
+}
+
+/* findAttr - Return the entry for key, inserting it if needed */
+AttrEntry* findAttr(AttrTable* t, unsigned long long key) {
+    unsigned long long i = (key * 0x9E3779B97F4A7C15ULL) >> 20;
+
+    if (2 * (t->count + 1) > t->mask + 1) { // keep load factor below 1/2
+        AttrEntry* old = t->entries;
+        unsigned long long old_size = t->mask + 1;
+
+        t->mask = 2 * old_size - 1;
+        t->count = 0;
+        t->entries = (AttrEntry*)calloc(t->mask + 1, sizeof(AttrEntry));
+        for (unsigned long long j = 0; j < old_size; j++) {
+            if (old[j].used) *findAttr(t, old[j].key) = old[j];
+        }
+        free(old);
+    }
+    for (i &= t->mask; t->entries[i].used; i = (i + 1) & t->mask) {
+        if (t->entries[i].key == key) return &t->entries[i];
+    }
+    t->entries[i].used = 1;
+    t->entries[i].key = key;
+    t->count++;
+    return &t->entries[i];
+}
+
+void countEntry(AttrEntry* e, int result) {
+    e->accesses++;
+    if (result != LOOKUP_HIT) e->misses++;
+    if (result == LOOKUP_EVICT) e->evictions++;
+}
+
+void countAttr(AttrTable* t, unsigned long long key, int result) {
+    countEntry(findAttr(t, key), result);
+}
+
+void attributeAccess(unsigned long long address, int result) {
+    unsigned long long block = address >> b;
+
+    if (have_iaddr) countAttr(&by_instr, cur_iaddr, result);
+    else countEntry(&no_iaddr, result);
+    countAttr(&by_line, block, result);
+    countAttr(&by_page, address >> page_bits, result);
+    if (result != LOOKUP_HIT) set_misses[block & ((1ULL << s) - 1)]++;
+    if (result == LOOKUP_EVICT) set_evictions[block & ((1ULL << s) - 1)]++;
+}
+
+int cmpAttrMisses(const void* x, const void* y) {
+    const AttrEntry* p = *(AttrEntry* const*)x;
+    const AttrEntry* q = *(AttrEntry* const*)y;
+    if (p->misses != q->misses) return (p->misses < q->misses) ? 1 : -1;
+    if (p->key != q->key) return (p->key > q->key) ? 1 : -1;
+    return 0;
+}
+
+/*
+ * printTopMisses - Print the n entries of t, and extra if not NULL,
+ * with the most misses. The key is shifted left by key_shift to turn
+ * it back into an address; extra has no address.
+ */
+void printTopMisses(AttrTable* t, AttrEntry* extra, char* title, int key_shift, int n) {
+    AttrEntry** sorted = (AttrEntry**)malloc(sizeof(AttrEntry*) * (t->count + 1));
+    unsigned long long k = 0;
+
+    for (unsigned long long i = 0; i <= t->mask; i++) {
+        if (t->entries[i].used && t->entries[i].misses) sorted[k++] = &t->entries[i];
+    }
+    if (extra && extra->misses) sorted[k++] = extra;
+    qsort(sorted, k, sizeof(AttrEntry*), cmpAttrMisses);
+
+    printf("\nTop %d %s by misses:\n", n, title);
+    printf("  %-18s %10s %10s %10s %8s\n", "address", "accesses", "misses", "evictions", "miss%");
+    for (unsigned long long i = 0; i < k && i < (unsigned long long)n; i++) {
+        AttrEntry* e = sorted[i];
+        if (e == &no_iaddr)
+            printf("  %-18s", "(no I record)");
+        else
+            printf("  0x%-16llx", e->key << key_shift);
+        printf(" %10d %10d %10d %7.2f%%\n", e->accesses, e->misses, e->evictions,
+               100.0 * e->misses / e->accesses);
+    }
+    free(sorted);
+}
+
+/*
+ * printSetHeatmap - Print misses per set as a grid, 64 sets per row,
+ * shaded by the share of the hottest set's evictions (conflict misses).
+ */
+void printSetHeatmap() {
+    static const char shades[] = " .:-=+*#%@";
+    int S = 1 << s, max_evict = 0, hot = 0;
+
+    for (int i = 0; i < S; i++) {
+        if (set_evictions[i] > max_evict) {
+            max_evict = set_evictions[i];
+            hot = i;
+        }
+    }
+    printf("\nPer-set conflict heatmap (evictions, '@' = %d in set %d):\n", max_evict, hot);
+    for (int row = 0; row < S; row += 64) {
+        printf("  %6d |", row);
+        for (int i = row; i < row + 64 && i < S; i++) {
+            int level = max_evict ? (set_evictions[i] * 9 + max_evict - 1) / max_evict : 0;
+            putchar(shades[level]);
+        }
+        printf("|\n");
+    }
+    printf("  %6s %10s %10s\n", "set", "misses", "evictions");
+    for (int i = 0; i < S; i++) {
+        if (max_evict && set_evictions[i] * 2 >= max_evict)
+            printf("  %6d %10d %10d\n", i, set_misses[i], set_evictions[i]);
+    }
+}
+
+void printAttribution() {
+    printTopMisses(&by_instr, &no_iaddr, "instructions", 0, top_n);
+    printTopMisses(&by_line, NULL, "cache lines", b, top_n);
+    printTopMisses(&by_page, NULL, "pages", page_bits, top_n);
+    printSetHeatmap();
+}
+
+/*
+ * walkLevels - Number of page-table levels walked to translate a page
+ * of 2^pbits bytes (4 for 4 KB pages, 3 for 2 MB, 2 for 1 GB).
+ */
+int walkLevels(int pbits) {
+    return (VADDR_BITS - pbits + PT_INDEX_BITS - 1) / PT_INDEX_BITS;
+}
+
+/*
+ * parseTlbSpec - Parse "entries[:ways][,entries[:ways]]" into the
+ * levels of t. Omitting ways makes a level fully associative.
+ * Returns 0 if the spec is malformed.
+ */
+int parseTlbSpec(Tlb* t, char* spec, int pbits) {
+    char* p = spec;
+
+    memset(t, 0, sizeof(Tlb));
+    t->page_bits = pbits;
+    while (*p) {
+        TlbLevel* lv;
+        int sets, sbits = 0;
+
+        if (t->nlevels == MAX_TLB_LEVELS) return 0;
+        lv = &t->level[t->nlevels];
+        lv->entries = (int)strtol(p, &p, 10);
+        lv->ways = lv->entries;
+        if (*p == ':') lv->ways = (int)strtol(p + 1, &p, 10);
+        if (*p == ',') p++;
+        else if (*p) return 0;
+
+        if (lv->entries <= 0 || lv->ways <= 0 || lv->entries % lv->ways) return 0;
+        sets = lv->entries / lv->ways;
+        while ((1 << sbits) < sets) sbits++;
+        if ((1 << sbits) != sets) return 0; // set count must be a power of 2
+        allocateCache(&lv->c, sbits, lv->ways);
+        t->nlevels++;
+    }
+    return t->nlevels > 0;
+}
+
+void freeTlb(Tlb* t) {
+    for (int i = 0; i < t->nlevels; i++) freeCache(&t->level[i].c);
+}
+
+/*
+ * accessTlb - Translate address through the TLB hierarchy. Returns the
+ * level that hit, or nlevels if the translation needed a page walk.
+ * A walk fills every level on the way back.
+ */
+int accessTlb(Tlb* t, unsigned long long address) {
+    unsigned long long vpn = address >> t->page_bits;
+    int i;
+
+    t->accesses++;
+    for (i = 0; i < t->nlevels; i++) {
+        if (lookupCache(&t->level[i].c, vpn) == LOOKUP_HIT) {
+            t->level[i].hits++;
+            break;
+        }
+        t->level[i].misses++;
+    }
+    if (i == t->nlevels) {
+        t->walks++;
+        t->walk_cycles += (unsigned long long)walkLevels(t->page_bits) * walk_latency;
+    }
+    return i;
+}
+
+void accessMemory(unsigned long long address) {
+    int result = accessCache(address);
+
+    if (top_n) attributeAccess(address, result);
+    if (tlb.nlevels) {
+        int level = accessTlb(&tlb, address);
+        if (verbose) {
+            if (level == 0) printf(" tlb-hit");
+            else if (level < tlb.nlevels) printf(" tlb-miss stlb-hit");
+            else printf(" tlb-miss walk");
+        }
+        if (huge_compare) accessTlb(&huge_tlb, address);
+    }
+}
+
+void printTlbStats(Tlb* t) {
+    double hit_rate = t->accesses ? 100.0 * (t->accesses - t->walks) / t->accesses : 0.0;
+
+    /* misses: first-level misses; walks: misses in every level */
+    printf("tlb page:%lluKB hits:%d misses:%d walks:%d hit-rate:%.2f%% walk-cycles:%llu\n",
+           1ULL << (t->page_bits - 10), t->accesses - t->walks, t->level[0].misses,
+           t->walks, hit_rate, t->walk_cycles);
+    for (int i = 0; i < t->nlevels; i++) {
+        TlbLevel* lv = &t->level[i];
+        int looked_up = lv->hits + lv->misses;
+        printf("  L%d %d entries %d-way: hits:%d misses:%d hit-rate:%.2f%%\n",
+               i + 1, lv->entries, lv->ways, lv->hits, lv->misses,
+               looked_up ? 100.0 * lv->hits / looked_up : 0.0);
+    }
+}
+
+void printTlbSummary() {
+    printTlbStats(&tlb);
+    if (!huge_compare) return;
+    printTlbStats(&huge_tlb);
+    if (tlb.accesses) {
+        long long saved = (long long)tlb.walk_cycles - (long long)huge_tlb.walk_cycles;
+        printf("huge pages save %lld walk cycles (%.3f per access)\n",
+               saved, (double)saved / tlb.accesses);
+    }
 }
 
 void help() {
-    printf("Usage: ./csim [-hv] -s <num> -E <num> -b <num> -t <file>\n");
+    printf("Usage: ./csim [-hvH] -s <num> -E <num> -b <num> -t <file>\n");
+    printf("              [-T <tlb>] [-P <num>] [-w <num>] [-A <num>]\n");
     printf("Options:\n");
     printf("  -h         Print this help message.\n");
     printf("  -v         Optional verbose flag.\n");
@@ -95,15 +407,21 @@ void help() {
     printf("  -E <num>   Number of lines per set.\n");
     printf("  -b <num>   Number of block offset bits.\n");
     printf("  -t <file>  Trace file.\n");
+    printf("  -T <tlb>   Simulate a TLB: entries[:ways][,entries[:ways]] per level.\n");
+    printf("  -P <num>   Number of page offset bits (default 12, 21 for 2MB pages).\n");
+    printf("  -w <num>   Page walk cycles per page-table level (default 20).\n");
+    printf("  -H         With -T, also simulate the TLB with 2MB huge pages.\n");
+    printf("  -A <num>   Attribute misses to instructions, lines and sets; show top <num>.\n");
     printf("\n");
     printf("Examples:\n");
     printf("  linux>  ./csim -s 4 -E 1 -b 4 -t traces/yi.trace\n");
     printf("  linux>  ./csim -v -s 8 -E 2 -b 4 -t traces/yi.trace\n");
+    printf("  linux>  ./csim -s 6 -E 8 -b 6 -T 64:4,1536:12 -H -t traces/long.trace\n");
 }
 
 int main(int argc, char* argv[]) {
     char opt;
-    while ((opt = getopt(argc, argv, "hvs:E:b:t:")) != -1) {
+    while ((opt = getopt(argc, argv, "hvs:E:b:t:T:P:w:HA:")) != -1) {
         switch (opt) {
         case 'h': help(); exit(1); break;
         case 'v': verbose = 1; break;
@@ -111,6 +429,17 @@ int main(int argc, char* argv[]) {
         case 'E': E = atoi(optarg); break;
         case 'b': b = atoi(optarg); break;
         case 't': trace_file = optarg; break;
+        case 'T': tlb_spec = optarg; break;
+        case 'P': page_bits = atoi(optarg); break;
+        case 'w': walk_latency = atoi(optarg); break;
+        case 'H': huge_compare = 1; break;
+        case 'A':
+            top_n = atoi(optarg);
+            if (top_n < 1) {
+                printf("Invalid -A value: %s\n", optarg);
+                exit(1);
+            }
+            break;
         default: exit(1); // ߸   ׳ 
         }
     }
@@ -120,27 +449,67 @@ int main(int argc, char* argv[]) {
         exit(1);
     }
 
-    allocateCache();
+    if (huge_compare && !tlb_spec) {
+        help(); // -H compares TLBs, so it needs -T
+        exit(1);
+    }
+
+    if ((tlb_spec || top_n) && (page_bits < 10 || page_bits >= VADDR_BITS)) {
+        printf("Invalid -P value: %d (10 to %d)\n", page_bits, VADDR_BITS - 1);
+        exit(1);
+    }
 
-    FILE* pFile = fopen(trace_file, "r");
-    if (!pFile) return 1;
+    if (tlb_spec) {
+        if (!parseTlbSpec(&tlb, tlb_spec, page_bits) ||
+            !parseTlbSpec(&huge_tlb, tlb_spec, HUGE_PAGE_BITS)) {
+            printf("Invalid TLB configuration\n");
+            exit(1);
+        }
+    }
 
-    char op;
-    unsigned long long addr;
-    int size;
+    allocateCache(&cache, s, E);
+    if (top_n) {
+        initAttrTable(&by_instr);
+        initAttrTable(&by_line);
+        initAttrTable(&by_page);
+        set_misses = (int*)calloc(1 << s, sizeof(int));
+        set_evictions = (int*)calloc(1 << s, sizeof(int));
+    }
 
-    while (fscanf(pFile, " %c %llx,%d", &op, &addr, &size) > 0) {
-        if (op == 'I') continue;
+    trace_reader_t* trace = trace_open(trace_file); // text or tracepack binary
+    if (!trace) return 1;
+
+    trace_rec_t rec;
+    int rc;
+
+    while ((rc = trace_next(trace, &rec)) > 0) {
+        char op = rec.op;
+        unsigned long long addr = rec.addr;
+        int size = rec.size;
+
+        if (op == 'I') { // remember the instruction for attribution
+            cur_iaddr = addr;
+            have_iaddr = 1;
+            continue;
+        }
         if (verbose) printf("%c %llx,%d", op, addr, size);
 
-        accessCache(addr);
-        if (op == 'M') accessCache(addr); // M    
+        accessMemory(addr);
+        if (op == 'M') accessMemory(addr); // M    
 
         if (verbose) printf("\n");
     }
 
-    fclose(pFile);
-    freeCache();
+    trace_close(trace);
+    if (rc < 0) {
+        printf("Malformed trace file\n");
+        exit(1);
+    }
+    freeCache(&cache);
     printSummary(hit_count, miss_count, eviction_count);
+    if (tlb.nlevels) printTlbSummary();
+    if (top_n) printAttribution();
+    freeTlb(&tlb);
+    freeTlb(&huge_tlb);
     return 0;
 }
\ No newline at end of file
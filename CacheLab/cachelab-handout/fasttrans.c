@@ -0,0 +1,756 @@
+/*
+ * fasttrans.c - Native-speed matrix transpose
+ *
+ * The outer loop walks FT_BLOCK x FT_BLOCK blocks of A so that the
+ * rows of B a block writes stay in L1/L2, and each block is covered by
+ * 8x8 tiles transposed entirely in registers: 32-bit unpacks, then
+ * 64-bit unpacks, then (AVX2) a 128-bit lane permute. Ragged edges are
+ * transposed with scalar code.
+ *
+ * The parallel entry points hand each thread of a small persistent pool
+ * one contiguous slab of B, so a thread's writes stay in its own pages
+ * and, once B has been first-touched with the same split (see
+ * fasttrans_first_touch), on its own NUMA node. Workers are pinned to
+ * successive CPUs for that reason.
+ */
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <immintrin.h>
+#include "fasttrans.h"
+
+/* Transpose the 8x8 tile at a into b */
+typedef void (*tile_fn)(const int* a, size_t lda, int* b, size_t ldb);
+
+static int cur_isa = FT_ISA_AUTO;
+static tile_fn cur_tile = NULL;
+
+static const char* isa_names[FT_NISAS] = { "auto", "scalar", "sse2", "avx2" };
+
+/*
+ * tile_scalar - Portable 8x8 tile
+ */
+static void tile_scalar(const int* a, size_t lda, int* b, size_t ldb)
+{
+    int r, c;
+
+    for (r = 0; r < 8; r++)
+        for (c = 0; c < 8; c++)
+            b[c * ldb + r] = a[r * lda + c];
+}
+
+/*
+ * tile_sse2 - 8x8 tile as four 4x4 in-register transposes
+ */
+__attribute__((target("sse2")))
+static void tile_sse2(const int* a, size_t lda, int* b, size_t ldb)
+{
+    int qr, qc;
+
+    for (qr = 0; qr < 8; qr += 4) {
+        for (qc = 0; qc < 8; qc += 4) {
+            const int* src = a + qr * lda + qc;
+            int* dst = b + qc * ldb + qr;
+            __m128i r0 = _mm_loadu_si128((const __m128i*)(src));
+            __m128i r1 = _mm_loadu_si128((const __m128i*)(src + lda));
+            __m128i r2 = _mm_loadu_si128((const __m128i*)(src + 2 * lda));
+            __m128i r3 = _mm_loadu_si128((const __m128i*)(src + 3 * lda));
+            __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+            __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+            __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+            __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+
+            r0 = _mm_unpacklo_epi64(t0, t1);
+            r1 = _mm_unpackhi_epi64(t0, t1);
+            r2 = _mm_unpacklo_epi64(t2, t3);
+            r3 = _mm_unpackhi_epi64(t2, t3);
+            _mm_storeu_si128((__m128i*)(dst), r0);
+            _mm_storeu_si128((__m128i*)(dst + ldb), r1);
+            _mm_storeu_si128((__m128i*)(dst + 2 * ldb), r2);
+            _mm_storeu_si128((__m128i*)(dst + 3 * ldb), r3);
+        }
+    }
+}
+
+/*
+ * transpose8_avx2 - Transpose eight rows of eight ints in place
+ */
+__attribute__((target("avx2")))
+static inline void transpose8_avx2(__m256i r[8])
+{
+    __m256i t0, t1, t2, t3, t4, t5, t6, t7;
+
+    /* Interleave pairs of rows: 2x2 blocks of 32-bit elements */
+    t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+    t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+    t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+    t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+    t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+    t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+    t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+    t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+
+    /* 4x4 blocks within each 128-bit lane */
+    r[0] = _mm256_unpacklo_epi64(t0, t2);
+    r[1] = _mm256_unpackhi_epi64(t0, t2);
+    r[2] = _mm256_unpacklo_epi64(t1, t3);
+    r[3] = _mm256_unpackhi_epi64(t1, t3);
+    r[4] = _mm256_unpacklo_epi64(t4, t6);
+    r[5] = _mm256_unpackhi_epi64(t4, t6);
+    r[6] = _mm256_unpacklo_epi64(t5, t7);
+    r[7] = _mm256_unpackhi_epi64(t5, t7);
+
+    /* Swap the off-diagonal 4x4 blocks across lanes */
+    t0 = _mm256_permute2x128_si256(r[0], r[4], 0x20);
+    t1 = _mm256_permute2x128_si256(r[1], r[5], 0x20);
+    t2 = _mm256_permute2x128_si256(r[2], r[6], 0x20);
+    t3 = _mm256_permute2x128_si256(r[3], r[7], 0x20);
+    t4 = _mm256_permute2x128_si256(r[0], r[4], 0x31);
+    t5 = _mm256_permute2x128_si256(r[1], r[5], 0x31);
+    t6 = _mm256_permute2x128_si256(r[2], r[6], 0x31);
+    t7 = _mm256_permute2x128_si256(r[3], r[7], 0x31);
+    r[0] = t0; r[1] = t1; r[2] = t2; r[3] = t3;
+    r[4] = t4; r[5] = t5; r[6] = t6; r[7] = t7;
+}
+
+/*
+ * tile_avx2 - 8x8 tile in eight ymm registers
+ */
+__attribute__((target("avx2")))
+static void tile_avx2(const int* a, size_t lda, int* b, size_t ldb)
+{
+    __m256i r[8];
+    int k;
+
+    for (k = 0; k < 8; k++)
+        r[k] = _mm256_loadu_si256((const __m256i*)(a + k * lda));
+    transpose8_avx2(r);
+    for (k = 0; k < 8; k++)
+        _mm256_storeu_si256((__m256i*)(b + k * ldb), r[k]);
+}
+
+/*
+ * tile16_avx2_stream - 16 rows by 8 columns of A, so that each of the
+ *     eight rows of B it writes is one whole 64-byte line. Both halves
+ *     of a line are streamed back to back and fill one write-combining
+ *     buffer; streaming half lines would cost a read-for-ownership each.
+ */
+__attribute__((target("avx2")))
+static void tile16_avx2_stream(const int* a, size_t lda, int* b, size_t ldb)
+{
+    __m256i lo[8], hi[8];
+    int k;
+
+    for (k = 0; k < 8; k++) {
+        lo[k] = _mm256_loadu_si256((const __m256i*)(a + k * lda));
+        hi[k] = _mm256_loadu_si256((const __m256i*)(a + (k + 8) * lda));
+    }
+    transpose8_avx2(lo);
+    transpose8_avx2(hi);
+    for (k = 0; k < 8; k++) {
+        _mm256_stream_si256((__m256i*)(b + k * ldb), lo[k]);
+        _mm256_stream_si256((__m256i*)(b + k * ldb + 8), hi[k]);
+    }
+}
+
+int fasttrans_isa_supported(int isa)
+{
+    __builtin_cpu_init();
+    switch (isa) {
+    case FT_ISA_AUTO:
+    case FT_ISA_SCALAR:
+        return 1;
+    case FT_ISA_SSE2:
+        return __builtin_cpu_supports("sse2");
+    case FT_ISA_AVX2:
+        return __builtin_cpu_supports("avx2");
+    default:
+        return 0;
+    }
+}
+
+int fasttrans_set_isa(int isa)
+{
+    if (!fasttrans_isa_supported(isa))
+        return 0;
+    if (isa == FT_ISA_AUTO) {
+        isa = FT_ISA_SCALAR;
+        if (fasttrans_isa_supported(FT_ISA_SSE2))
+            isa = FT_ISA_SSE2;
+        if (fasttrans_isa_supported(FT_ISA_AVX2))
+            isa = FT_ISA_AVX2;
+    }
+    cur_isa = isa;
+    cur_tile = (isa == FT_ISA_AVX2) ? tile_avx2 :
+               (isa == FT_ISA_SSE2) ? tile_sse2 : tile_scalar;
+    return 1;
+}
+
+int fasttrans_isa(void)
+{
+    if (cur_isa == FT_ISA_AUTO)
+        fasttrans_set_isa(FT_ISA_AUTO);
+    return cur_isa;
+}
+
+const char* fasttrans_isa_name(int isa)
+{
+    return (isa >= 0 && isa < FT_NISAS) ? isa_names[isa] : "unknown";
+}
+
+/*
+ * trans_region - Transpose rows [i0, i1) and columns [j0, j1) of A:
+ *     whole tiles with the selected kernel, edges with scalar code
+ */
+static void trans_region(int M, int N, const int* A, int* B,
+                         int i0, int i1, int j0, int j1, int stream)
+{
+    int i, j, ti1 = i0 + ((i1 - i0) & ~7), tj1 = j0 + ((j1 - j0) & ~7);
+
+    for (i = i0; i < ti1; ) {
+        if (stream && i + 16 <= ti1) {
+            for (j = j0; j < tj1; j += 8)
+                tile16_avx2_stream(A + (size_t)i * M + j, M, B + (size_t)j * N + i, N);
+            i += 16;
+        }
+        else {
+            for (j = j0; j < tj1; j += 8)
+                cur_tile(A + (size_t)i * M + j, M, B + (size_t)j * N + i, N);
+            i += 8;
+        }
+    }
+
+    for (i = i0; i < i1; i++)
+        for (j = (i < ti1) ? tj1 : j0; j < j1; j++)
+            B[(size_t)j * N + i] = A[(size_t)i * M + j];
+}
+
+/*
+ * stream_ok - Non-temporal stores pay off once B no longer fits in the
+ *     last-level cache. They are only used with AVX2, where a 16-row
+ *     strip fills whole lines, so every row of B must be line aligned.
+ */
+static int stream_ok(int M, int N, const int* B)
+{
+    if (cur_isa != FT_ISA_AVX2)
+        return 0;
+    if ((size_t)M * N * sizeof(int) < FT_STREAM_BYTES)
+        return 0;
+    return ((uintptr_t)B % 64) == 0 && (N * sizeof(int)) % 64 == 0;
+}
+
+/*
+ * trans_cols - Transpose columns [j0, j1) of A, i.e. rows [j0, j1) of B,
+ *     block by block
+ */
+static void trans_cols(int M, int N, const int* A, int* B, int j0, int j1, int stream)
+{
+    int i, j;
+
+    for (i = 0; i < N; i += FT_BLOCK)
+        for (j = j0; j < j1; j += FT_BLOCK)
+            trans_region(M, N, A, B, i, (i + FT_BLOCK < N) ? i + FT_BLOCK : N,
+                         j, (j + FT_BLOCK < j1) ? j + FT_BLOCK : j1, stream);
+    if (stream)
+        _mm_sfence();
+}
+
+/*
+ * fasttrans - B = A^T with blocked, SIMD 8x8 tiles
+ */
+void fasttrans(int M, int N, const int* A, int* B)
+{
+    fasttrans_isa();
+    trans_cols(M, N, A, B, 0, M, stream_ok(M, N, B));
+}
+
+/*
+ * swap_tiles - Exchange the 8x8 tiles x and y of a matrix with row
+ *     stride ld, transposing both. x == y transposes a diagonal tile.
+ */
+static void swap_tiles(int* x, int* y, size_t ld)
+{
+    int tx[64] __attribute__((aligned(32)));
+    int ty[64] __attribute__((aligned(32)));
+    int r;
+
+    cur_tile(x, ld, tx, 8);
+    cur_tile(y, ld, ty, 8);
+    for (r = 0; r < 8; r++) {
+        memcpy(y + r * ld, tx + r * 8, 8 * sizeof(int));
+        memcpy(x + r * ld, ty + r * 8, 8 * sizeof(int));
+    }
+}
+
+/*
+ * swap_blocks - Exchange block (bi, bj) of the square matrix A with
+ *     block (bj, bi), transposing both; bi == bj transposes a diagonal
+ *     block. Blocks are FT_BLOCK on a side except at the right and
+ *     bottom edges.
+ */
+static void swap_blocks(int N, int* A, int bi, int bj)
+{
+    int i0 = bi * FT_BLOCK, j0 = bj * FT_BLOCK;
+    int i1 = (i0 + FT_BLOCK < N) ? i0 + FT_BLOCK : N;
+    int j1 = (j0 + FT_BLOCK < N) ? j0 + FT_BLOCK : N;
+    int ti1 = i0 + ((i1 - i0) & ~7), tj1 = j0 + ((j1 - j0) & ~7);
+    int i, j, t;
+
+    for (i = i0; i < ti1; i += 8)
+        for (j = (bi == bj) ? i : j0; j < tj1; j += 8)
+            swap_tiles(A + (size_t)i * N + j, A + (size_t)j * N + i, N);
+
+    for (i = i0; i < i1; i++) {
+        for (j = (i < ti1) ? tj1 : j0; j < j1; j++) {
+            if (bi == bj && j <= i)
+                continue;
+            t = A[(size_t)i * N + j];
+            A[(size_t)i * N + j] = A[(size_t)j * N + i];
+            A[(size_t)j * N + i] = t;
+        }
+    }
+}
+
+/*
+ * square_pairs - Swap the block pairs (bi, bj), bi <= bj, numbered
+ *     [k0, k1) in row-major order of the upper triangle
+ */
+static void square_pairs(int N, int* A, long k0, long k1)
+{
+    int nb = (N + FT_BLOCK - 1) / FT_BLOCK, bi = 0, bj;
+    long k = 0;
+
+    while (bi < nb && k + (nb - bi) <= k0)
+        k += nb - bi++;
+    for (bj = bi + (int)(k0 - k), k = k0; k < k1; k++) {
+        swap_blocks(N, A, bi, bj);
+        if (++bj == nb)
+            bj = ++bi;
+    }
+}
+
+void fasttrans_square_inplace(int N, int* A)
+{
+    int nb = (N + FT_BLOCK - 1) / FT_BLOCK;
+
+    fasttrans_isa();
+    square_pairs(N, A, 0, (long)nb * (nb + 1) / 2);
+}
+
+/*
+ * In-place transpose of a rectangular N x M matrix in three passes over
+ * chunks of b x b ints, where b divides both M and N:
+ *
+ *   1. Each strip of b rows is copied out and written back as M/b
+ *      contiguous chunks, each holding one tile of A already transposed.
+ *   2. The chunks, an (N/b) x (M/b) matrix of b*b-int elements, are
+ *      transposed by following the cycles of the permutation.
+ *   3. Each strip of b rows of the result, now N/b chunks in a row, is
+ *      copied out and written back as b rows of N ints.
+ *
+ * Passes 1 and 3 need a strip of scratch, b * max(M, N) ints, and walk
+ * memory sequentially. Pass 2 moves whole chunks, so it touches b*b ints
+ * per random access instead of one. When gcd(M, N) = 1, b = 1 and only
+ * pass 2 runs; coprime shapes take the two-pass path below instead.
+ */
+
+/*
+ * chunk_side - Largest divisor of gcd(M, N) no bigger than FT_INPLACE_CHUNK
+ */
+static int chunk_side(int M, int N)
+{
+    int a = M, b = N, t;
+
+    while (b) {
+        t = a % b;
+        a = b;
+        b = t;
+    }
+    for (b = (a < FT_INPLACE_CHUNK) ? a : FT_INPLACE_CHUNK; a % b; b--)
+        ;
+    return b;
+}
+
+/*
+ * strip_to_chunks - Pass 1 for the strip of b rows at s: chunk jb gets
+ *     tile jb of the strip, transposed
+ */
+static void strip_to_chunks(int M, int b, int* s, int* scratch)
+{
+    int jb, r, c;
+
+    memcpy(scratch, s, (size_t)b * M * sizeof(int));
+    for (jb = 0; jb < M / b; jb++) {
+        const int* src = scratch + (size_t)jb * b;
+        int* dst = s + (size_t)jb * b * b;
+        if (b % 8 == 0) {
+            for (r = 0; r < b; r += 8)
+                for (c = 0; c < b; c += 8)
+                    cur_tile(src + (size_t)r * M + c, M, dst + (size_t)c * b + r, b);
+        }
+        else {
+            for (r = 0; r < b; r++)
+                for (c = 0; c < b; c++)
+                    dst[c * b + r] = src[(size_t)r * M + c];
+        }
+    }
+}
+
+/*
+ * chunks_to_strip - Pass 3 for the strip at s: N/b chunks of b rows of
+ *     b ints become b rows of N ints
+ */
+static void chunks_to_strip(int N, int b, int* s, int* scratch)
+{
+    int ib, r;
+
+    memcpy(scratch, s, (size_t)b * N * sizeof(int));
+    for (ib = 0; ib < N / b; ib++)
+        for (r = 0; r < b; r++)
+            memcpy(s + (size_t)r * N + (size_t)ib * b,
+                   scratch + ((size_t)ib * b + r) * b, b * sizeof(int));
+}
+
+/*
+ * is_leader - Without a bitmap, a cycle is moved from its smallest
+ *     position only. O(1) space, O(cycle length) time per position.
+ */
+static int is_leader(long p, long rows, long last)
+{
+    long q = (p * rows) % last;
+
+    while (q > p)
+        q = (q * rows) % last;
+    return q == p;
+}
+
+/*
+ * permute_chunks - Pass 2: transpose a rows x cols matrix of chunks of
+ *     len ints. The chunk at position p moves to p * rows mod (n - 1),
+ *     so the one that lands on p comes from p * cols mod (n - 1).
+ */
+static void permute_chunks(int* A, long rows, long cols, size_t len, int* tmp)
+{
+    long n = rows * cols, last = n - 1, start, p, src;
+    size_t bytes = len * sizeof(int);
+    unsigned char* done = (unsigned char*)calloc((n + 7) / 8, 1);
+
+    for (start = 1; start < last; start++) {
+        if (done ? (done[start >> 3] >> (start & 7)) & 1 : !is_leader(start, rows, last))
+            continue;
+        memcpy(tmp, A + start * len, bytes);
+        for (p = start; (src = (p * cols) % last) != start; p = src) {
+            memcpy(A + p * len, A + src * len, bytes);
+            if (done)
+                done[p >> 3] |= 1 << (p & 7);
+        }
+        memcpy(A + p * len, tmp, bytes);
+        if (done)
+            done[p >> 3] |= 1 << (p & 7);
+    }
+    free(done);
+}
+
+/*
+ * When gcd(M, N) = 1 the element at row r, column c of the N x M matrix
+ * belongs at linear position P = c*N + r. Its column there, P mod M, is
+ * (c*N + r) mod M, which for a fixed r is a permutation of the columns
+ * because N is invertible mod M. So the cycles of the transpose split
+ * into two passes that each stay inside one row or one column:
+ *
+ *   1. Each row r is permuted: column c goes to (c*N + r) mod M.
+ *   2. Each column q is permuted: the element in row r came from column
+ *      c = (q - r) / N mod M and goes to row (c*N + r) / M.
+ *
+ * Pass 1 works on one row at a time. Pass 2 gathers FT_INPLACE_COLS
+ * columns at once so that it reads and writes whole cache lines.
+ */
+
+/*
+ * inverse_mod - x with x * n = 1 mod m, for n coprime to m > 1
+ */
+static long inverse_mod(long n, long m)
+{
+    long a = n % m, b = m, x = 1, y = 0, q, t;
+
+    while (b) {
+        q = a / b;
+        t = a - q * b; a = b; b = t;
+        t = x - q * y; x = y; y = t;
+    }
+    return (x % m + m) % m;
+}
+
+/*
+ * coprime_rows - Pass 1: permute row r so column c moves to (c*N + r) mod M
+ */
+static void coprime_rows(int M, int N, int* A, int* tmp)
+{
+    int r, c, p, step = N % M;
+
+    for (r = 0; r < N; r++) {
+        int* row = A + (size_t)r * M;
+        for (c = 0, p = r % M; c < M; c++) {
+            tmp[p] = row[c];
+            p += step;
+            if (p >= M)
+                p -= M;
+        }
+        memcpy(row, tmp, (size_t)M * sizeof(int));
+    }
+}
+
+/*
+ * coprime_cols - Pass 2: move each element of columns [q0, q0 + w) to
+ *     its final row. Row r of column q holds the element from column c
+ *     with c*N + r = dest*M + q. Going down a row subtracts inv from c,
+ *     where inv*N = k*M + 1, so dest drops by k, plus N when c wraps.
+ */
+static void coprime_cols(int M, int N, int* A, int q0, int w, int* tmp)
+{
+    long inv = inverse_mod(N, M), k = (inv * N - 1) / M;
+    long dest[FT_INPLACE_COLS];
+    int r, q;
+
+    for (q = 0; q < w; q++)
+        dest[q] = ((q0 + q) * inv % M) * N / M;
+    for (r = 0; r < N; r++) {
+        const int* src = A + (size_t)r * M + q0;
+        for (q = 0; q < w; q++) {
+            tmp[dest[q] * w + q] = src[q];
+            dest[q] -= k;
+            if (dest[q] < 0)
+                dest[q] += N;
+        }
+    }
+    for (r = 0; r < N; r++)
+        memcpy(A + (size_t)r * M + q0, tmp + (size_t)r * w, (size_t)w * sizeof(int));
+}
+
+void fasttrans_inplace(int M, int N, int* A)
+{
+    int b, k, one, w;
+    int* scratch;
+
+    if (M == N) {
+        fasttrans_square_inplace(N, A);
+        return;
+    }
+    if (M == 1 || N == 1)
+        return; /* a vector is its own transpose in memory */
+    fasttrans_isa();
+    b = chunk_side(M, N);
+
+    /* Coprime shapes would leave pass 2 moving single ints to scattered
+       places; permute rows and then columns instead */
+    w = (M < FT_INPLACE_COLS) ? M : FT_INPLACE_COLS;
+    if (b == 1 && (scratch = (int*)malloc((size_t)((M > N * w) ? M : N * w) *
+                                          sizeof(int))) != NULL) {
+        coprime_rows(M, N, A, scratch);
+        for (k = 0; k < M; k += w)
+            coprime_cols(M, N, A, k, (M - k < w) ? M - k : w, scratch);
+        free(scratch);
+        return;
+    }
+    scratch = (b > 1) ? (int*)malloc((size_t)b * ((M > N) ? M : N) * sizeof(int)) : NULL;
+    if (!scratch) {
+        b = 1;
+        scratch = &one;
+    }
+
+    for (k = 0; k < N / b && b > 1; k++)
+        strip_to_chunks(M, b, A + (size_t)k * b * M, scratch);
+    permute_chunks(A, N / b, M / b, (size_t)b * b, scratch);
+    for (k = 0; k < M / b && b > 1; k++)
+        chunks_to_strip(N, b, A + (size_t)k * b * N, scratch);
+
+    if (scratch != &one)
+        free(scratch);
+}
+
+/*
+ * The thread pool. run_parallel() wakes nthreads - 1 workers, runs part
+ * 0 of the job itself and returns once every part has finished.
+ */
+typedef void (*job_fn)(int part, int nparts, void* arg);
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;         /* a new job is posted */
+    pthread_cond_t done;         /* the last worker finished its part */
+    pthread_t threads[FT_MAX_THREADS];
+    int nworkers;                /* threads started so far */
+    unsigned long gen;           /* job number */
+    job_fn fn;
+    void* arg;
+    int nparts;
+    int pending;                 /* workers still running this job */
+} pool = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER };
+
+/*
+ * pin_to_cpu - Bind the calling thread to the idx-th CPU it may run on
+ */
+static void pin_to_cpu(int idx)
+{
+    cpu_set_t allowed, one;
+    int cpu, seen = 0;
+
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || CPU_COUNT(&allowed) < 2)
+        return;
+    idx %= CPU_COUNT(&allowed);
+    for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &allowed) && seen++ == idx) {
+            CPU_ZERO(&one);
+            CPU_SET(cpu, &one);
+            pthread_setaffinity_np(pthread_self(), sizeof(one), &one);
+            return;
+        }
+    }
+}
+
+static void* worker(void* vargp)
+{
+    int part = (int)(intptr_t)vargp;
+    unsigned long seen = 0;
+
+    pin_to_cpu(part);
+    pthread_mutex_lock(&pool.lock);
+    for (;;) {
+        while (pool.gen == seen)
+            pthread_cond_wait(&pool.wake, &pool.lock);
+        seen = pool.gen;
+        if (part >= pool.nparts)
+            continue;
+        pthread_mutex_unlock(&pool.lock);
+        pool.fn(part, pool.nparts, pool.arg);
+        pthread_mutex_lock(&pool.lock);
+        if (--pool.pending == 0)
+            pthread_cond_signal(&pool.done);
+    }
+    return NULL;
+}
+
+/*
+ * run_parallel - Run fn on nparts parts. Falls back to fewer parts if
+ *     threads cannot be started.
+ */
+static void run_parallel(job_fn fn, void* arg, int nparts)
+{
+    static pthread_mutex_t serial = PTHREAD_MUTEX_INITIALIZER;
+
+    if (nparts > FT_MAX_THREADS)
+        nparts = FT_MAX_THREADS;
+    if (nparts <= 1) {
+        fn(0, 1, arg);
+        return;
+    }
+
+    pthread_mutex_lock(&serial);   /* one job at a time */
+    pthread_mutex_lock(&pool.lock);
+    while (pool.nworkers < nparts - 1) {
+        if (pthread_create(&pool.threads[pool.nworkers], NULL, worker,
+                           (void*)(intptr_t)(pool.nworkers + 1)) != 0)
+            break;
+        pthread_detach(pool.threads[pool.nworkers]);
+        pool.nworkers++;
+    }
+    if (nparts > pool.nworkers + 1)
+        nparts = pool.nworkers + 1;
+    pool.fn = fn;
+    pool.arg = arg;
+    pool.nparts = nparts;
+    pool.pending = nparts - 1;
+    pool.gen++;
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+
+    fn(0, nparts, arg);
+
+    pthread_mutex_lock(&pool.lock);
+    while (pool.pending > 0)
+        pthread_cond_wait(&pool.done, &pool.lock);
+    pthread_mutex_unlock(&pool.lock);
+    pthread_mutex_unlock(&serial);
+}
+
+typedef struct {
+    int M, N;
+    const int* A;
+    int* B;
+    int stream;
+} trans_job_t;
+
+/*
+ * split - Start of part p of n over [0, len), rounded down to a whole
+ *     number of tiles so that parts never share a tile
+ */
+static long split(long len, int p, int n, int unit)
+{
+    long start = len * p / n;
+    return (p == n) ? len : start - start % unit;
+}
+
+static void trans_part(int part, int nparts, void* arg)
+{
+    trans_job_t* job = (trans_job_t*)arg;
+
+    trans_cols(job->M, job->N, job->A, job->B,
+               (int)split(job->M, part, nparts, 8),
+               (int)split(job->M, part + 1, nparts, 8), job->stream);
+}
+
+void fasttrans_parallel(int M, int N, const int* A, int* B, int nthreads)
+{
+    trans_job_t job = { M, N, A, B, 0 };
+
+    fasttrans_isa();
+    job.stream = stream_ok(M, N, B);
+    if (nthreads > M / 8)
+        nthreads = M / 8;
+    run_parallel(trans_part, &job, nthreads);
+}
+
+static void touch_part(int part, int nparts, void* arg)
+{
+    trans_job_t* job = (trans_job_t*)arg;
+    long j0 = split(job->M, part, nparts, 8), j1 = split(job->M, part + 1, nparts, 8);
+
+    memset(job->B + j0 * job->N, 0, (size_t)(j1 - j0) * job->N * sizeof(int));
+}
+
+void fasttrans_first_touch(int M, int N, int* B, int nthreads)
+{
+    trans_job_t job = { M, N, NULL, B, 0 };
+
+    if (nthreads > M / 8)
+        nthreads = M / 8;
+    run_parallel(touch_part, &job, nthreads);
+}
+
+typedef struct {
+    int N;
+    int* A;
+    long npairs;
+} square_job_t;
+
+static void square_part(int part, int nparts, void* arg)
+{
+    square_job_t* job = (square_job_t*)arg;
+
+    square_pairs(job->N, job->A, split(job->npairs, part, nparts, 1),
+                 split(job->npairs, part + 1, nparts, 1));
+}
+
+void fasttrans_square_inplace_parallel(int N, int* A, int nthreads)
+{
+    int nb = (N + FT_BLOCK - 1) / FT_BLOCK;
+    square_job_t job = { N, A, (long)nb * (nb + 1) / 2 };
+
+    fasttrans_isa();
+    if (nthreads > job.npairs)
+        nthreads = (int)job.npairs;
+    run_parallel(square_part, &job, nthreads);
+}
@@ -0,0 +1,81 @@
+/*
+ * fasttrans.h - Native-speed matrix transpose
+ *
+ * Unlike the functions in trans.c, which are tuned for the simulated
+ * 1KB direct-mapped cache, these kernels are tuned for wall-clock speed
+ * on real x86-64 CPUs: 8x8 tiles are transposed in SIMD registers, tiles
+ * are grouped into cache-sized blocks, and large outputs are written
+ * with non-temporal stores. The instruction set is picked at run time.
+ *
+ * Matrices are dense and row-major: A has N rows of M ints and B gets
+ * M rows of N ints, as in trans.c.
+ */
+
+#ifndef CACHELAB_FASTTRANS_H
+#define CACHELAB_FASTTRANS_H
+
+#include <stddef.h>
+
+/* Kernel instruction sets */
+#define FT_ISA_AUTO   0    /* best one the CPU supports */
+#define FT_ISA_SCALAR 1
+#define FT_ISA_SSE2   2
+#define FT_ISA_AVX2   3
+#define FT_NISAS      4
+
+/* Side of the square blocks of A the outer loop walks, in ints. This and
+ * FT_STREAM_BYTES can be overridden with -D when tuning for another CPU */
+#ifndef FT_BLOCK
+#define FT_BLOCK 64
+#endif
+
+/* Outputs larger than this are written with non-temporal stores (AVX2) */
+#ifndef FT_STREAM_BYTES
+#define FT_STREAM_BYTES (8 << 20)
+#endif
+
+/* Most threads the parallel functions will use */
+#define FT_MAX_THREADS 256
+
+/* Largest side of the chunks fasttrans_inplace() moves as a unit */
+#define FT_INPLACE_CHUNK 32
+
+/* Columns fasttrans_inplace() permutes together on coprime shapes */
+#define FT_INPLACE_COLS 16
+
+/* Select the kernels. Returns 0 if the CPU does not support isa */
+int fasttrans_set_isa(int isa);
+
+/* The instruction set in use (never FT_ISA_AUTO) */
+int fasttrans_isa(void);
+
+/* Nonzero if the CPU supports isa */
+int fasttrans_isa_supported(int isa);
+
+const char* fasttrans_isa_name(int isa);
+
+/* B = A^T, where A is N x M and B is M x N */
+void fasttrans(int M, int N, const int* A, int* B);
+
+/* fasttrans() on up to nthreads threads; thread t writes the t-th
+   contiguous slab of rows of B */
+void fasttrans_parallel(int M, int N, const int* A, int* B, int nthreads);
+
+/* Zero B from the pool, each thread the slab fasttrans_parallel() gives
+   it, so that on a NUMA machine the first touch places every slab on
+   the node of the thread that writes it */
+void fasttrans_first_touch(int M, int N, int* B, int nthreads);
+
+/* A = A^T for an N x N matrix, by swapping mirrored blocks */
+void fasttrans_square_inplace(int N, int* A);
+void fasttrans_square_inplace_parallel(int N, int* A, int nthreads);
+
+/* A = A^T for an N x M matrix, which becomes M x N. Square matrices use
+   fasttrans_square_inplace(). Other shapes are moved in chunks with
+   O(sqrt(MN)) scratch when gcd(M, N) > 1. Coprime shapes such as 61x67
+   have no chunks; each row and then each column is permuted in place,
+   with M + FT_INPLACE_COLS * N ints of scratch. Only if that cannot be
+   allocated is the matrix permuted one int at a time */
+void fasttrans_inplace(int M, int N, int* A);
+
+#endif /* CACHELAB_FASTTRANS_H */
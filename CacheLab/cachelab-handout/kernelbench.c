@@ -0,0 +1,299 @@
+/*
+ * kernelbench.c - Evaluate registered memory-bound kernels
+ *
+ * For every kernel registered by kernels.c, kernelbench runs the
+ * instrumented build (kernels-sim.o) against the embedded cache model
+ * once per cache geometry, times the native build (kernels.o), checks
+ * that both builds and every kernel of a group agree on the outputs, and
+ * ranks the kernels of each group by misses and by run time.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <time.h>
+#include "cachelab.h"
+#include "cachesim.h"
+#include "traceinst.h"
+
+/* Most cache geometries on one command line */
+#define MAX_GEOMS 8
+
+/* Keep timing a kernel until at least this many seconds have passed */
+#define MIN_SECS 0.2
+
+typedef struct {
+    int s, E, b;
+} geom_t;
+
+typedef struct {
+    kernel_entry_t* k;
+    int n;
+    unsigned long long accesses;
+    unsigned int misses[MAX_GEOMS];
+    double secs;                 /* best native run, 0 if not timed */
+    unsigned long long checksum;
+    int ok;
+} result_t;
+
+static geom_t geoms[MAX_GEOMS];
+static int ngeoms = 0;
+static int verbose = 0;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * simulate - Run the instrumented kernel once per geometry
+ */
+static int simulate(const kernel_desc_t* d, int n, void* mem, size_t size, result_t* r)
+{
+    int g;
+    unsigned long long sum = 0;
+
+    for (g = 0; g < ngeoms; g++) {
+        cache_sim_t* sim = cache_sim_create(geoms[g].s, geoms[g].E, geoms[g].b);
+
+        d->init(mem, n);
+        trace_inst_clear_ranges();
+        trace_inst_add_range(mem, size);
+        trace_inst_begin(sim);
+        d->run(mem, n);
+        trace_inst_end();
+
+        r->misses[g] = sim->misses;
+        r->accesses = trace_inst_loads + trace_inst_stores;
+        cache_sim_free(sim);
+
+        sum = d->checksum(mem, n);
+        if (g > 0 && sum != r->checksum)
+            return 0;
+        r->checksum = sum;
+    }
+    return 1;
+}
+
+/*
+ * time_native - Best time of repeated native runs, in seconds
+ */
+static double time_native(const kernel_desc_t* d, int n, void* mem, unsigned long long* sum)
+{
+    double best = 1e30, start, t;
+
+    d->init(mem, n);
+    d->run(mem, n); /* warm up */
+    start = now();
+    do {
+        t = now();
+        d->run(mem, n);
+        t = now() - t;
+        if (t < best)
+            best = t;
+    } while (now() - start < MIN_SECS);
+    *sum = d->checksum(mem, n);
+    return best;
+}
+
+/*
+ * eval_kernel - Simulate and time one kernel. Returns 0 on an error
+ */
+static int eval_kernel(kernel_entry_t* k, int n_opt, int do_sim, int do_time, result_t* r)
+{
+    const kernel_desc_t* d = k->native ? k->native : k->sim;
+    unsigned long long native_sum;
+    size_t size;
+    void* mem;
+
+    memset(r, 0, sizeof(result_t));
+    r->k = k;
+    r->n = n_opt ? n_opt : d->default_n;
+    r->ok = 1;
+    size = d->mem_size(r->n);
+    if (posix_memalign(&mem, 4096, size)) {
+        printf("Error: Cannot allocate %lu bytes for %s\n", (unsigned long)size, k->name);
+        return r->ok = 0;
+    }
+
+    if (do_sim && k->sim && !simulate(k->sim, r->n, mem, size, r)) {
+        printf("Error: %s gives different outputs on different runs\n", k->name);
+        r->ok = 0;
+    }
+    if (do_time && k->native) {
+        r->secs = time_native(k->native, r->n, mem, &native_sum);
+        if (do_sim && k->sim && native_sum != r->checksum) {
+            printf("Error: Native and instrumented %s disagree\n", k->name);
+            r->ok = 0;
+        }
+        r->checksum = native_sum;
+    }
+    free(mem);
+    return r->ok;
+}
+
+static void print_result(const result_t* r, int do_sim, int do_time)
+{
+    int g;
+
+    printf("%-16s n=%-8d", r->k->name, r->n);
+    if (do_sim && r->k->sim) {
+        printf(" accesses:%-11llu", r->accesses);
+        for (g = 0; g < ngeoms; g++)
+            printf(" misses:%-9u(%5.2f%%)", r->misses[g],
+                   r->accesses ? 100.0 * r->misses[g] / r->accesses : 0.0);
+    }
+    if (do_time && r->k->native)
+        printf(" %10.3f ms", r->secs * 1e3);
+    printf("\n");
+    if (verbose) {
+        const kernel_desc_t* d = r->k->native ? r->k->native : r->k->sim;
+        printf("    %s\n", d->description);
+    }
+}
+
+static const char* group_of(const result_t* r)
+{
+    return (r->k->native ? r->k->native : r->k->sim)->group;
+}
+
+/* Sort keys for rank_group() */
+static int rank_geom;
+static int by_misses(const void* a, const void* b)
+{
+    const result_t *x = *(const result_t**)a, *y = *(const result_t**)b;
+    return (x->misses[rank_geom] > y->misses[rank_geom]) -
+           (x->misses[rank_geom] < y->misses[rank_geom]);
+}
+static int by_time(const void* a, const void* b)
+{
+    const result_t *x = *(const result_t**)a, *y = *(const result_t**)b;
+    return (x->secs > y->secs) - (x->secs < y->secs);
+}
+
+/*
+ * rank_group - Check that the kernels of one group agree, and rank them
+ *     by misses under each geometry and by native time
+ */
+static int rank_group(result_t* results, int nresults, int first, int do_sim, int do_time)
+{
+    const char* group = group_of(&results[first]);
+    result_t* members[MAX_KERNELS];
+    int i, g, m = 0, ok = 1;
+
+    for (i = first; i < nresults; i++) {
+        if (strcmp(group_of(&results[i]), group) != 0)
+            continue;
+        if (m > 0 && results[i].n == members[0]->n &&
+            results[i].checksum != members[0]->checksum) {
+            printf("Error: %s and %s disagree on their outputs\n",
+                   members[0]->k->name, results[i].k->name);
+            ok = 0;
+        }
+        members[m++] = &results[i];
+    }
+    if (m < 2)
+        return ok;
+
+    printf("\n%s:\n", group);
+    for (g = 0; do_sim && g < ngeoms; g++) {
+        rank_geom = g;
+        qsort(members, m, sizeof(result_t*), by_misses);
+        printf("  by misses (s=%d E=%d b=%d):", geoms[g].s, geoms[g].E, geoms[g].b);
+        for (i = 0; i < m; i++)
+            printf(" %d.%s", i + 1, members[i]->k->name);
+        printf("\n");
+    }
+    if (do_time) {
+        qsort(members, m, sizeof(result_t*), by_time);
+        printf("  by time:");
+        for (i = 0; i < m; i++)
+            printf(" %d.%s", i + 1, members[i]->k->name);
+        printf("\n");
+    }
+    return ok;
+}
+
+/*
+ * usage - Print usage info
+ */
+static void usage(char* argv[])
+{
+    printf("Usage: %s [-hvST] [-c <s>:<E>:<b>] [-n <size>] [-k <name>]\n", argv[0]);
+    printf("Options:\n");
+    printf("  -h             Print this help message.\n");
+    printf("  -v             Print kernel descriptions.\n");
+    printf("  -c <s>:<E>:<b> Add a cache geometry (default 5:1:5 and 6:8:6).\n");
+    printf("  -n <size>      Problem size for every kernel.\n");
+    printf("  -k <name>      Only run kernels whose name or group starts with name.\n");
+    printf("  -S             Skip the cache simulation.\n");
+    printf("  -T             Skip the native timing.\n");
+    printf("Example: %s -k matmul -c 5:1:5 -c 9:4:6 -n 64\n", argv[0]);
+}
+
+int main(int argc, char* argv[])
+{
+    char c;
+    char* only = NULL;
+    int n_opt = 0, do_sim = 1, do_time = 1, i, j, nresults = 0, ok = 1;
+    result_t results[MAX_KERNELS];
+
+    while ((c = getopt(argc, argv, "hvc:n:k:ST")) != -1) {
+        switch (c) {
+        case 'v': verbose = 1; break;
+        case 'c':
+            if (ngeoms == MAX_GEOMS ||
+                sscanf(optarg, "%d:%d:%d", &geoms[ngeoms].s, &geoms[ngeoms].E,
+                       &geoms[ngeoms].b) != 3 ||
+                geoms[ngeoms].s < 0 || geoms[ngeoms].E < 1 || geoms[ngeoms].b < 2) {
+                printf("Error: Bad cache geometry '%s'\n", optarg);
+                exit(1);
+            }
+            ngeoms++;
+            break;
+        case 'n': n_opt = atoi(optarg); break;
+        case 'k': only = optarg; break;
+        case 'S': do_sim = 0; break;
+        case 'T': do_time = 0; break;
+        case 'h': usage(argv); exit(0);
+        default: usage(argv); exit(1);
+        }
+    }
+    if (ngeoms == 0) {
+        geoms[ngeoms++] = (geom_t){ 5, 1, 5 };   /* the Cache Lab cache */
+        geoms[ngeoms++] = (geom_t){ 6, 8, 6 };   /* a 32KB L1d */
+    }
+    if (n_opt < 0) {
+        usage(argv);
+        exit(1);
+    }
+
+    registerKernels();
+    registerSimKernels();
+
+    for (i = 0; i < kernel_counter; i++) {
+        kernel_entry_t* k = &kernel_list[i];
+        const kernel_desc_t* d = k->native ? k->native : k->sim;
+        if (only && strncmp(k->name, only, strlen(only)) != 0 &&
+            strncmp(d->group, only, strlen(only)) != 0)
+            continue;
+        ok &= eval_kernel(k, n_opt, do_sim, do_time, &results[nresults]);
+        print_result(&results[nresults], do_sim, do_time);
+        fflush(stdout);
+        nresults++;
+    }
+
+    /* Rank each group once, at its first member */
+    for (i = 0; i < nresults; i++) {
+        for (j = 0; j < i; j++)
+            if (strcmp(group_of(&results[j]), group_of(&results[i])) == 0)
+                break;
+        if (j == i)
+            ok &= rank_group(results, nresults, i, do_sim, do_time);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,401 @@
+/*
+ * kernels.c - Memory-bound kernels for kernelbench
+ *
+ * This file is compiled twice: natively (kernels.o) to time the kernels,
+ * and with -fsanitize=thread -DKERNEL_SIM (kernels-sim.o) so that every
+ * load and store goes through traceinst.c to the cache model. Both
+ * builds use the same optimization level, so the traced accesses are the
+ * ones the native code makes.
+ *
+ * To add a kernel, write its init, run and checksum functions and add a
+ * descriptor to the kernels[] table at the end of the file.
+ *
+ * All data is unsigned so that the different orders in which kernels of
+ * one group combine it give bit-identical results.
+ */
+#include <stddef.h>
+#include "cachelab.h"
+
+#ifdef KERNEL_SIM
+#define KERNEL_INSTRUMENTED 1
+#define registerKernels registerSimKernels
+#else
+#define KERNEL_INSTRUMENTED 0
+#endif
+
+/* Side of the blocks in the blocked kernels, in elements */
+#define KBLOCK 32
+
+typedef unsigned int elem_t;
+
+/*
+ * next_rand - xorshift32, so inputs are the same in both builds
+ */
+static unsigned int next_rand(unsigned int* state)
+{
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static unsigned long long sum_words(const elem_t* p, size_t n)
+{
+    unsigned long long h = 14695981039346656037ULL;
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        h = (h ^ p[i]) * 1099511628211ULL;
+    return h;
+}
+
+/******************************************************************
+ * Matrix multiply: C = A * B for n x n matrices
+ ******************************************************************/
+
+static size_t matmul_size(int n)
+{
+    return 3 * (size_t)n * n * sizeof(elem_t);
+}
+
+static void matmul_init(void* mem, int n)
+{
+    elem_t* p = (elem_t*)mem;
+    unsigned int seed = 1;
+    size_t i;
+
+    for (i = 0; i < 2 * (size_t)n * n; i++)
+        p[i] = next_rand(&seed) & 0xff;
+}
+
+static unsigned long long matmul_checksum(const void* mem, int n)
+{
+    return sum_words((const elem_t*)mem + 2 * (size_t)n * n, (size_t)n * n);
+}
+
+/* Inner products: B is read down its columns */
+static void matmul_ijk(void* mem, int n)
+{
+    elem_t (*A)[n] = (elem_t (*)[n])mem;
+    elem_t (*B)[n] = A + n;
+    elem_t (*C)[n] = B + n;
+    int i, j, k;
+
+    for (i = 0; i < n; i++) {
+        for (j = 0; j < n; j++) {
+            elem_t sum = 0;
+            for (k = 0; k < n; k++)
+                sum += A[i][k] * B[k][j];
+            C[i][j] = sum;
+        }
+    }
+}
+
+/* Row updates: every access is along a row */
+static void matmul_ikj(void* mem, int n)
+{
+    elem_t (*A)[n] = (elem_t (*)[n])mem;
+    elem_t (*B)[n] = A + n;
+    elem_t (*C)[n] = B + n;
+    int i, j, k;
+
+    for (i = 0; i < n; i++) {
+        for (j = 0; j < n; j++)
+            C[i][j] = 0;
+        for (k = 0; k < n; k++) {
+            elem_t a = A[i][k];
+            for (j = 0; j < n; j++)
+                C[i][j] += a * B[k][j];
+        }
+    }
+}
+
+/* Row updates within KBLOCK x KBLOCK blocks, so a block of B is reused */
+static void matmul_blocked(void* mem, int n)
+{
+    elem_t (*A)[n] = (elem_t (*)[n])mem;
+    elem_t (*B)[n] = A + n;
+    elem_t (*C)[n] = B + n;
+    int i, j, k, kk, jj, kend, jend;
+
+    for (i = 0; i < n; i++)
+        for (j = 0; j < n; j++)
+            C[i][j] = 0;
+    for (kk = 0; kk < n; kk += KBLOCK) {
+        kend = (kk + KBLOCK < n) ? kk + KBLOCK : n;
+        for (jj = 0; jj < n; jj += KBLOCK) {
+            jend = (jj + KBLOCK < n) ? jj + KBLOCK : n;
+            for (i = 0; i < n; i++) {
+                for (k = kk; k < kend; k++) {
+                    elem_t a = A[i][k];
+                    for (j = jj; j < jend; j++)
+                        C[i][j] += a * B[k][j];
+                }
+            }
+        }
+    }
+}
+
+/******************************************************************
+ * Stencil: one sweep of a 5-point stencil over an n x n grid
+ ******************************************************************/
+
+static size_t stencil_size(int n)
+{
+    return 2 * (size_t)n * n * sizeof(elem_t);
+}
+
+static void stencil_init(void* mem, int n)
+{
+    elem_t* p = (elem_t*)mem;
+    unsigned int seed = 2;
+    size_t i;
+
+    for (i = 0; i < (size_t)n * n; i++)
+        p[i] = next_rand(&seed);
+}
+
+static unsigned long long stencil_checksum(const void* mem, int n)
+{
+    return sum_words((const elem_t*)mem + (size_t)n * n, (size_t)n * n);
+}
+
+static inline elem_t stencil_point(int n, elem_t (*in)[n], int i, int j)
+{
+    if (i == 0 || j == 0 || i == n - 1 || j == n - 1)
+        return in[i][j];
+    return in[i][j] + in[i - 1][j] + in[i + 1][j] + in[i][j - 1] + in[i][j + 1];
+}
+
+static void stencil_rows(void* mem, int n)
+{
+    elem_t (*in)[n] = (elem_t (*)[n])mem;
+    elem_t (*out)[n] = in + n;
+    int i, j;
+
+    for (i = 0; i < n; i++)
+        for (j = 0; j < n; j++)
+            out[i][j] = stencil_point(n, in, i, j);
+}
+
+static void stencil_cols(void* mem, int n)
+{
+    elem_t (*in)[n] = (elem_t (*)[n])mem;
+    elem_t (*out)[n] = in + n;
+    int i, j;
+
+    for (j = 0; j < n; j++)
+        for (i = 0; i < n; i++)
+            out[i][j] = stencil_point(n, in, i, j);
+}
+
+/******************************************************************
+ * Gather and scatter through a random permutation of n elements
+ ******************************************************************/
+
+static size_t perm_size(int n)
+{
+    return 3 * (size_t)n * sizeof(elem_t);
+}
+
+/* Layout: idx[n], src[n], dst[n] */
+static void perm_init(void* mem, int n)
+{
+    elem_t* idx = (elem_t*)mem;
+    elem_t* src = idx + n;
+    unsigned int seed = 3;
+    int i, j;
+    elem_t t;
+
+    for (i = 0; i < n; i++) {
+        idx[i] = i;
+        src[i] = next_rand(&seed);
+    }
+    for (i = n - 1; i > 0; i--) {
+        j = next_rand(&seed) % (i + 1);
+        t = idx[i];
+        idx[i] = idx[j];
+        idx[j] = t;
+    }
+}
+
+static unsigned long long perm_checksum(const void* mem, int n)
+{
+    return sum_words((const elem_t*)mem + 2 * (size_t)n, n);
+}
+
+static void gather(void* mem, int n)
+{
+    elem_t* idx = (elem_t*)mem;
+    elem_t* src = idx + n;
+    elem_t* dst = src + n;
+    int i;
+
+    for (i = 0; i < n; i++)
+        dst[i] = src[idx[i]];
+}
+
+static void scatter(void* mem, int n)
+{
+    elem_t* idx = (elem_t*)mem;
+    elem_t* src = idx + n;
+    elem_t* dst = src + n;
+    int i;
+
+    for (i = 0; i < n; i++)
+        dst[idx[i]] = src[i];
+}
+
+/******************************************************************
+ * Hash probe: n lookups, half of them hits, in a linear-probing table
+ * of n keys at 50% load. The same table is stored two ways: keys and
+ * values in separate arrays, or as interleaved key/value pairs.
+ ******************************************************************/
+
+static size_t hash_slots(int n)
+{
+    size_t slots = 1;
+    while (slots < 2 * (size_t)n)
+        slots <<= 1;
+    return slots;
+}
+
+static unsigned int hash_key(elem_t key)
+{
+    return key * 2654435761u;
+}
+
+/* Layout: table (2 * slots), queries[n], result */
+static size_t probe_size(int n)
+{
+    return (2 * hash_slots(n) + n + 1) * sizeof(elem_t);
+}
+
+/*
+ * probe_init - Build the table; pairs selects the interleaved layout.
+ *     Keys are odd, so 0 marks an empty slot and even queries miss.
+ */
+static void probe_init_layout(void* mem, int n, int pairs)
+{
+    size_t slots = hash_slots(n), mask = slots - 1, h, i;
+    elem_t* table = (elem_t*)mem;
+    elem_t* keys = table;
+    elem_t* vals = table + slots;
+    elem_t* queries = table + 2 * slots;
+    unsigned int seed = 4;
+    elem_t key;
+
+    for (i = 0; i < 2 * slots; i++)
+        table[i] = 0;
+    for (i = 0; i < (size_t)n; i++) {
+        key = (elem_t)(2 * i + 1);
+        for (h = hash_key(key) & mask; ; h = (h + 1) & mask) {
+            if (pairs ? table[2 * h] == 0 : keys[h] == 0)
+                break;
+        }
+        if (pairs) {
+            table[2 * h] = key;
+            table[2 * h + 1] = key * 3;
+        }
+        else {
+            keys[h] = key;
+            vals[h] = key * 3;
+        }
+    }
+    for (i = 0; i < (size_t)n; i++)
+        queries[i] = next_rand(&seed) % (2 * (unsigned int)n) + 1;
+}
+
+static void probe_split_init(void* mem, int n)
+{
+    probe_init_layout(mem, n, 0);
+}
+
+static void probe_pairs_init(void* mem, int n)
+{
+    probe_init_layout(mem, n, 1);
+}
+
+static unsigned long long probe_checksum(const void* mem, int n)
+{
+    return sum_words((const elem_t*)mem + 2 * hash_slots(n) + n, 1);
+}
+
+static void probe_split(void* mem, int n)
+{
+    size_t slots = hash_slots(n), mask = slots - 1, h;
+    elem_t* keys = (elem_t*)mem;
+    elem_t* vals = keys + slots;
+    elem_t* queries = keys + 2 * slots;
+    elem_t sum = 0, q;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        q = queries[i];
+        for (h = hash_key(q) & mask; keys[h] != 0; h = (h + 1) & mask) {
+            if (keys[h] == q) {
+                sum += vals[h];
+                break;
+            }
+        }
+    }
+    queries[n] = sum;
+}
+
+static void probe_pairs(void* mem, int n)
+{
+    size_t slots = hash_slots(n), mask = slots - 1, h;
+    elem_t* table = (elem_t*)mem;
+    elem_t* queries = table + 2 * slots;
+    elem_t sum = 0, q;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        q = queries[i];
+        for (h = hash_key(q) & mask; table[2 * h] != 0; h = (h + 1) & mask) {
+            if (table[2 * h] == q) {
+                sum += table[2 * h + 1];
+                break;
+            }
+        }
+    }
+    queries[n] = sum;
+}
+
+/******************************************************************
+ * The kernel table
+ ******************************************************************/
+
+static const kernel_desc_t kernels[] = {
+    { "matmul-ijk", "matmul", "Matrix multiply, inner products", 128,
+      matmul_size, matmul_init, matmul_ijk, matmul_checksum },
+    { "matmul-ikj", "matmul", "Matrix multiply, row updates", 128,
+      matmul_size, matmul_init, matmul_ikj, matmul_checksum },
+    { "matmul-blocked", "matmul", "Matrix multiply, 32x32 blocked row updates", 128,
+      matmul_size, matmul_init, matmul_blocked, matmul_checksum },
+    { "stencil-rows", "stencil", "5-point stencil, row by row", 512,
+      stencil_size, stencil_init, stencil_rows, stencil_checksum },
+    { "stencil-cols", "stencil", "5-point stencil, column by column", 512,
+      stencil_size, stencil_init, stencil_cols, stencil_checksum },
+    { "gather", "gather", "dst[i] = src[idx[i]], random permutation", 1 << 18,
+      perm_size, perm_init, gather, perm_checksum },
+    { "scatter", "scatter", "dst[idx[i]] = src[i], random permutation", 1 << 18,
+      perm_size, perm_init, scatter, perm_checksum },
+    { "probe-split", "probe", "Linear-probing lookups, separate key and value arrays", 1 << 17,
+      probe_size, probe_split_init, probe_split, probe_checksum },
+    { "probe-pairs", "probe", "Linear-probing lookups, interleaved key/value pairs", 1 << 17,
+      probe_size, probe_pairs_init, probe_pairs, probe_checksum },
+};
+
+/*
+ * registerKernels - Register every kernel in this file (registerSimKernels
+ *     in the instrumented build)
+ */
+void registerKernels()
+{
+    int i;
+
+    for (i = 0; i < (int)(sizeof(kernels) / sizeof(kernels[0])); i++)
+        registerKernel(&kernels[i], KERNEL_INSTRUMENTED);
+}
@@ -12,6 +12,8 @@
 #include <getopt.h>
 #include <sys/types.h>
 #include "cachelab.h"
+#include "cachesim.h"
+#include "traceinst.h"
 #include <sys/wait.h> // fir WEXITSTATUS
 #include <limits.h> // for INT_MAX
 
@@ -32,6 +34,14 @@ extern int func_counter;
 /* Globals set on the command line */
 static int M = 0;
 static int N = 0;
+static int use_valgrind = 0; /* -V: trace with valgrind and csim-ref */
+
+/* Matrices for in-process evaluation. Page aligned so that the set
+   mapping does not depend on where the linker places them */
+static struct {
+    int A[MAXN][MAXN];
+    int B[MAXN][MAXN];
+} mats __attribute__((aligned(4096)));
 
 /* The correctness and performance for the submitted transpose function */
 struct results {
@@ -42,110 +52,182 @@ struct results {
 static struct results results = {-1, 0, INT_MAX};
 
 /* 
- * eval_perf - Evaluate the performance of the registered transpose functions
+ * validate - Check that B holds the transpose of A
  */
-void eval_perf(unsigned int s, unsigned int E, unsigned int b)
+static int validate(int fn, int M, int N, int A[N][M], int B[M][N])
+{
+    int i, j;
+
+    for (i = 0; i < N; i++) {
+        for (j = 0; j < M; j++) {
+            if (A[i][j] != B[j][i]) {
+                printf("Validation failed on function %d! Expected %d but got %d at B[%d][%d]\n",
+                       fn, A[i][j], B[j][i], j, i);
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/* 
+ * eval_inprocess - Run function i on the instrumented matrices, with
+ *     every access to A and B fed to the embedded cache model. Accesses
+ *     anywhere else, such as a scratch array, are not simulated; they
+ *     are counted and reported. Returns 0 if the function does not
+ *     transpose correctly.
+ */
+static int eval_inprocess(int i, cache_sim_t* sim)
 {
-    int i,flag;
-    unsigned int len, hits, misses, evictions;
+    initMatrix(M, N, mats.A, mats.B);
+
+    trace_inst_clear_ranges();
+    trace_inst_add_range(mats.A, sizeof(int) * M * N);
+    trace_inst_add_range(mats.B, sizeof(int) * M * N);
+    cache_sim_reset(sim);
+
+    trace_inst_begin(sim);
+    (*func_list[i].func_ptr)(M, N, mats.A, mats.B);
+    trace_inst_end();
+
+    if (trace_inst_untraced)
+        printf("Warning: function %d made %llu accesses outside A and B, not simulated\n",
+               i, trace_inst_untraced);
+    return validate(i, M, N, mats.A, mats.B);
+}
+
+/* 
+ * eval_valgrind - Trace function i with valgrind's lackey tool and
+ *     count its hits, misses and evictions with csim-ref. Returns 0 if
+ *     the function does not transpose correctly.
+ */
+static int eval_valgrind(int i, unsigned int s, unsigned int E, unsigned int b,
+                         unsigned int* hits, unsigned int* misses,
+                         unsigned int* evictions)
+{
+    int flag;
+    unsigned int len;
     unsigned long long int marker_start, marker_end, addr;
     char buf[1000], cmd[255];
     char filename[128];
-
-    registerFunctions(); 
-
-    /* Open the complete trace file */
     FILE* full_trace_fp;  
     FILE* part_trace_fp; 
 
-    /* Evaluate the performance of each registered transpose function */
+    printf("\nFunction %d (%d total)\nStep 1: Validating and generating memory traces\n",i,func_counter);
+    /* Use valgrind to generate the trace */
 
-    for (i=0; i<func_counter; i++) {
-        if (strcmp(func_list[i].description, SUBMIT_DESCRIPTION) == 0 )
-            results.funcid = i; /* remember which function is the submission */
+    sprintf(cmd, "valgrind --tool=lackey --trace-mem=yes --log-fd=1 -v ./tracegen -M %d -N %d -F %d  > trace.tmp", M, N,i);
+    flag=WEXITSTATUS(system(cmd));
+    if (0!=flag) {
+        printf("Validation error at function %d! Run ./tracegen -M %d -N %d -F %d for details.\nSkipping performance evaluation for this function.\n",flag-1,M,N,i);      
+        return 0;
+    }
 
+    /* Get the start and end marker addresses */
+    FILE* marker_fp = fopen(".marker", "r");
+    assert(marker_fp);
+    fscanf(marker_fp, "%llx %llx", &marker_start, &marker_end);
+    fclose(marker_fp);
 
-        printf("\nFunction %d (%d total)\nStep 1: Validating and generating memory traces\n",i,func_counter);
-        /* Use valgrind to generate the trace */
 
-        sprintf(cmd, "valgrind --tool=lackey --trace-mem=yes --log-fd=1 -v ./tracegen -M %d -N %d -F %d  > trace.tmp", M, N,i);
-        flag=WEXITSTATUS(system(cmd));
-        if (0!=flag) {
-            printf("Validation error at function %d! Run ./tracegen -M %d -N %d -F %d for details.\nSkipping performance evaluation for this function.\n",flag-1,M,N,i);      
-            continue;
+    full_trace_fp = fopen("trace.tmp", "r");
+    assert(full_trace_fp);
+
+
+    /* Filtered trace for each transpose function goes in a separate file */
+    sprintf(filename, "trace.f%d", i);
+    part_trace_fp = fopen(filename, "w");
+    assert(part_trace_fp);
+
+    /* Locate trace corresponding to the trans function */
+    flag = 0;
+    while (fgets(buf, 1000, full_trace_fp) != NULL) {
+
+        /* We are only interested in memory access instructions */
+        if (buf[0]==' ' && buf[2]==' ' &&
+            (buf[1]=='S' || buf[1]=='M' || buf[1]=='L' )) {
+            sscanf(buf+3, "%llx,%u", &addr, &len);
+    
+            /* If start marker found, set flag */
+            if (addr == marker_start)
+                flag = 1;
+
+            /* Valgrind creates many spurious accesses to the
+               stack that have nothing to do with the students
+               code. At the moment, we are ignoring all stack
+               accesses by using the simple filter of recording
+               accesses to only the low 32-bit portion of the
+               address space. At some point it would be nice to
+               try to do more informed filtering so that would
+               eliminate the valgrind stack references while
+               include the student stack references. */
+            if (flag && addr < 0xffffffff) {
+                fputs(buf, part_trace_fp);
+            }
+
+            /* if end marker found, close trace file */
+            if (addr == marker_end) {
+                flag = 0;
+                fclose(part_trace_fp);
+                break;
+            }
         }
+    }
+    fclose(full_trace_fp);
+
+    /* Run the reference simulator */
+    printf("Step 2: Evaluating performance (s=%d, E=%d, b=%d)\n", s, E, b);
+    sprintf(cmd, "./csim-ref -s %u -E %u -b %u -t trace.f%d > /dev/null", 
+            s, E, b, i);
+    system(cmd);
+
+    /* Collect results from the reference simulator */
+    FILE* in_fp = fopen(".csim_results","r");
+    assert(in_fp);
+    fscanf(in_fp, "%u %u %u", hits, misses, evictions);
+    fclose(in_fp);
+    return 1;
+}
 
-        /* Get the start and end marker addresses */
-        FILE* marker_fp = fopen(".marker", "r");
-        assert(marker_fp);
-        fscanf(marker_fp, "%llx %llx", &marker_start, &marker_end);
-        fclose(marker_fp);
+/* 
+ * eval_perf - Evaluate the performance of the registered transpose functions
+ */
+void eval_perf(unsigned int s, unsigned int E, unsigned int b)
+{
+    int i, ok;
+    unsigned int hits, misses, evictions;
+    cache_sim_t* sim = cache_sim_create(s, E, b);
 
+    registerFunctions(); 
+    registerTunedFunctions(M, N);
 
-        func_list[i].correct=1;
+    /* Evaluate the performance of each registered transpose function */
+
+    for (i=0; i<func_counter; i++) {
+        if (strcmp(func_list[i].description, SUBMIT_DESCRIPTION) == 0 )
+            results.funcid = i; /* remember which function is the submission */
+
+        if (use_valgrind) {
+            ok = eval_valgrind(i, s, E, b, &hits, &misses, &evictions);
+        } else {
+            printf("\nFunction %d (%d total)\nStep 1: Validating and tracing in-process (s=%d, E=%d, b=%d)\n",
+                   i, func_counter, s, E, b);
+            ok = eval_inprocess(i, sim);
+            if (!ok)
+                printf("Validation error at function %d!\nSkipping performance evaluation for this function.\n", i);
+            hits = sim->hits;
+            misses = sim->misses;
+            evictions = sim->evictions;
+        }
+        if (!ok)
+            continue;
 
         /* Save the correctness of the transpose submission */
+        func_list[i].correct=1;
         if (results.funcid == i ) {
             results.correct = 1;
         }
 
-        full_trace_fp = fopen("trace.tmp", "r");
-        assert(full_trace_fp);
-
-
-        /* Filtered trace for each transpose function goes in a separate file */
-        sprintf(filename, "trace.f%d", i);
-        part_trace_fp = fopen(filename, "w");
-        assert(part_trace_fp);
-    
-        /* Locate trace corresponding to the trans function */
-        flag = 0;
-        while (fgets(buf, 1000, full_trace_fp) != NULL) {
-
-            /* We are only interested in memory access instructions */
-            if (buf[0]==' ' && buf[2]==' ' &&
-                (buf[1]=='S' || buf[1]=='M' || buf[1]=='L' )) {
-                sscanf(buf+3, "%llx,%u", &addr, &len);
-        
-                /* If start marker found, set flag */
-                if (addr == marker_start)
-                    flag = 1;
-
-                /* Valgrind creates many spurious accesses to the
-                   stack that have nothing to do with the students
-                   code. At the moment, we are ignoring all stack
-                   accesses by using the simple filter of recording
-                   accesses to only the low 32-bit portion of the
-                   address space. At some point it would be nice to
-                   try to do more informed filtering so that would
-                   eliminate the valgrind stack references while
-                   include the student stack references. */
-                if (flag && addr < 0xffffffff) {
-                    fputs(buf, part_trace_fp);
-                }
-
-                /* if end marker found, close trace file */
-                if (addr == marker_end) {
-                    flag = 0;
-                    fclose(part_trace_fp);
-                    break;
-                }
-            }
-        }
-        fclose(full_trace_fp);
-
-        /* Run the reference simulator */
-        printf("Step 2: Evaluating performance (s=%d, E=%d, b=%d)\n", s, E, b);
-        char cmd[255];
-        sprintf(cmd, "./csim-ref -s %u -E %u -b %u -t trace.f%d > /dev/null", 
-                s, E, b, i);
-        system(cmd);
-    
-        /* Collect results from the reference simulator */
-        FILE* in_fp = fopen(".csim_results","r");
-        assert(in_fp);
-        fscanf(in_fp, "%u %u %u", &hits, &misses, &evictions);
-        fclose(in_fp);
         func_list[i].num_hits = hits;
         func_list[i].num_misses = misses;
         func_list[i].num_evictions = evictions;
@@ -157,16 +239,17 @@ void eval_perf(unsigned int s, unsigned int E, unsigned int b)
             results.misses = misses;
         }
     }
-  
+    cache_sim_free(sim);
 }
 
 /*
  * usage - Print usage info
  */
 void usage(char *argv[]){
-    printf("Usage: %s [-h] -M <rows> -N <cols>\n", argv[0]);
+    printf("Usage: %s [-hV] -M <rows> -N <cols>\n", argv[0]);
     printf("Options:\n");
     printf("  -h          Print this help message.\n");
+    printf("  -V          Trace with valgrind and csim-ref instead of in-process.\n");
     printf("  -M <rows>   Number of matrix rows (max %d)\n", MAXN);
     printf("  -N <cols>   Number of  matrix columns (max %d)\n", MAXN);
     printf("Example: %s -M 8 -N 8\n", argv[0]);       
@@ -199,7 +282,7 @@ int main(int argc, char* argv[])
 {
     char c;
 
-    while ((c = getopt(argc,argv,"M:N:h")) != -1) {
+    while ((c = getopt(argc,argv,"M:N:hV")) != -1) {
         switch(c) {
         case 'M':
             M = atoi(optarg);
@@ -207,6 +290,9 @@ int main(int argc, char* argv[])
         case 'N':
             N = atoi(optarg);
             break;
+        case 'V':
+            use_valgrind = 1;
+            break;
         case 'h':
             usage(argv);
             exit(0);
@@ -0,0 +1,217 @@
+/*
+ * tracefmt.c - Readers and writers for Cache Lab memory traces
+ *
+ * Both formats are read through mmap so that decoding is a single pass
+ * over memory with no stdio buffering in between.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "tracefmt.h"
+
+struct trace_reader {
+    const unsigned char* base;   /* mapped file */
+    size_t len;
+    const unsigned char* p;      /* next unread byte */
+    const unsigned char* end;
+    int binary;
+    unsigned long long prev[2];  /* binary: last address per stream */
+    long long stride[2];         /* binary: last delta per stream */
+};
+
+static const char op_chars[4] = { 'I', 'L', 'S', 'M' };
+
+/*
+ * trace_open - Map the trace file and check for the binary magic
+ */
+trace_reader_t* trace_open(const char* path)
+{
+    struct stat st;
+    trace_reader_t* tr;
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+        return NULL;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return NULL;
+    }
+    tr = (trace_reader_t*)calloc(1, sizeof(trace_reader_t));
+    tr->len = st.st_size;
+    if (tr->len > 0) {
+        void* m = mmap(NULL, tr->len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m == MAP_FAILED) {
+            close(fd);
+            free(tr);
+            return NULL;
+        }
+        tr->base = (const unsigned char*)m;
+        posix_madvise(m, tr->len, POSIX_MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    tr->p = tr->base;
+    tr->end = tr->base + tr->len;
+    if (tr->len >= TRACE_MAGIC_LEN &&
+        memcmp(tr->base, TRACE_MAGIC, TRACE_MAGIC_LEN) == 0) {
+        tr->binary = 1;
+        tr->p += TRACE_MAGIC_LEN;
+    }
+    return tr;
+}
+
+void trace_close(trace_reader_t* tr)
+{
+    if (tr->base)
+        munmap((void*)tr->base, tr->len);
+    free(tr);
+}
+
+/*
+ * get_varint - Decode an LEB128 varint. Returns 0 on truncated input
+ */
+static int get_varint(trace_reader_t* tr, unsigned long long* val)
+{
+    unsigned long long v = 0;
+    int shift = 0;
+
+    while (tr->p < tr->end && shift < 64) {
+        unsigned char c = *tr->p++;
+        v |= (unsigned long long)(c & 0x7f) << shift;
+        if (!(c & 0x80)) {
+            *val = v;
+            return 1;
+        }
+        shift += 7;
+    }
+    return 0;
+}
+
+static int next_binary(trace_reader_t* tr, trace_rec_t* rec)
+{
+    unsigned char h;
+    unsigned long long v;
+    int stream;
+
+    if (tr->p == tr->end)
+        return 0;
+    h = *tr->p++;
+    if (h & 0x40)
+        return -1;
+    rec->op = op_chars[(h >> 4) & 3];
+    rec->size = h & 0xf;
+    if (rec->size == 0) {
+        if (!get_varint(tr, &v))
+            return -1;
+        rec->size = (int)v;
+    }
+
+    stream = rec->op != 'I';
+    if (!(h & 0x80)) {
+        if (!get_varint(tr, &v))
+            return -1;
+        tr->stride[stream] = (long long)(v >> 1) ^ -(long long)(v & 1);
+    }
+    tr->prev[stream] += tr->stride[stream];
+    rec->addr = tr->prev[stream];
+    return 1;
+}
+
+static int hex_digit(unsigned char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/*
+ * next_text - Parse one " %c %llx,%d" lackey record
+ */
+static int next_text(trace_reader_t* tr, trace_rec_t* rec)
+{
+    const unsigned char* p = tr->p;
+    const unsigned char* end = tr->end;
+    unsigned long long addr = 0;
+    int size = 0, d, digits = 0;
+
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+        p++;
+    if (p == end) {
+        tr->p = p;
+        return 0;
+    }
+    rec->op = *p++;
+    while (p < end && *p == ' ')
+        p++;
+    for (; p < end && (d = hex_digit(*p)) >= 0; p++, digits++)
+        addr = (addr << 4) | d;
+    if (!digits || p == end || *p != ',')
+        return -1;
+    for (p++; p < end && *p >= '0' && *p <= '9'; p++)
+        size = size * 10 + (*p - '0');
+    while (p < end && *p != '\n')
+        p++;
+
+    rec->addr = addr;
+    rec->size = size;
+    tr->p = p;
+    return 1;
+}
+
+int trace_next(trace_reader_t* tr, trace_rec_t* rec)
+{
+    return tr->binary ? next_binary(tr, rec) : next_text(tr, rec);
+}
+
+int trace_writer_init(trace_writer_t* tw, FILE* fp)
+{
+    memset(tw, 0, sizeof(trace_writer_t));
+    tw->fp = fp;
+    return fwrite(TRACE_MAGIC, 1, TRACE_MAGIC_LEN, fp) == TRACE_MAGIC_LEN;
+}
+
+static int put_varint(unsigned char* buf, unsigned long long v)
+{
+    int n = 0;
+    while (v >= 0x80) {
+        buf[n++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    buf[n++] = (unsigned char)v;
+    return n;
+}
+
+int trace_write(trace_writer_t* tw, const trace_rec_t* rec)
+{
+    unsigned char buf[1 + 10 + 10];
+    int n = 1, op, stream = rec->op != 'I';
+    long long delta = (long long)(rec->addr - tw->prev[stream]);
+
+    switch (rec->op) {
+    case 'I': op = 0; break;
+    case 'L': op = 1; break;
+    case 'S': op = 2; break;
+    case 'M': op = 3; break;
+    default: return 0;
+    }
+    buf[0] = (unsigned char)(op << 4);
+    if (rec->size > 0 && rec->size < 16)
+        buf[0] |= (unsigned char)rec->size;
+    else
+        n += put_varint(buf + n, (unsigned long long)rec->size);
+
+    if (delta == tw->stride[stream]) {
+        buf[0] |= 0x80;
+    } else {
+        n += put_varint(buf + n, ((unsigned long long)delta << 1) ^
+                        (unsigned long long)(delta >> 63));
+        tw->stride[stream] = delta;
+    }
+    tw->prev[stream] = rec->addr;
+    return fwrite(buf, 1, n, tw->fp) == (size_t)n;
+}
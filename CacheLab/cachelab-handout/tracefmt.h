@@ -0,0 +1,56 @@
+/*
+ * tracefmt.h - Readers and writers for Cache Lab memory traces
+ *
+ * Traces come either as valgrind lackey text (" L 7ff000398,8") or in
+ * a compact binary form produced by tracepack. The binary form starts
+ * with the 8-byte magic TRACE_MAGIC followed by one record per access:
+ *
+ *   header byte:  bits 0-3  access size (0 = size follows as a varint)
+ *                 bits 4-5  op (0 = I, 1 = L, 2 = S, 3 = M)
+ *                 bit  6    unused, must be 0
+ *                 bit  7    address advances by the previous stride
+ *   [varint]      size, only if bits 0-3 are 0
+ *   [varint]      zigzag-encoded address delta, only if bit 7 is 0
+ *
+ * Instruction and data addresses are delta-encoded against separate
+ * predictors, so a loop that walks an array costs one byte per access.
+ */
+
+#ifndef CACHELAB_TRACEFMT_H
+#define CACHELAB_TRACEFMT_H
+
+#include <stdio.h>
+
+#define TRACE_MAGIC "CLTRACE1"
+#define TRACE_MAGIC_LEN 8
+
+typedef struct {
+    char op;                 /* 'I', 'L', 'S' or 'M' */
+    int size;                /* bytes accessed */
+    unsigned long long addr;
+} trace_rec_t;
+
+typedef struct trace_reader trace_reader_t;
+
+/* Open a text or binary trace, detecting the format from its contents */
+trace_reader_t* trace_open(const char* path);
+
+/* Read the next record. Returns 1 on success, 0 at the end of the
+   trace and -1 if the trace is malformed */
+int trace_next(trace_reader_t* tr, trace_rec_t* rec);
+
+void trace_close(trace_reader_t* tr);
+
+typedef struct {
+    FILE* fp;
+    unsigned long long prev[2];  /* last address per stream (I, data) */
+    long long stride[2];         /* last delta per stream */
+} trace_writer_t;
+
+/* Write the binary header to fp and reset the address predictors */
+int trace_writer_init(trace_writer_t* tw, FILE* fp);
+
+/* Append one record in the binary format. Returns 0 on I/O error */
+int trace_write(trace_writer_t* tw, const trace_rec_t* rec);
+
+#endif /* CACHELAB_TRACEFMT_H */
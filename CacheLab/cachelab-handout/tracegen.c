@@ -70,8 +70,10 @@ int main(int argc, char* argv[]){
     }
   
 
-    /*  Register transpose functions */
+    /*  Register transpose functions, and the tuned kernel for this
+        shape (test-trans registers the same list, in the same order) */
     registerFunctions();
+    registerTunedFunctions(M, N);
 
     /* Fill A with data */
     initMatrix(M,N, A, B); 
@@ -0,0 +1,92 @@
+/*
+ * traceinst.c - ThreadSanitizer-compatible hooks that drive cachesim
+ *
+ * Only the entry points that GCC and Clang emit for plain C code are
+ * defined; any instrumented object must be linked without the real
+ * -fsanitize=thread runtime.
+ */
+#include <stddef.h>
+#include "traceinst.h"
+
+static cache_sim_t* trace_sim = NULL;
+static int trace_nranges = 0;
+static unsigned long long trace_lo[TRACE_MAX_RANGES];
+static unsigned long long trace_hi[TRACE_MAX_RANGES];
+
+unsigned long long trace_inst_loads = 0, trace_inst_stores = 0;
+unsigned long long trace_inst_untraced = 0;
+
+void trace_inst_begin(cache_sim_t* sim)
+{
+    trace_inst_loads = trace_inst_stores = trace_inst_untraced = 0;
+    trace_sim = sim;
+}
+
+void trace_inst_end(void)
+{
+    trace_sim = NULL;
+}
+
+int trace_inst_add_range(const void* base, size_t len)
+{
+    if (trace_nranges == TRACE_MAX_RANGES)
+        return 0;
+    trace_lo[trace_nranges] = (unsigned long long)(size_t)base;
+    trace_hi[trace_nranges] = (unsigned long long)(size_t)base + len;
+    trace_nranges++;
+    return 1;
+}
+
+void trace_inst_clear_ranges(void)
+{
+    trace_nranges = 0;
+}
+
+/* 
+ * trace_access - Common body of every hook 
+ */
+static inline void trace_access(void* p, int is_store)
+{
+    unsigned long long addr = (unsigned long long)(size_t)p;
+    int i;
+
+    if (!trace_sim)
+        return;
+    for (i = 0; i < trace_nranges; i++) {
+        if (addr >= trace_lo[i] && addr < trace_hi[i]) {
+            if (is_store)
+                trace_inst_stores++;
+            else
+                trace_inst_loads++;
+            cache_sim_access(trace_sim, addr);
+            return;
+        }
+    }
+    trace_inst_untraced++;
+}
+
+#define TRACE_HOOKS(n)                                                     \
+    void __tsan_read##n(void* p) { trace_access(p, 0); }                   \
+    void __tsan_write##n(void* p) { trace_access(p, 1); }                  \
+    void __tsan_unaligned_read##n(void* p) { trace_access(p, 0); }         \
+    void __tsan_unaligned_write##n(void* p) { trace_access(p, 1); }        \
+    void __tsan_volatile_read##n(void* p) { trace_access(p, 0); }          \
+    void __tsan_volatile_write##n(void* p) { trace_access(p, 1); }         \
+    void __tsan_read##n##_pc(void* p, void* pc) { trace_access(p, 0); }    \
+    void __tsan_write##n##_pc(void* p, void* pc) { trace_access(p, 1); }
+
+TRACE_HOOKS(1)
+TRACE_HOOKS(2)
+TRACE_HOOKS(4)
+TRACE_HOOKS(8)
+TRACE_HOOKS(16)
+
+void __tsan_read_range(void* p, size_t len) { trace_access(p, 0); }
+void __tsan_write_range(void* p, size_t len) { trace_access(p, 1); }
+
+/* Runtime entry points that carry no memory access */
+void __tsan_init(void) { }
+void __tsan_func_entry(void* pc) { }
+void __tsan_func_exit(void) { }
+void __tsan_vptr_update(void** vptr, void* val) { }
+void __tsan_vptr_read(void** vptr) { }
@@ -0,0 +1,40 @@
+/*
+ * traceinst.h - In-process memory tracing for compiler-instrumented code
+ *
+ * Code compiled with -fsanitize=thread calls a __tsan_readN/__tsan_writeN
+ * hook before every load and store that may touch shared memory (locals
+ * kept in registers or unaliased stack slots are not instrumented).
+ * traceinst.c supplies those hooks in place of the ThreadSanitizer
+ * runtime and feeds the accesses that fall into registered address
+ * ranges to an embedded cache model, replacing valgrind's lackey tool.
+ */
+
+#ifndef CACHELAB_TRACEINST_H
+#define CACHELAB_TRACEINST_H
+
+#include <stddef.h>
+#include "cachesim.h"
+
+#define TRACE_MAX_RANGES 8
+
+/* Start sending accesses within the registered ranges to sim */
+void trace_inst_begin(cache_sim_t* sim);
+
+/* Stop tracing */
+void trace_inst_end(void);
+
+/* Trace accesses to [base, base+len). Returns 0 if the table is full */
+int trace_inst_add_range(const void* base, size_t len);
+
+/* Forget all registered ranges */
+void trace_inst_clear_ranges(void);
+
+/* Number of traced loads and stores since the last trace_inst_begin() */
+extern unsigned long long trace_inst_loads, trace_inst_stores;
+
+/* Number of instrumented accesses since the last trace_inst_begin()
+   that fell outside every registered range, and so were not simulated
+   (stack arrays and globals the code under test uses as scratch) */
+extern unsigned long long trace_inst_untraced;
+
+#endif /* CACHELAB_TRACEINST_H */
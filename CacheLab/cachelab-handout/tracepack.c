@@ -0,0 +1,103 @@
+/*
+ * tracepack.c - Convert lackey text traces to the compact binary trace
+ *     format read by csim, and back.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "tracefmt.h"
+
+/*
+ * usage - Print usage info
+ */
+void usage(char* argv[])
+{
+    printf("Usage: %s [-hd] -i <in> -o <out>\n", argv[0]);
+    printf("Options:\n");
+    printf("  -h         Print this help message.\n");
+    printf("  -d         Decode a binary trace back to lackey text.\n");
+    printf("  -i <file>  Input trace (text or binary).\n");
+    printf("  -o <file>  Output trace.\n");
+    printf("Example: %s -i traces/long.trace -o long.btrace\n", argv[0]);
+}
+
+int main(int argc, char* argv[])
+{
+    char c;
+    int decode = 0, rc;
+    char *in_file = NULL, *out_file = NULL;
+    long long records = 0;
+    long out_size;
+    struct stat st;
+    trace_reader_t* tr;
+    trace_writer_t tw;
+    trace_rec_t rec;
+    FILE* out_fp;
+
+    while ((c = getopt(argc, argv, "hdi:o:")) != -1) {
+        switch (c) {
+        case 'd': decode = 1; break;
+        case 'i': in_file = optarg; break;
+        case 'o': out_file = optarg; break;
+        case 'h': usage(argv); exit(0);
+        default: usage(argv); exit(1);
+        }
+    }
+    if (in_file == NULL || out_file == NULL) {
+        printf("Error: Missing required argument\n");
+        usage(argv);
+        exit(1);
+    }
+
+    tr = trace_open(in_file);
+    if (!tr) {
+        printf("Error: Cannot open %s\n", in_file);
+        exit(1);
+    }
+    out_fp = fopen(out_file, "wb");
+    if (!out_fp) {
+        printf("Error: Cannot create %s\n", out_file);
+        exit(1);
+    }
+    if (!decode && !trace_writer_init(&tw, out_fp)) {
+        printf("Error: Write to %s failed\n", out_file);
+        exit(1);
+    }
+
+    while ((rc = trace_next(tr, &rec)) > 0) {
+        int ok;
+        if (!rec.op || !strchr("ILSM", rec.op)) {
+            printf("Error: Malformed trace %s: record %lld has unknown op '%c'\n",
+                   in_file, records + 1, rec.op);
+            exit(1);
+        }
+        if (decode)
+            ok = fprintf(out_fp, rec.op == 'I' ? "%c  %08llx,%d\n" : " %c %08llx,%d\n",
+                         rec.op, rec.addr, rec.size) > 0;
+        else
+            ok = trace_write(&tw, &rec);
+        if (!ok) {
+            printf("Error: Write to %s failed\n", out_file);
+            exit(1);
+        }
+        records++;
+    }
+    if (rc < 0) {
+        printf("Error: Malformed trace %s after %lld records\n", in_file, records);
+        exit(1);
+    }
+
+    out_size = ftell(out_fp);
+    fclose(out_fp);
+    trace_close(tr);
+    stat(in_file, &st);
+
+    printf("%lld records: %ld -> %ld bytes (%.2fx, %.2f bytes/record)\n",
+           records, (long)st.st_size, out_size,
+           out_size ? (double)st.st_size / out_size : 0.0,
+           records ? (double)out_size / records : 0.0);
+    return 0;
+}
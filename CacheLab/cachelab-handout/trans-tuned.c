@@ -0,0 +1,79 @@
+/*
+ * trans-tuned.c - Transpose kernels chosen by transtune for a
+ *     32-set, 1-way cache with 32-byte blocks (-s 5 -E 1 -b 5).
+ *     Generated file: rerun transtune -o trans-tuned.c to change it.
+ *     test-trans evaluates them next to trans.c's functions; they
+ *     call trans_blocked() and are not part of the handin.
+ */
+#include "cachelab.h"
+
+/* 61x67: 1720 misses, compulsory 1022, row-wise scan 4420, trans_recursive 1749; more than 12 locals */
+char trans_tuned_61x67_desc[] = "Tuned 61x67: 8x8 blocks, 8x8 tiles in 64 locals";
+void trans_tuned_61x67(int M, int N, int A[N][M], int B[M][N])
+{
+    trans_blocked(M, N, A, B, 8, 8, TRANS_BLOCK_ROWS, TRANS_TILE8);
+}
+
+/* 48x48: 576 misses, compulsory 576, row-wise scan 2660, trans_recursive 943; more than 12 locals */
+char trans_tuned_48x48_desc[] = "Tuned 48x48: 8x8 blocks, 8x8 tiles in 64 locals";
+void trans_tuned_48x48(int M, int N, int A[N][M], int B[M][N])
+{
+    trans_blocked(M, N, A, B, 8, 8, TRANS_BLOCK_ROWS, TRANS_TILE8);
+}
+
+/* 96x96: 2304 misses, compulsory 2304, row-wise scan 10620, trans_recursive 3850; more than 12 locals */
+char trans_tuned_96x96_desc[] = "Tuned 96x96: 8x8 blocks, 8x8 tiles in 64 locals";
+void trans_tuned_96x96(int M, int N, int A[N][M], int B[M][N])
+{
+    trans_blocked(M, N, A, B, 8, 8, TRANS_BLOCK_ROWS, TRANS_TILE8);
+}
+
+/* 128x128: 4096 misses, compulsory 4096, row-wise scan 18880, trans_recursive 4096; more than 12 locals */
+char trans_tuned_128x128_desc[] = "Tuned 128x128: 8x8 blocks, 8x8 tiles in 64 locals";
+void trans_tuned_128x128(int M, int N, int A[N][M], int B[M][N])
+{
+    trans_blocked(M, N, A, B, 8, 8, TRANS_BLOCK_ROWS, TRANS_TILE8);
+}
+
+/* 256x256: 16384 misses, compulsory 16384, row-wise scan 75520, trans_recursive 16384; more than 12 locals */
+char trans_tuned_256x256_desc[] = "Tuned 256x256: 8x8 blocks, 8x8 tiles in 64 locals";
+void trans_tuned_256x256(int M, int N, int A[N][M], int B[M][N])
+{
+    trans_blocked(M, N, A, B, 8, 8, TRANS_BLOCK_ROWS, TRANS_TILE8);
+}
+
+/* 100x37: 1391 misses, compulsory 926, row-wise scan 4265, trans_recursive 1663; more than 12 locals */
+char trans_tuned_100x37_desc[] = "Tuned 100x37: 8x8 blocks, 8x8 tiles in 64 locals";
+void trans_tuned_100x37(int M, int N, int A[N][M], int B[M][N])
+{
+    trans_blocked(M, N, A, B, 8, 8, TRANS_BLOCK_COLS, TRANS_TILE8);
+}
+
+/* 37x100: 1404 misses, compulsory 926, row-wise scan 2476, trans_recursive 1666; more than 12 locals */
+char trans_tuned_37x100_desc[] = "Tuned 37x100: 8x8 blocks, 8x8 tiles in 64 locals";
+void trans_tuned_37x100(int M, int N, int A[N][M], int B[M][N])
+{
+    trans_blocked(M, N, A, B, 8, 8, TRANS_BLOCK_ROWS, TRANS_TILE8);
+}
+
+/*
+ * registerTunedFunctions - Register the tuned kernel for an MxN
+ *     transpose with the driver, if there is one
+ */
+void registerTunedFunctions(int M, int N)
+{
+    if (M == 61 && N == 67)
+        registerTransFunction(trans_tuned_61x67, trans_tuned_61x67_desc);
+    if (M == 48 && N == 48)
+        registerTransFunction(trans_tuned_48x48, trans_tuned_48x48_desc);
+    if (M == 96 && N == 96)
+        registerTransFunction(trans_tuned_96x96, trans_tuned_96x96_desc);
+    if (M == 128 && N == 128)
+        registerTransFunction(trans_tuned_128x128, trans_tuned_128x128_desc);
+    if (M == 256 && N == 256)
+        registerTransFunction(trans_tuned_256x256, trans_tuned_256x256_desc);
+    if (M == 100 && N == 37)
+        registerTransFunction(trans_tuned_100x37, trans_tuned_100x37_desc);
+    if (M == 37 && N == 100)
+        registerTransFunction(trans_tuned_37x100, trans_tuned_37x100_desc);
+}
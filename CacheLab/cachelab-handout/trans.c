@@ -110,14 +110,34 @@ void transpose_submit(int M, int N, int A[N][M], int B[M][N])
             }
         }
     }
-    else if(M == 61 && N == 67){
-        for (i = 0; i < N; i += 16) {
-            for (j = 0; j < M; j += 16) {
-                for (k = i; k < i + 16 && k < N; k++) {
-                    for (l = j; l < j + 16 && l < M; l++) {
-                        B[l][k] = A[k][l];
-                    }
-                }
+    else {
+        /* 61x67 and any other shape: strips of 8 columns of A, each
+           row segment read into locals before it is written to B
+           (61x67: 1758 misses, compulsory 1022) */
+        for (j = 0; j + 8 <= M; j += 8) {
+            for (k = 0; k < N; k++) {
+                v0 = A[k][j];
+                v1 = A[k][j + 1];
+                v2 = A[k][j + 2];
+                v3 = A[k][j + 3];
+                v4 = A[k][j + 4];
+                v5 = A[k][j + 5];
+                v6 = A[k][j + 6];
+                v7 = A[k][j + 7];
+
+                B[j][k] = v0;
+                B[j + 1][k] = v1;
+                B[j + 2][k] = v2;
+                B[j + 3][k] = v3;
+                B[j + 4][k] = v4;
+                B[j + 5][k] = v5;
+                B[j + 6][k] = v6;
+                B[j + 7][k] = v7;
+            }
+        }
+        for (k = 0; k < N; k++) {
+            for (l = j; l < M; l++) {
+                B[l][k] = A[k][l];
             }
         }
     }
@@ -128,6 +148,97 @@ void transpose_submit(int M, int N, int A[N][M], int B[M][N])
  * a simple one below to help you get started. 
  */ 
 
+/* Load row r of the tile at A[i][j] into t<r>0..t<r>7, up to w of them */
+#define TILE_LOAD(r)                                                        \
+    if (h > r) {                                                            \
+        t##r##0 = A[i + r][j];                                              \
+        if (w > 1) t##r##1 = A[i + r][j + 1];                               \
+        if (w > 2) t##r##2 = A[i + r][j + 2];                               \
+        if (w > 3) t##r##3 = A[i + r][j + 3];                               \
+        if (w > 4) t##r##4 = A[i + r][j + 4];                               \
+        if (w > 5) t##r##5 = A[i + r][j + 5];                               \
+        if (w > 6) t##r##6 = A[i + r][j + 6];                               \
+        if (w > 7) t##r##7 = A[i + r][j + 7];                               \
+    }
+
+/* Store column c of the tile, t0<c>..t7<c>, as row j + c of B */
+#define TILE_STORE(c)                                                       \
+    if (w > c) {                                                            \
+        B[j + c][i] = t0##c;                                                \
+        if (h > 1) B[j + c][i + 1] = t1##c;                                 \
+        if (h > 2) B[j + c][i + 2] = t2##c;                                 \
+        if (h > 3) B[j + c][i + 3] = t3##c;                                 \
+        if (h > 4) B[j + c][i + 4] = t4##c;                                 \
+        if (h > 5) B[j + c][i + 5] = t5##c;                                 \
+        if (h > 6) B[j + c][i + 6] = t6##c;                                 \
+        if (h > 7) B[j + c][i + 7] = t7##c;                                 \
+    }
+
+/*
+ * trans_tile - Transpose the h x w tile of A at A[i][j] (h, w <= 8)
+ *     in 64 locals: the whole tile is read from A before any of it is
+ *     written to B. When every row of A in the tile shares one cache
+ *     set, and every row of B too (256x256), this is the only order
+ *     that touches each block of A and of B once. Also used by the
+ *     TRANS_TILE8 strategy of transblock.c.
+ */
+void trans_tile(int M, int N, int A[N][M], int B[M][N],
+                int i, int j, int h, int w)
+{
+    int t00, t01, t02, t03, t04, t05, t06, t07,
+        t10, t11, t12, t13, t14, t15, t16, t17,
+        t20, t21, t22, t23, t24, t25, t26, t27,
+        t30, t31, t32, t33, t34, t35, t36, t37,
+        t40, t41, t42, t43, t44, t45, t46, t47,
+        t50, t51, t52, t53, t54, t55, t56, t57,
+        t60, t61, t62, t63, t64, t65, t66, t67,
+        t70, t71, t72, t73, t74, t75, t76, t77;
+
+    TILE_LOAD(0) TILE_LOAD(1) TILE_LOAD(2) TILE_LOAD(3)
+    TILE_LOAD(4) TILE_LOAD(5) TILE_LOAD(6) TILE_LOAD(7)
+
+    TILE_STORE(0) TILE_STORE(1) TILE_STORE(2) TILE_STORE(3)
+    TILE_STORE(4) TILE_STORE(5) TILE_STORE(6) TILE_STORE(7)
+}
+
+/*
+ * trans_rec - Transpose the h x w region of A at A[i][j] by halving its
+ *     longer side until the region fits a tile
+ */
+static void trans_rec(int M, int N, int A[N][M], int B[M][N],
+                      int i, int j, int h, int w)
+{
+    if (h <= 8 && w <= 8) {
+        trans_tile(M, N, A, B, i, j, h, w);
+    }
+    else if (h >= w) {
+        trans_rec(M, N, A, B, i, j, h / 2, w);
+        trans_rec(M, N, A, B, i + h / 2, j, h - h / 2, w);
+    }
+    else {
+        trans_rec(M, N, A, B, i, j, h, w / 2);
+        trans_rec(M, N, A, B, i, j + w / 2, h, w - w / 2);
+    }
+}
+
+/*
+ * trans_recursive - Cache-oblivious divide-and-conquer transpose for
+ *     any shape. Splits are plain halves and the recursion knows
+ *     nothing of the cache; the 8x8 tile is register blocking only.
+ *     Misses on the lab's cache, against the compulsory ones:
+ *     32x32: 256 (256), 64x64: 1024 (1024), 128x128: 4096 (4096),
+ *     256x256: 16384 (16384), 61x67: 1749 (1022), 48x48: 943 (576),
+ *     100x37: 1663 (926). When a side is not a power of two, the
+ *     halves stop lining up with cache blocks and tiles share them.
+ *     The 64 locals and the recursion are outside the lab's rules (at
+ *     most 12 int locals), so it is not used by transpose_submit.
+ */
+char trans_recursive_desc[] = "Cache-oblivious recursive transpose";
+void trans_recursive(int M, int N, int A[N][M], int B[M][N])
+{
+    trans_rec(M, N, A, B, 0, 0, N, M);
+}
+
 /* 
  * trans - A simple baseline transpose function, not optimized for the cache.
  */
@@ -159,6 +270,7 @@ void registerFunctions()
 
     /* Register any additional transpose functions */
     registerTransFunction(trans, trans_desc); 
+    registerTransFunction(trans_recursive, trans_recursive_desc); 
 
 }
 
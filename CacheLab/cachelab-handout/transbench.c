@@ -0,0 +1,284 @@
+/*
+ * transbench.c - Measure native transpose throughput in GB/s
+ *
+ * Each kernel is timed on the given shape (or a default set of shapes)
+ * and checked against a plain loop. Throughput counts the bytes read
+ * from A plus the bytes written to B. memcpy of the same amount of data
+ * is reported as a bandwidth ceiling.
+ *
+ * With -t, transbench instead times the parallel kernels on 1, 2, 4, ...
+ * up to the given number of threads and reports the speedup over one.
+ * B is first-touched by the pool at the largest thread count, so that
+ * on a NUMA machine each thread's slab of B is on its own node.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <time.h>
+#include "fasttrans.h"
+
+/* Keep timing a kernel until at least this many seconds have passed */
+#define MIN_SECS 0.25
+
+static const int default_shapes[][2] = {
+    { 64, 64 }, { 256, 256 }, { 1000, 1000 }, { 1024, 1024 },
+    { 4096, 4096 }, { 3000, 1000 }
+};
+#define NDEFAULT_SHAPES ((int)(sizeof(default_shapes) / sizeof(default_shapes[0])))
+
+/* Shape for the scaling runs when none is given */
+#define SCALING_DIM 8192
+
+/* Thread count for the parallel kernels */
+static int bench_threads = 1;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * naive - Row-wise scan of A, as a baseline
+ */
+static void naive(int M, int N, const int* A, int* B)
+{
+    int i, j;
+    for (i = 0; i < N; i++)
+        for (j = 0; j < M; j++)
+            B[(size_t)j * N + i] = A[(size_t)i * M + j];
+}
+
+static void copy(int M, int N, const int* A, int* B)
+{
+    memcpy(B, A, (size_t)M * N * sizeof(int));
+}
+
+static void parallel(int M, int N, const int* A, int* B)
+{
+    fasttrans_parallel(M, N, A, B, bench_threads);
+}
+
+/* In-place kernels transpose B, which starts out as a copy of A */
+static void inplace(int M, int N, const int* A, int* B)
+{
+    fasttrans_inplace(M, N, B);
+}
+
+static void inplace_parallel(int M, int N, const int* A, int* B)
+{
+    fasttrans_square_inplace_parallel(N, B, bench_threads);
+}
+
+/*
+ * time_kernel - Best time of repeated runs of f, in seconds
+ */
+static double time_kernel(void (*f)(int, int, const int*, int*),
+                          int M, int N, const int* A, int* B)
+{
+    double best = 1e30, start = now(), t;
+
+    f(M, N, A, B); /* warm up caches and page tables */
+    do {
+        t = now();
+        f(M, N, A, B);
+        t = now() - t;
+        if (t < best)
+            best = t;
+    } while (now() - start < MIN_SECS);
+    return best;
+}
+
+static int check(int M, int N, const int* A, const int* B)
+{
+    int i, j;
+    for (i = 0; i < N; i++)
+        for (j = 0; j < M; j++)
+            if (B[(size_t)j * N + i] != A[(size_t)i * M + j])
+                return 0;
+    return 1;
+}
+
+/*
+ * check_inplace - Run an in-place kernel once on a copy of A and check it
+ */
+static int check_inplace(void (*f)(int, int, const int*, int*),
+                         int M, int N, const int* A, int* B)
+{
+    memcpy(B, A, (size_t)M * N * sizeof(int));
+    f(M, N, A, B);
+    return check(M, N, A, B);
+}
+
+static void report(const char* name, int M, int N, double secs)
+{
+    double bytes = 2.0 * M * N * sizeof(int);
+    printf("  %-8s %10.3f us %8.2f GB/s\n", name, secs * 1e6, bytes / secs / 1e9);
+}
+
+static int bench_shape(int M, int N, int only_isa)
+{
+    size_t n = (size_t)M * N, i;
+    int *A, *B, isa, ok = 1;
+
+    if (posix_memalign((void**)&A, 64, n * sizeof(int)) ||
+        posix_memalign((void**)&B, 64, n * sizeof(int))) {
+        printf("Error: Cannot allocate %dx%d matrices\n", M, N);
+        return 0;
+    }
+    for (i = 0; i < n; i++)
+        A[i] = (int)(i * 2654435761u);
+
+    printf("%dx%d (%.1f MB per matrix)\n", M, N, n * sizeof(int) / 1048576.0);
+    report("memcpy", M, N, time_kernel(copy, M, N, A, B));
+    report("naive", M, N, time_kernel(naive, M, N, A, B));
+    for (isa = FT_ISA_SCALAR; isa < FT_NISAS; isa++) {
+        if ((only_isa != FT_ISA_AUTO && isa != only_isa) || !fasttrans_set_isa(isa))
+            continue;
+        memset(B, 0, n * sizeof(int));
+        report(fasttrans_isa_name(isa), M, N, time_kernel(fasttrans, M, N, A, B));
+        if (!check(M, N, A, B)) {
+            printf("Error: %s kernel gives a wrong transpose\n", fasttrans_isa_name(isa));
+            ok = 0;
+        }
+    }
+    if (only_isa == FT_ISA_AUTO)
+        fasttrans_set_isa(FT_ISA_AUTO);
+    memcpy(B, A, n * sizeof(int));
+    report("inplace", M, N, time_kernel(inplace, M, N, A, B));
+    if (!check_inplace(inplace, M, N, A, B)) {
+        printf("Error: In-place kernel gives a wrong transpose\n");
+        ok = 0;
+    }
+    free(A);
+    free(B);
+    return ok;
+}
+
+/*
+ * bench_scaling - Time the parallel kernels on 1, 2, 4, ... maxthreads
+ *     threads, with the fastest instruction set
+ */
+static int bench_scaling(int M, int N, int maxthreads)
+{
+    size_t n = (size_t)M * N, i;
+    int *A, *B, t, ok = 1;
+    double base = 0, base_ip = 0, secs;
+
+    if (posix_memalign((void**)&A, 64, n * sizeof(int)) ||
+        posix_memalign((void**)&B, 64, n * sizeof(int))) {
+        printf("Error: Cannot allocate %dx%d matrices\n", M, N);
+        return 0;
+    }
+    for (i = 0; i < n; i++)
+        A[i] = (int)(i * 2654435761u);
+    /* Place B's pages before any run, as maxthreads threads write it */
+    fasttrans_first_touch(M, N, B, maxthreads);
+
+    printf("%dx%d (%.1f MB per matrix), %s kernel\n", M, N,
+           n * sizeof(int) / 1048576.0, fasttrans_isa_name(fasttrans_isa()));
+    printf("  threads   out-of-place        speedup   in-place            speedup\n");
+    for (t = 1; ; t = (t * 2 > maxthreads && t < maxthreads) ? maxthreads : t * 2) {
+        bench_threads = t;
+        secs = time_kernel(parallel, M, N, A, B);
+        if (t == 1)
+            base = secs;
+        printf("  %7d %8.2f GB/s %10.2fx", t, 2.0 * n * sizeof(int) / secs / 1e9, base / secs);
+        if (!check(M, N, A, B)) {
+            printf("\nError: Parallel kernel gives a wrong transpose on %d threads\n", t);
+            ok = 0;
+        }
+        if (M == N) {
+            memcpy(B, A, n * sizeof(int));
+            secs = time_kernel(inplace_parallel, M, N, A, B);
+            if (t == 1)
+                base_ip = secs;
+            printf("   %8.2f GB/s %10.2fx", 2.0 * n * sizeof(int) / secs / 1e9, base_ip / secs);
+            if (!check_inplace(inplace_parallel, N, N, A, B)) {
+                printf("\nError: Parallel in-place kernel gives a wrong transpose on %d threads\n", t);
+                ok = 0;
+            }
+        }
+        printf("\n");
+        if (t >= maxthreads)
+            break;
+    }
+    free(A);
+    free(B);
+    return ok;
+}
+
+/*
+ * usage - Print usage info
+ */
+static void usage(char* argv[])
+{
+    printf("Usage: %s [-h] [-M <cols> -N <rows>] [-i <isa>] [-t <threads>]\n", argv[0]);
+    printf("Options:\n");
+    printf("  -h         Print this help message.\n");
+    printf("  -M <cols>  Number of matrix columns.\n");
+    printf("  -N <rows>  Number of matrix rows.\n");
+    printf("  -i <isa>   Only time one kernel: scalar, sse2 or avx2.\n");
+    printf("  -t <num>   Time the parallel kernels on 1 to num threads (0: all CPUs).\n");
+    printf("Examples: %s -M 4096 -N 4096\n", argv[0]);
+    printf("          %s -t 0 -M 16384 -N 16384\n", argv[0]);
+}
+
+int main(int argc, char* argv[])
+{
+    char c;
+    int M = 0, N = 0, only_isa = FT_ISA_AUTO, i, ok = 1, maxthreads = -1;
+
+    while ((c = getopt(argc, argv, "hM:N:i:t:")) != -1) {
+        switch (c) {
+        case 'M': M = atoi(optarg); break;
+        case 'N': N = atoi(optarg); break;
+        case 'i':
+            for (only_isa = FT_ISA_SCALAR; only_isa < FT_NISAS; only_isa++)
+                if (strcmp(optarg, fasttrans_isa_name(only_isa)) == 0)
+                    break;
+            if (only_isa == FT_NISAS) {
+                usage(argv);
+                exit(1);
+            }
+            break;
+        case 't': maxthreads = atoi(optarg); break;
+        case 'h': usage(argv); exit(0);
+        default: usage(argv); exit(1);
+        }
+    }
+    if (only_isa != FT_ISA_AUTO && !fasttrans_isa_supported(only_isa)) {
+        printf("Error: This CPU does not support %s\n", fasttrans_isa_name(only_isa));
+        exit(1);
+    }
+    fasttrans_set_isa(FT_ISA_AUTO);
+    printf("Best kernel on this CPU: %s\n", fasttrans_isa_name(fasttrans_isa()));
+
+    if (maxthreads >= 0) {
+        if (maxthreads == 0)
+            maxthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        if (maxthreads > FT_MAX_THREADS) {
+            printf("Warning: -t %d is more than %d threads; using %d\n",
+                   maxthreads, FT_MAX_THREADS, FT_MAX_THREADS);
+            maxthreads = FT_MAX_THREADS;
+        }
+        if (maxthreads < 1)
+            maxthreads = 1;
+        if (only_isa != FT_ISA_AUTO)
+            fasttrans_set_isa(only_isa);
+        if (M <= 0 || N <= 0)
+            M = N = SCALING_DIM;
+        return bench_scaling(M, N, maxthreads) ? 0 : 1;
+    }
+
+    if (M > 0 && N > 0)
+        ok = bench_shape(M, N, only_isa);
+    else
+        for (i = 0; i < NDEFAULT_SHAPES; i++)
+            ok &= bench_shape(default_shapes[i][0], default_shapes[i][1], only_isa);
+    return ok ? 0 : 1;
+}
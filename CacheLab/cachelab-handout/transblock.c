@@ -0,0 +1,230 @@
+/*
+ * transblock.c - Blocked transpose kernels for transtune
+ *
+ * trans_blocked() transposes block by block, with the block shape,
+ * the order of the blocks and the strategy inside a block as
+ * parameters. transtune searches over them, and the kernels it writes
+ * to trans-tuned.c call it. It is kept out of trans.c so that the
+ * handed-in trans.c builds against the stock cachelab.h. Like trans.c,
+ * this file is compiled plain (transblock.o) for tracegen and
+ * instrumented (transblock-sim.o) for test-trans and transtune.
+ *
+ * Every strategy but TRANS_TILE8 keeps to the lab's 12 int locals;
+ * TRANS_TILE8 holds a whole 8x8 tile, with trans_tile() from trans.c.
+ */
+#include "cachelab.h"
+
+/*
+ * trans_block - Transpose the w x h block of A whose top-left element
+ *     is A[i][j], using one of the TRANS_* strategies in cachelab.h.
+ */
+static void trans_block(int M, int N, int A[N][M], int B[M][N],
+                        int i, int j, int w, int h, int strategy)
+{
+    int k, l, d, v0, v1, v2, v3, v4, v5, v6, v7;
+
+    if ((strategy == TRANS_SPLIT8 || strategy == TRANS_QUAD4) && (w != 8 || h != 8))
+        strategy = TRANS_ROWS_REGS;
+
+    switch (strategy) {
+    case TRANS_COLS:
+        for (l = j; l < j + w; l++)
+            for (k = i; k < i + h; k++)
+                B[l][k] = A[k][l];
+        break;
+
+    case TRANS_ROWS_DEFER:
+        /* A[k][k] and B[k][k] share a set, so store it after the row */
+        for (k = i; k < i + h; k++) {
+            d = -1;
+            v0 = 0;
+            for (l = j; l < j + w; l++) {
+                if (l == k) {
+                    d = l;
+                    v0 = A[k][l];
+                }
+                else {
+                    B[l][k] = A[k][l];
+                }
+            }
+            if (d >= 0)
+                B[d][k] = v0;
+        }
+        break;
+
+    case TRANS_ROWS_REGS:
+        /* Read a whole row segment before writing any of B (w <= 8) */
+        v1 = v2 = v3 = v4 = v5 = v6 = v7 = 0;
+        for (k = i; k < i + h; k++) {
+            v0 = A[k][j];
+            if (w > 1) v1 = A[k][j + 1];
+            if (w > 2) v2 = A[k][j + 2];
+            if (w > 3) v3 = A[k][j + 3];
+            if (w > 4) v4 = A[k][j + 4];
+            if (w > 5) v5 = A[k][j + 5];
+            if (w > 6) v6 = A[k][j + 6];
+            if (w > 7) v7 = A[k][j + 7];
+
+            B[j][k] = v0;
+            if (w > 1) B[j + 1][k] = v1;
+            if (w > 2) B[j + 2][k] = v2;
+            if (w > 3) B[j + 3][k] = v3;
+            if (w > 4) B[j + 4][k] = v4;
+            if (w > 5) B[j + 5][k] = v5;
+            if (w > 6) B[j + 6][k] = v6;
+            if (w > 7) B[j + 7][k] = v7;
+        }
+        break;
+
+    case TRANS_SPLIT8:
+        /* Same scheme as the 64x64 case of transpose_submit */
+        for (k = i; k < i + 4; k++) {
+            v0 = A[k][j];
+            v1 = A[k][j + 1];
+            v2 = A[k][j + 2];
+            v3 = A[k][j + 3];
+            v4 = A[k][j + 4];
+            v5 = A[k][j + 5];
+            v6 = A[k][j + 6];
+            v7 = A[k][j + 7];
+
+            B[j][k] = v0;
+            B[j + 1][k] = v1;
+            B[j + 2][k] = v2;
+            B[j + 3][k] = v3;
+
+            B[j][k + 4] = v4;
+            B[j + 1][k + 4] = v5;
+            B[j + 2][k + 4] = v6;
+            B[j + 3][k + 4] = v7;
+        }
+
+        for (k = j; k < j + 4; k++) {
+            v4 = A[i + 4][k];
+            v5 = A[i + 5][k];
+            v6 = A[i + 6][k];
+            v7 = A[i + 7][k];
+
+            v0 = B[k][i + 4];
+            v1 = B[k][i + 5];
+            v2 = B[k][i + 6];
+            v3 = B[k][i + 7];
+
+            B[k][i + 4] = v4;
+            B[k][i + 5] = v5;
+            B[k][i + 6] = v6;
+            B[k][i + 7] = v7;
+
+            B[k + 4][i] = v0;
+            B[k + 4][i + 1] = v1;
+            B[k + 4][i + 2] = v2;
+            B[k + 4][i + 3] = v3;
+        }
+
+        for (k = i + 4; k < i + 8; k++) {
+            v4 = A[k][j + 4];
+            v5 = A[k][j + 5];
+            v6 = A[k][j + 6];
+            v7 = A[k][j + 7];
+
+            B[j + 4][k] = v4;
+            B[j + 5][k] = v5;
+            B[j + 6][k] = v6;
+            B[j + 7][k] = v7;
+        }
+        break;
+
+    case TRANS_QUAD4:
+        /* 4x4 quadrants, visited so that consecutive ones share rows
+           of A or rows of B */
+        trans_block(M, N, A, B, i, j, 4, 4, TRANS_ROWS_REGS);
+        trans_block(M, N, A, B, i, j + 4, 4, 4, TRANS_ROWS_REGS);
+        trans_block(M, N, A, B, i + 4, j + 4, 4, 4, TRANS_ROWS_REGS);
+        trans_block(M, N, A, B, i + 4, j, 4, 4, TRANS_ROWS_REGS);
+        break;
+
+    case TRANS_PAIRS:
+        /* 2x4 tiles in locals: when every row of A in the block shares
+           a set, and every row of B too, a tile costs 2 misses on A and
+           4 on B for 8 elements, where a row segment costs 1 + 8 */
+        v1 = v2 = v3 = v4 = v5 = v6 = v7 = 0;
+        for (k = i; k < i + h; k += 2) {
+            for (l = j; l < j + w; l += 4) {
+                d = (k + 1 < i + h);
+                v0 = A[k][l];
+                if (l + 1 < j + w) v1 = A[k][l + 1];
+                if (l + 2 < j + w) v2 = A[k][l + 2];
+                if (l + 3 < j + w) v3 = A[k][l + 3];
+                if (d) {
+                    v4 = A[k + 1][l];
+                    if (l + 1 < j + w) v5 = A[k + 1][l + 1];
+                    if (l + 2 < j + w) v6 = A[k + 1][l + 2];
+                    if (l + 3 < j + w) v7 = A[k + 1][l + 3];
+                }
+
+                B[l][k] = v0;
+                if (d) B[l][k + 1] = v4;
+                if (l + 1 < j + w) {
+                    B[l + 1][k] = v1;
+                    if (d) B[l + 1][k + 1] = v5;
+                }
+                if (l + 2 < j + w) {
+                    B[l + 2][k] = v2;
+                    if (d) B[l + 2][k + 1] = v6;
+                }
+                if (l + 3 < j + w) {
+                    B[l + 3][k] = v3;
+                    if (d) B[l + 3][k + 1] = v7;
+                }
+            }
+        }
+        break;
+
+    case TRANS_TILE8:
+        trans_tile(M, N, A, B, i, j, h, w);
+        break;
+
+    default: /* TRANS_ROWS */
+        for (k = i; k < i + h; k++)
+            for (l = j; l < j + w; l++)
+                B[l][k] = A[k][l];
+        break;
+    }
+}
+
+/*
+ * trans_blocked - Blocked transpose with bw x bh blocks of A, visited
+ *     in block_order, each transposed with the given strategy. This is
+ *     the kernel that transtune searches over.
+ */
+void trans_blocked(int M, int N, int A[N][M], int B[M][N],
+                   int bw, int bh, int block_order, int strategy)
+{
+    int i, j, w, h;
+
+    if (strategy == TRANS_ROWS_REGS && bw > 8)
+        bw = 8;
+    if (strategy == TRANS_TILE8) {
+        bw = bw > 8 ? 8 : bw;
+        bh = bh > 8 ? 8 : bh;
+    }
+
+    if (block_order == TRANS_BLOCK_COLS) {
+        for (j = 0; j < M; j += bw) {
+            for (i = 0; i < N; i += bh) {
+                w = (M - j < bw) ? M - j : bw;
+                h = (N - i < bh) ? N - i : bh;
+                trans_block(M, N, A, B, i, j, w, h, strategy);
+            }
+        }
+    }
+    else {
+        for (i = 0; i < N; i += bh) {
+            for (j = 0; j < M; j += bw) {
+                w = (M - j < bw) ? M - j : bw;
+                h = (N - i < bh) ? N - i : bh;
+                trans_block(M, N, A, B, i, j, w, h, strategy);
+            }
+        }
+    }
+}
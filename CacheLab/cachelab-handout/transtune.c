@@ -0,0 +1,308 @@
+/*
+ * transtune.c - Autotuner for blocked transpose kernels
+ *
+ * For each requested MxN shape, transtune runs trans_blocked() from the
+ * instrumented transblock.c (transblock-sim.o) over a grid of block
+ * widths and heights, block orders and in-block strategies, counts the
+ * misses of each candidate with the embedded cache model, and keeps
+ * the best. The best is reported next to the compulsory misses and
+ * those of trans_recursive(). With the lab's 12 int locals the gap
+ * stays large when a row of the matrix is a multiple of the cache size
+ * (256x256); TRANS_TILE8 closes it with 64 locals, so its kernels are
+ * marked as outside the rules, and -r leaves it out. With -o it writes trans-tuned.c, which registers one
+ * kernel per shape with test-trans. transpose_submit() does not call
+ * them: a kernel has to be copied into trans.c to be graded.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <unistd.h>
+#include "cachelab.h"
+#include "cachesim.h"
+#include "traceinst.h"
+
+/* Maximum array dimension, as in tracegen.c */
+#define MAXN 256
+
+/* Maximum number of shapes on one command line */
+#define MAX_SHAPES 64
+
+static const int block_sizes[] = { 1, 2, 4, 6, 8, 12, 16, 20, 24, 32, 64 };
+#define NBLOCK_SIZES ((int)(sizeof(block_sizes) / sizeof(block_sizes[0])))
+
+static const char* strategy_names[TRANS_NSTRATEGIES] = {
+    "TRANS_ROWS", "TRANS_COLS", "TRANS_ROWS_DEFER", "TRANS_ROWS_REGS", "TRANS_SPLIT8",
+    "TRANS_QUAD4", "TRANS_PAIRS", "TRANS_TILE8"
+};
+static const char* strategy_descs[TRANS_NSTRATEGIES] = {
+    "row-wise", "column-wise", "deferred diagonal", "row registers", "8x8 split",
+    "4x4 quadrants", "2x4 register tiles", "8x8 tiles in 64 locals"
+};
+
+typedef struct {
+    int bw, bh, block_order, strategy;
+    unsigned int misses;
+    unsigned long long accesses;
+} candidate_t;
+
+typedef struct {
+    int M, N;
+    candidate_t best;
+    unsigned int baseline;    /* misses of the simple row-wise scan */
+    unsigned int compulsory;  /* one miss per block of A and of B */
+    unsigned int recursive;   /* misses of trans_recursive() */
+} shape_t;
+
+/* Matrices, page aligned like test-trans so the set mapping agrees */
+static struct {
+    int A[MAXN][MAXN];
+    int B[MAXN][MAXN];
+} mats __attribute__((aligned(4096)));
+
+static int verbose = 0;
+static int rules_only = 0; /* -r: only strategies with at most 12 int locals */
+
+/*
+ * is_transpose_of - Check that B holds the transpose of A
+ */
+static int is_transpose_of(int M, int N, int A[N][M], int B[M][N])
+{
+    int i, j;
+
+    for (i = 0; i < N; i++)
+        for (j = 0; j < M; j++)
+            if (A[i][j] != B[j][i])
+                return 0;
+    return 1;
+}
+
+/*
+ * evaluate - Run one candidate on an MxN shape and fill in its miss
+ *     count, or trans_recursive() if c is NULL. Returns 0 if the
+ *     result is not a correct transpose.
+ */
+static int evaluate(int M, int N, candidate_t* c, cache_sim_t* sim)
+{
+    initMatrix(M, N, mats.A, mats.B);
+
+    trace_inst_clear_ranges();
+    trace_inst_add_range(mats.A, sizeof(int) * M * N);
+    trace_inst_add_range(mats.B, sizeof(int) * M * N);
+    cache_sim_reset(sim);
+
+    trace_inst_begin(sim);
+    if (c)
+        trans_blocked(M, N, mats.A, mats.B, c->bw, c->bh, c->block_order, c->strategy);
+    else
+        trans_recursive(M, N, mats.A, mats.B);
+    trace_inst_end();
+
+    if (c) {
+        c->misses = sim->misses;
+        c->accesses = trace_inst_loads + trace_inst_stores;
+    }
+    return is_transpose_of(M, N, mats.A, mats.B);
+}
+
+/*
+ * better - Fewer misses wins; ties go to fewer accesses, then to the
+ *     simpler strategy
+ */
+static int better(const candidate_t* a, const candidate_t* b)
+{
+    if (a->misses != b->misses)
+        return a->misses < b->misses;
+    if (a->accesses != b->accesses)
+        return a->accesses < b->accesses;
+    return a->strategy < b->strategy;
+}
+
+/*
+ * tune - Search every candidate for one shape
+ */
+static void tune(shape_t* shape, cache_sim_t* sim, int b)
+{
+    int M = shape->M, N = shape->N;
+    int wi, hi, order, strategy, found = 0, tried = 0;
+    candidate_t c;
+
+    c.bw = M;
+    c.bh = N;
+    c.block_order = TRANS_BLOCK_ROWS;
+    c.strategy = TRANS_ROWS;
+    evaluate(M, N, &c, sim);
+    shape->baseline = c.misses;
+    shape->compulsory = 2 * ((4 * M * N + (1 << b) - 1) >> b);
+    if (!evaluate(M, N, NULL, sim)) {
+        printf("Error: trans_recursive gives a wrong transpose\n");
+        exit(1);
+    }
+    shape->recursive = sim->misses;
+
+    for (wi = 0; wi < NBLOCK_SIZES; wi++) {
+        for (hi = 0; hi < NBLOCK_SIZES; hi++) {
+            c.bw = block_sizes[wi];
+            c.bh = block_sizes[hi];
+            if ((c.bw > M && wi > 0 && block_sizes[wi - 1] >= M) ||
+                (c.bh > N && hi > 0 && block_sizes[hi - 1] >= N))
+                continue; /* same as a smaller block */
+            for (strategy = 0; strategy < TRANS_NSTRATEGIES; strategy++) {
+                if (strategy == TRANS_ROWS_REGS && c.bw > 8)
+                    continue;
+                if (strategy == TRANS_TILE8 && (rules_only || c.bw > 8 || c.bh > 8))
+                    continue;
+                if ((strategy == TRANS_SPLIT8 || strategy == TRANS_QUAD4) &&
+                    (c.bw != 8 || c.bh != 8))
+                    continue;
+                for (order = TRANS_BLOCK_ROWS; order <= TRANS_BLOCK_COLS; order++) {
+                    c.strategy = strategy;
+                    c.block_order = order;
+                    tried++;
+                    if (!evaluate(M, N, &c, sim)) {
+                        printf("Error: %dx%d blocks with %s give a wrong transpose\n",
+                               c.bw, c.bh, strategy_names[strategy]);
+                        exit(1);
+                    }
+                    if (verbose)
+                        printf("  %2dx%-2d %-16s %s: misses:%u\n", c.bw, c.bh,
+                               strategy_names[strategy],
+                               order == TRANS_BLOCK_COLS ? "cols" : "rows", c.misses);
+                    if (!found || better(&c, &shape->best)) {
+                        shape->best = c;
+                        found = 1;
+                    }
+                }
+            }
+        }
+    }
+
+    printf("%dx%d: %d candidates, best %dx%d blocks by %s, %s: misses:%u "
+           "(compulsory %u, row-wise scan %u, trans_recursive %u)\n",
+           M, N, tried, shape->best.bw, shape->best.bh,
+           shape->best.block_order == TRANS_BLOCK_COLS ? "columns" : "rows",
+           strategy_descs[shape->best.strategy], shape->best.misses,
+           shape->compulsory, shape->baseline, shape->recursive);
+}
+
+/*
+ * write_kernels - Emit trans-tuned.c for the tuned shapes
+ */
+static void write_kernels(FILE* fp, shape_t* shapes, int nshapes,
+                          int s, int E, int b)
+{
+    int i;
+
+    fprintf(fp, "/*\n"
+            " * trans-tuned.c - Transpose kernels chosen by transtune for a\n"
+            " *     %d-set, %d-way cache with %d-byte blocks (-s %d -E %d -b %d).\n"
+            " *     Generated file: rerun transtune -o trans-tuned.c to change it.\n"
+            " *     test-trans evaluates them next to trans.c's functions; they\n"
+            " *     call trans_blocked() and are not part of the handin.\n"
+            " */\n"
+            "#include \"cachelab.h\"\n", 1 << s, E, 1 << b, s, E, b);
+
+    for (i = 0; i < nshapes; i++) {
+        shape_t* sh = &shapes[i];
+        candidate_t* c = &sh->best;
+
+        fprintf(fp, "\n/* %dx%d: %u misses, compulsory %u, row-wise scan %u, "
+                "trans_recursive %u%s */\n",
+                sh->M, sh->N, c->misses, sh->compulsory, sh->baseline, sh->recursive,
+                c->strategy == TRANS_TILE8 ? "; more than 12 locals" : "");
+        fprintf(fp, "char trans_tuned_%dx%d_desc[] = \"Tuned %dx%d: %dx%d blocks, %s\";\n",
+                sh->M, sh->N, sh->M, sh->N, c->bw, c->bh, strategy_descs[c->strategy]);
+        fprintf(fp, "void trans_tuned_%dx%d(int M, int N, int A[N][M], int B[M][N])\n"
+                "{\n"
+                "    trans_blocked(M, N, A, B, %d, %d, %s, %s);\n"
+                "}\n",
+                sh->M, sh->N, c->bw, c->bh,
+                c->block_order == TRANS_BLOCK_COLS ? "TRANS_BLOCK_COLS" : "TRANS_BLOCK_ROWS",
+                strategy_names[c->strategy]);
+    }
+
+    fprintf(fp, "\n/*\n"
+            " * registerTunedFunctions - Register the tuned kernel for an MxN\n"
+            " *     transpose with the driver, if there is one\n"
+            " */\n"
+            "void registerTunedFunctions(int M, int N)\n"
+            "{\n");
+    for (i = 0; i < nshapes; i++)
+        fprintf(fp, "    if (M == %d && N == %d)\n"
+                "        registerTransFunction(trans_tuned_%dx%d, trans_tuned_%dx%d_desc);\n",
+                shapes[i].M, shapes[i].N, shapes[i].M, shapes[i].N,
+                shapes[i].M, shapes[i].N);
+    fprintf(fp, "}\n");
+}
+
+/*
+ * usage - Print usage info
+ */
+static void usage(char* argv[])
+{
+    printf("Usage: %s [-hvr] [-s <num> -E <num> -b <num>] [-o <file>] <M>x<N> ...\n", argv[0]);
+    printf("Options:\n");
+    printf("  -h         Print this help message.\n");
+    printf("  -v         Print the misses of every candidate.\n");
+    printf("  -r         Only strategies within the lab's 12 int locals.\n");
+    printf("  -s <num>   Number of set index bits (default 5).\n");
+    printf("  -E <num>   Number of lines per set (default 1).\n");
+    printf("  -b <num>   Number of block offset bits (default 5).\n");
+    printf("  -o <file>  Write the best kernels as C source (trans-tuned.c).\n");
+    printf("Example: %s -o trans-tuned.c 48x48 100x37\n", argv[0]);
+}
+
+int main(int argc, char* argv[])
+{
+    char c;
+    int s = 5, E = 1, b = 5, i, nshapes = 0;
+    char* out_file = NULL;
+    shape_t shapes[MAX_SHAPES];
+    cache_sim_t* sim;
+
+    while ((c = getopt(argc, argv, "hvrs:E:b:o:")) != -1) {
+        switch (c) {
+        case 'v': verbose = 1; break;
+        case 'r': rules_only = 1; break;
+        case 's': s = atoi(optarg); break;
+        case 'E': E = atoi(optarg); break;
+        case 'b': b = atoi(optarg); break;
+        case 'o': out_file = optarg; break;
+        case 'h': usage(argv); exit(0);
+        default: usage(argv); exit(1);
+        }
+    }
+
+    for (i = optind; i < argc; i++) {
+        shape_t* sh = &shapes[nshapes];
+        if (nshapes == MAX_SHAPES || sscanf(argv[i], "%dx%d", &sh->M, &sh->N) != 2 ||
+            sh->M < 1 || sh->N < 1 || sh->M > MAXN || sh->N > MAXN) {
+            printf("Error: Bad shape '%s' (at most %d shapes up to %dx%d)\n",
+                   argv[i], MAX_SHAPES, MAXN, MAXN);
+            exit(1);
+        }
+        nshapes++;
+    }
+    if (nshapes == 0 || s < 0 || E < 1 || b < 2) {
+        printf("Error: Missing required argument\n");
+        usage(argv);
+        exit(1);
+    }
+
+    sim = cache_sim_create(s, E, b);
+    for (i = 0; i < nshapes; i++)
+        tune(&shapes[i], sim, b);
+    cache_sim_free(sim);
+
+    if (out_file) {
+        FILE* fp = fopen(out_file, "w");
+        if (!fp) {
+            printf("Error: Cannot create %s\n", out_file);
+            exit(1);
+        }
+        write_kernels(fp, shapes, nshapes, s, E, b);
+        fclose(fp);
+        printf("Wrote %d kernels to %s\n", nshapes, out_file);
+    }
+    return 0;
+}
@@ -0,0 +1,262 @@
+/*
+ * CS:APP Data Lab
+ *
+ * bbench.c - Throughput of the bitsbatch.c functions
+ *
+ * For each puzzle, bbench times three ways of processing an array:
+ * calling the bits.c solution once per element, the batch version from
+ * bitsbatch.c, and the plain C expression the puzzle emulates, compiled
+ * the same way as the batch library. Batch results are first checked
+ * against the reference functions in tests.c. With -x, every unary batch
+ * function is also checked on all 2^32 inputs.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "bitsbatch.h"
+
+/* Elements per array: small enough to stay in the L1/L2 caches */
+#define NELEMS 4096
+
+/* Keep timing one loop until this many seconds have passed */
+#define MIN_SECS 0.1
+
+/* Inputs per chunk in the exhaustive check */
+#define CHUNK (1 << 16)
+
+#define BATCH __attribute__((target_clones("avx2", "default")))
+
+/* bits.c and tests.c; bits.h declares some of these with the wrong
+   number of arguments */
+int bitNor(int, int);
+int isZero(int);
+int addOK(int, int);
+int absVal(int);
+int logicalShift(int, int);
+int test_bitNor(int, int);
+int test_isZero(int);
+int test_addOK(int, int);
+int test_absVal(int);
+int test_logicalShift(int, int);
+
+typedef int (*funct1_t)(int);
+typedef int (*funct2_t)(int, int);
+typedef void (*batch1_t)(const int *, int *, size_t);
+typedef void (*batch2_t)(const int *, const int *, int *, size_t);
+
+/*
+ * The plain C operations
+ */
+BATCH static void c_bitNor(const int *restrict x, const int *restrict y, int *restrict out, size_t n)
+{
+  size_t i;
+  for (i = 0; i < n; i++)
+    out[i] = ~(x[i] | y[i]);
+}
+
+BATCH static void c_isZero(const int *restrict x, int *restrict out, size_t n)
+{
+  size_t i;
+  for (i = 0; i < n; i++)
+    out[i] = x[i] == 0;
+}
+
+BATCH static void c_addOK(const int *restrict x, const int *restrict y, int *restrict out, size_t n)
+{
+  size_t i;
+  int sum;
+  for (i = 0; i < n; i++)
+    out[i] = !__builtin_add_overflow(x[i], y[i], &sum);
+}
+
+BATCH static void c_absVal(const int *restrict x, int *restrict out, size_t n)
+{
+  size_t i;
+  for (i = 0; i < n; i++)
+    out[i] = x[i] < 0 ? (int) -(unsigned) x[i] : x[i];
+}
+
+BATCH static void c_logicalShift(const int *restrict x, const int *restrict y, int *restrict out, size_t n)
+{
+  size_t i;
+  for (i = 0; i < n; i++)
+    out[i] = (int) ((unsigned) x[i] >> y[i]);
+}
+
+typedef struct {
+  char *name;
+  int args;
+  void *scalar;     /* bits.c */
+  void *ref;        /* tests.c */
+  void *batch;      /* bitsbatch.c */
+  void *c_op;       /* the plain C operation */
+  int arg2_max;     /* second argument is masked to this */
+} bench_t;
+
+static bench_t benches[] = {
+  {"bitNor", 2, bitNor, test_bitNor, bitNor_batch, c_bitNor, -1},
+  {"isZero", 1, isZero, test_isZero, isZero_batch, c_isZero, -1},
+  {"addOK", 2, addOK, test_addOK, addOK_batch, c_addOK, -1},
+  {"absVal", 1, absVal, test_absVal, absVal_batch, c_absVal, -1},
+  {"logicalShift", 2, logicalShift, test_logicalShift, logicalShift_batch, c_logicalShift, 31},
+  {NULL, 0, NULL, NULL, NULL, NULL, 0}
+};
+
+static int xs[NELEMS], ys[NELEMS], out[NELEMS], expect[NELEMS];
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * run - Apply one of the three versions to the whole array once
+ */
+static void run(bench_t *b, int which)
+{
+  int i;
+
+  if (which == 0) {
+    if (b->args == 1)
+      for (i = 0; i < NELEMS; i++)
+        out[i] = ((funct1_t) b->scalar)(xs[i]);
+    else
+      for (i = 0; i < NELEMS; i++)
+        out[i] = ((funct2_t) b->scalar)(xs[i], ys[i]);
+  } else {
+    void *f = (which == 1) ? b->batch : b->c_op;
+    if (b->args == 1)
+      ((batch1_t) f)(xs, out, NELEMS);
+    else
+      ((batch2_t) f)(xs, ys, out, NELEMS);
+  }
+}
+
+/*
+ * time_ns - Best time per element of one version, in nanoseconds
+ */
+static double time_ns(bench_t *b, int which)
+{
+  double best = 1e30, start = now(), t;
+
+  do {
+    t = now();
+    run(b, which);
+    t = now() - t;
+    if (t < best)
+      best = t;
+  } while (now() - start < MIN_SECS);
+  return best * 1e9 / NELEMS;
+}
+
+/*
+ * check - Compare the batch version with the reference on the arrays
+ */
+static int check(bench_t *b)
+{
+  int i;
+
+  for (i = 0; i < NELEMS; i++)
+    expect[i] = (b->args == 1) ? ((funct1_t) b->ref)(xs[i])
+                               : ((funct2_t) b->ref)(xs[i], ys[i]);
+  run(b, 1);
+  for (i = 0; i < NELEMS; i++) {
+    if (out[i] != expect[i]) {
+      printf("ERROR: %s_batch(0x%x", b->name, xs[i]);
+      if (b->args == 2)
+        printf(", 0x%x", ys[i]);
+      printf(") gives 0x%x, should be 0x%x\n", out[i], expect[i]);
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/*
+ * check_all - Compare a unary batch function with the reference on
+ *     every 32-bit input
+ */
+static int check_all(bench_t *b)
+{
+  static int in[CHUNK], got[CHUNK];
+  long long base;
+  int i;
+
+  for (base = 0; base < (1LL << 32); base += CHUNK) {
+    for (i = 0; i < CHUNK; i++)
+      in[i] = (int) (unsigned) (base + i);
+    ((batch1_t) b->batch)(in, got, CHUNK);
+    for (i = 0; i < CHUNK; i++) {
+      if (got[i] != ((funct1_t) b->ref)(in[i])) {
+        printf("ERROR: %s_batch(0x%x) gives 0x%x, should be 0x%x\n",
+               b->name, in[i], got[i], ((funct1_t) b->ref)(in[i]));
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+static void usage(char *cmd)
+{
+  printf("Usage: %s [-hx] [-f <name>]\n", cmd);
+  printf("  -f <name> Benchmark only the named function\n");
+  printf("  -h        Print this message\n");
+  printf("  -x        Also check unary batch functions on all 2^32 inputs\n");
+  exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+  char c;
+  char *fname = NULL;
+  int i, exhaustive = 0, errors = 0;
+  unsigned seed = 1;
+  bench_t *b;
+
+  while ((c = getopt(argc, argv, "hxf:")) != -1) {
+    switch (c) {
+    case 'x':
+      exhaustive = 1;
+      break;
+    case 'f':
+      fname = optarg;
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+
+  /* Random inputs, with the usual corner cases at the front */
+  for (i = 0; i < NELEMS; i++) {
+    seed = seed * 1103515245 + 12345;
+    xs[i] = (int) (seed ^ (seed >> 16));
+    seed = seed * 1103515245 + 12345;
+    ys[i] = (int) (seed ^ (seed >> 16));
+  }
+  xs[0] = 0; xs[1] = 1; xs[2] = -1; xs[3] = 0x7fffffff; xs[4] = 0x80000000;
+  ys[0] = 0x80000000; ys[1] = 0x7fffffff; ys[2] = 0x80000000; ys[3] = 1; ys[4] = -1;
+
+  printf("%-14s %12s %12s %12s %9s\n", "Function", "scalar ns", "batch ns", "C op ns", "speedup");
+  for (b = benches; b->name; b++) {
+    if (fname && strcmp(fname, b->name) != 0)
+      continue;
+    if (b->arg2_max >= 0)
+      for (i = 0; i < NELEMS; i++)
+        ys[i] &= b->arg2_max;
+    if (!check(b) || (exhaustive && b->args == 1 && !check_all(b))) {
+      errors++;
+      continue;
+    }
+    {
+      double ts = time_ns(b, 0), tb = time_ns(b, 1), tc = time_ns(b, 2);
+      printf("%-14s %12.3f %12.3f %12.3f %8.1fx\n", b->name, ts, tb, tc, ts / tb);
+    }
+  }
+  return errors ? 1 : 0;
+}
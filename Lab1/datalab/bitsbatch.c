@@ -0,0 +1,60 @@
+/*
+ * CS:APP Data Lab
+ *
+ * bitsbatch.c - Array versions of the puzzles in bits.c
+ *
+ * The loop bodies are the bits.c solutions, with unsigned arithmetic
+ * wherever bits.c relies on signed overflow or on shifting ones into
+ * the sign bit. Arrays are restrict so gcc knows they do not overlap,
+ * and every function is cloned for AVX2, whose per-element shifts
+ * (vpsrlvd/vpsravd) logicalShift needs.
+ */
+#include "bitsbatch.h"
+
+#define BATCH __attribute__((target_clones("avx2", "default")))
+
+BATCH
+void bitNor_batch(const int *restrict x, const int *restrict y, int *restrict out, size_t n)
+{
+  size_t i;
+  for (i = 0; i < n; i++)
+    out[i] = (~x[i]) & (~y[i]);
+}
+
+BATCH
+void isZero_batch(const int *restrict x, int *restrict out, size_t n)
+{
+  size_t i;
+  for (i = 0; i < n; i++)
+    out[i] = !x[i];
+}
+
+BATCH
+void addOK_batch(const int *restrict x, const int *restrict y, int *restrict out, size_t n)
+{
+  size_t i;
+  for (i = 0; i < n; i++) {
+    /* Sum in unsigned arithmetic: the bits are those of x + y in bits.c */
+    int sx = x[i] >> 31, sy = y[i] >> 31;
+    int ss = (int) ((unsigned) x[i] + (unsigned) y[i]) >> 31;
+    out[i] = !(sx & sy & ~ss) & !(~sx & ~sy & ss);
+  }
+}
+
+BATCH
+void absVal_batch(const int *restrict x, int *restrict out, size_t n)
+{
+  size_t i;
+  for (i = 0; i < n; i++) {
+    int m = x[i] >> 31;
+    out[i] = (x[i] & ~m) | ((int) (~(unsigned) x[i] + 1) & m);
+  }
+}
+
+BATCH
+void logicalShift_batch(const int *restrict x, const int *restrict shift, int *restrict out, size_t n)
+{
+  size_t i;
+  for (i = 0; i < n; i++)
+    out[i] = (x[i] >> shift[i]) & (int) (0xffffffffu >> shift[i]);
+}
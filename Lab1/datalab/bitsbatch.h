@@ -0,0 +1,22 @@
+/*
+ * CS:APP Data Lab
+ *
+ * bitsbatch.h - Array versions of the puzzles in bits.c
+ *
+ * Each function applies one puzzle to n elements, using the same
+ * branch-free expressions as bits.c, and is written so that gcc
+ * vectorizes it. bitsbatch.c is built for AVX2 and for the base
+ * instruction set, and the loader picks the right one (target_clones).
+ */
+#ifndef BITSBATCH_H
+#define BITSBATCH_H
+
+#include <stddef.h>
+
+void bitNor_batch(const int *x, const int *y, int *out, size_t n);
+void isZero_batch(const int *x, int *out, size_t n);
+void addOK_batch(const int *x, const int *y, int *out, size_t n);
+void absVal_batch(const int *x, int *out, size_t n);
+void logicalShift_batch(const int *x, const int *shift, int *out, size_t n);
+
+#endif /* BITSBATCH_H */
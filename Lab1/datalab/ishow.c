@@ -1,6 +1,10 @@
 /* Display value of fixed point numbers */
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include "valstream.h"
+
+#define BATCH __attribute__((target_clones("avx2","default")))
 
 /* Extract hex/decimal/or float value from string */
 static int get_num_val(char *sval, unsigned *valp) {
@@ -33,7 +37,7 @@ static int get_num_val(char *sval, unsigned *valp) {
     long long int llval = strtoll(sval, &endp, 0);
     long long int upperbits = llval >> 31;
     /* will give -1 for negative, 0 or 1 for positive */
-    if (valp && (upperbits == 0 || upperbits == -1 || upperbits == 1)) {
+    if (valp && !*endp && (upperbits == 0 || upperbits == -1 || upperbits == 1)) {
       *valp = (unsigned) llval;
       return 1;
     }
@@ -48,9 +52,133 @@ void show_int(unsigned uf)
 }
 
 
+/*
+ * Streaming mode: statistics of a file of values
+ */
+typedef struct {
+  unsigned long long n, neg, zero;
+  unsigned long long width_hist[4][33];  /* 4 copies: see int_block */
+  unsigned long long bit_count[32];
+  int smin, smax;
+  unsigned umin, umax;
+} istats_t;
+
+/*
+ * int_block - Add a block of values to the statistics. The sign, range
+ *     and bit counts are gathered in passes that gcc vectorizes; the
+ *     widths are counted into four histograms in turn, so that runs of
+ *     one width do not wait on each other's increments
+ */
+BATCH static void int_block(const unsigned *v, size_t n, void *ctx)
+{
+  istats_t *s = ctx;
+  unsigned w[STREAM_BLOCK], bits[32] = {0};
+  unsigned neg = 0, zero = 0, umin = s->umin, umax = s->umax;
+  int smin = s->smin, smax = s->smax;
+  size_t i;
+  int b;
+
+  for (i = 0; i < n; i++) {
+    unsigned u = v[i];
+    int x = (int) u;
+
+    neg += u >> 31;
+    zero += u == 0 ? 1 : 0;
+    umin = u < umin ? u : umin;
+    umax = u > umax ? u : umax;
+    smin = x < smin ? x : smin;
+    smax = x > smax ? x : smax;
+  }
+  for (i = 0; i < n; i++)
+    for (b = 0; b < 32; b++)
+      bits[b] += (v[i] >> b) & 1;
+
+  /* Bits needed in two's complement: 1 for 0 and -1, 32 for INT_MIN */
+  for (i = 0; i < n; i++)
+    w[i] = 32 - __builtin_clrsb((int) v[i]);
+  for (i = 0; i + 4 <= n; i += 4) {
+    s->width_hist[0][w[i]]++;
+    s->width_hist[1][w[i+1]]++;
+    s->width_hist[2][w[i+2]]++;
+    s->width_hist[3][w[i+3]]++;
+  }
+  for (; i < n; i++)
+    s->width_hist[0][w[i]]++;
+
+  for (b = 0; b < 32; b++)
+    s->bit_count[b] += bits[b];
+  s->n += n;
+  s->neg += neg;
+  s->zero += zero;
+  s->umin = umin;
+  s->umax = umax;
+  s->smin = smin;
+  s->smax = smax;
+}
+
+static void show_stats(istats_t *s, long long bad)
+{
+  unsigned long long hist[33], max = 0;
+  char bar[51];
+  int i;
+
+  printf("%llu values", s->n);
+  if (bad)
+    printf(", %lld bad tokens or trailing bytes skipped", bad);
+  printf("\n\n");
+  if (s->n == 0)
+    return;
+
+  printf("  %-10s %14llu  %7.3f%%\n", "Negative", s->neg, 100.0 * s->neg / s->n);
+  printf("  %-10s %14llu  %7.3f%%\n", "Zero", s->zero, 100.0 * s->zero / s->n);
+  printf("\nSigned from %d to %d\n", s->smin, s->smax);
+  printf("Unsigned from %u (0x%.8x) to %u (0x%.8x)\n",
+         s->umin, s->umin, s->umax, s->umax);
+
+  for (i = 1; i <= 32; i++) {
+    hist[i] = s->width_hist[0][i] + s->width_hist[1][i] + s->width_hist[2][i] +
+      s->width_hist[3][i];
+    max = hist[i] > max ? hist[i] : max;
+  }
+  printf("\nBits needed          count   percent\n");
+  for (i = 1; i <= 32; i++)
+    if (hist[i]) {
+      stream_bar(bar, 50, hist[i], max);
+      printf("  %4d   %14llu  %7.3f%%  %s\n", i, hist[i], 100.0 * hist[i] / s->n, bar);
+    }
+
+  printf("\nBit                  set   percent\n");
+  for (i = 31; i >= 0; i--) {
+    stream_bar(bar, 50, s->bit_count[i], s->n);
+    printf("  %4d   %14llu  %7.3f%%  %s\n", i, s->bit_count[i],
+           100.0 * s->bit_count[i] / s->n, bar);
+  }
+}
+
+static int show_stream(int argc, char *argv[], int binary)
+{
+  static istats_t s;
+  long long bad = 0;
+  int i;
+
+  s.smin = 0x7fffffff;
+  s.smax = -0x7fffffff - 1;
+  s.umin = 0xffffffff;
+  s.umax = 0;
+  for (i = 2; i < argc; i++)
+    if (stream_values(argv[i], binary, get_num_val, int_block, &s, &bad) < 0)
+      return 1;
+  show_stats(&s, bad);
+  return 0;
+}
+
+
 void usage(char *fname) {
   printf("Usage: %s val1 val2 ...\n", fname);
+  printf("       %s -s|-b file ...\n", fname);
   printf("Values may be given in hex or decimal\n");
+  printf("With -s, print statistics of the values in text files; with -b,\n");
+  printf("of the 32-bit words in binary files. '-' reads standard input\n");
   exit(0);
 }
 
@@ -60,6 +188,11 @@ int main(int argc, char *argv[])
   unsigned uf;
   if (argc < 2)
     usage(argv[0]);
+  if (!strcmp(argv[1], "-s") || !strcmp(argv[1], "-b")) {
+    if (argc < 3)
+      usage(argv[0]);
+    return show_stream(argc, argv, argv[1][1] == 'b');
+  }
   for (i = 1; i < argc; i++) {
     char *sval = argv[i];
     if (get_num_val(sval, &uf)) {
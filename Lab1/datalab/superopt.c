@@ -0,0 +1,824 @@
+/*
+ * CS:APP Data Lab
+ *
+ * superopt.c - Search for the shortest solutions of the integer puzzles
+ *
+ * superopt enumerates straight-line programs over a puzzle's legal
+ * operators, its arguments and a few small constants, shortest first,
+ * and reports the first length at which a program computes the same
+ * function as the reference in tests.c. Among the programs of that
+ * length it keeps the one with the shortest dependency chain, using the
+ * latencies of bitcost.c. With -l it minimizes the chain first and the
+ * length second. A program of n instructions is what dlc counts as n
+ * operators, with each instruction used more than once kept in a
+ * variable.
+ *
+ * The search is kept small by pruning:
+ *
+ *  - every program is run on a fixed set of test vectors, 64 inputs
+ *    around the edge cases plus random ones, as each instruction is
+ *    added. An instruction whose results match a value the program
+ *    already has is redundant and is not tried (observational
+ *    equivalence);
+ *  - commutative operators take their operands in one order only, and
+ *    two adjacent instructions that do not depend on each other appear
+ *    in one order only;
+ *  - a program must use every instruction, so once there are more
+ *    unused values than the remaining instructions can consume, the
+ *    branch is cut, and the last instruction must use the one before
+ *    it (and the other unused value, if there is one);
+ *  - shifts by amounts outside 0..31 on any test vector are undefined
+ *    in C and are not tried;
+ *  - a program whose chain is already longer than the best found so
+ *    far is cut (the cost bound).
+ *
+ * A program that matches the reference on the test vectors is checked
+ * on 2^16 more and on 2^24 random inputs. When the search is over, the
+ * best one is checked on every input if there are at most 2^40 of them
+ * (2^32 with -q), which proves it correct; that covers every puzzle
+ * but bitNor and addOK, whose 2^64 inputs are only sampled. An input that proves
+ * it wrong is added to the test vectors and the search starts over.
+ * The minimum is exact only up to the test vectors: two values that
+ * agree on all 64 are treated as the same.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <time.h>
+
+/* Test vectors used during the search */
+#define NVEC 64
+
+/* Inputs per chunk when checking a candidate: small enough for L1 */
+#define CHUNK 1024
+
+/* The longest program searched for, and the most constants */
+#define MAX_LEN 12
+#define MAX_CONSTS 16
+#define MAX_VALS (3 + MAX_CONSTS + MAX_LEN)
+
+/* Random inputs for a candidate that cannot be checked on all inputs */
+#define RANDOM_CHECKS (1 << 24)
+
+#define BATCH __attribute__((target_clones("avx2", "default")))
+
+/* bits.h does not give every reference function its real arity */
+int test_bitNor(int, int);
+int test_isZero(int);
+int test_addOK(int, int);
+int test_absVal(int);
+int test_logicalShift(int, int);
+
+/*
+ * The reference results on n inputs, one loop per puzzle so that the
+ * Makefile's -flto can inline the function from tests.c and vectorize
+ * the loop: the exhaustive checks spend half their time here
+ */
+typedef void (*ref_t)(int *args[2], int *r, int n);
+
+#define REF1(f)                                                         \
+  BATCH static void ref_##f(int *args[2], int *restrict r, int n)       \
+  {                                                                     \
+    int i;                                                              \
+    for (i = 0; i < n; i++)                                             \
+      r[i] = test_##f(args[0][i]);                                      \
+  }
+#define REF2(f)                                                         \
+  BATCH static void ref_##f(int *args[2], int *restrict r, int n)       \
+  {                                                                     \
+    const int *restrict x = args[0], *restrict y = args[1];             \
+    int i;                                                              \
+    for (i = 0; i < n; i++)                                             \
+      r[i] = test_##f(x[i], y[i]);                                      \
+  }
+
+REF2(bitNor)
+REF1(isZero)
+REF2(addOK)
+REF1(absVal)
+REF2(logicalShift)
+
+/* The puzzles, with their legal operators as in decl.c */
+typedef struct {
+  const char *name;
+  int args;
+  ref_t ref;
+  const char *ops;
+  int range[2][2];
+} target_t;
+
+static const target_t targets[] = {
+  {"bitNor", 2, ref_bitNor, "~ &",
+   {{INT_MIN, INT_MAX}, {INT_MIN, INT_MAX}}},
+  {"isZero", 1, ref_isZero, "! ~ & ^ | + << >>",
+   {{INT_MIN, INT_MAX}, {0, 0}}},
+  {"addOK", 2, ref_addOK, "! ~ & ^ | + << >>",
+   {{INT_MIN, INT_MAX}, {INT_MIN, INT_MAX}}},
+  {"absVal", 1, ref_absVal, "! ~ & ^ | + << >>",
+   {{INT_MIN, INT_MAX}, {0, 0}}},
+  {"logicalShift", 2, ref_logicalShift, "! ~ & ^ | + << >>",
+   {{INT_MIN, INT_MAX}, {0, 31}}},
+};
+#define NTARGETS ((int) (sizeof(targets) / sizeof(targets[0])))
+
+/* Operators, with their latency as in bitcost.c */
+enum { OP_NOT, OP_INV, OP_NEG, OP_AND, OP_XOR, OP_OR, OP_ADD, OP_SHL, OP_SAR, NOPS };
+
+static const struct {
+  const char *name;
+  int unary, commutes, latency;
+} optab[NOPS] = {
+  {"!", 1, 0, 2}, {"~", 1, 0, 1}, {"-", 1, 0, 1},
+  {"&", 0, 1, 1}, {"^", 0, 1, 1}, {"|", 0, 1, 1}, {"+", 0, 1, 1},
+  {"<<", 0, 0, 1}, {">>", 0, 0, 1}
+};
+
+typedef struct {
+  int op, a, b;
+} insn_t;
+
+/* The search state */
+static const target_t *tgt;
+static int ops[NOPS], nops;
+static int consts[MAX_CONSTS], nconsts = 0;
+static int nleaves;                     /* arguments, then constants */
+static int len;                         /* program length being tried */
+static insn_t prog[MAX_LEN];
+static int vals[MAX_VALS][NVEC] __attribute__((aligned(32)));
+static int target[NVEC] __attribute__((aligned(32)));
+static int depth[MAX_VALS], uses[MAX_VALS];
+static int nunused;                     /* instructions not yet used */
+
+/* The best program found */
+static insn_t best[MAX_LEN];
+static int best_len, best_depth, best_proved, nfound;
+static long long best_inputs;
+static long long ntried, last_check;     /* instructions tried */
+static int latency_first = 0;           /* -l */
+static int exhaustive_max_log = 40;     /* -q lowers it to 32 */
+static int print_all = 0;               /* -a */
+static int max_depth;                   /* the cost bound */
+static double deadline;
+static int timed_out;
+
+static unsigned long long rng = 0x9e3779b97f4a7c15ULL;
+
+static unsigned next_rand(void)
+{
+  rng ^= rng >> 12;
+  rng ^= rng << 25;
+  rng ^= rng >> 27;
+  return (unsigned) ((rng * 0x2545f4914f6cdd1dULL) >> 32);
+}
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * eval - r = a op b on n inputs. Returns nonzero if a shift amount is
+ *     outside 0..31 for any of them
+ */
+BATCH static int eval(int op, const int *restrict a, const int *restrict b,
+                      int *restrict r, int n)
+{
+  int i;
+  unsigned bad = 0;
+
+  switch (op) {
+  case OP_NOT:
+    for (i = 0; i < n; i++)
+      r[i] = !a[i];
+    break;
+  case OP_INV:
+    for (i = 0; i < n; i++)
+      r[i] = ~a[i];
+    break;
+  case OP_NEG:
+    for (i = 0; i < n; i++)
+      r[i] = (int) -(unsigned) a[i];
+    break;
+  case OP_AND:
+    for (i = 0; i < n; i++)
+      r[i] = a[i] & b[i];
+    break;
+  case OP_XOR:
+    for (i = 0; i < n; i++)
+      r[i] = a[i] ^ b[i];
+    break;
+  case OP_OR:
+    for (i = 0; i < n; i++)
+      r[i] = a[i] | b[i];
+    break;
+  case OP_ADD:
+    for (i = 0; i < n; i++)
+      r[i] = (int) ((unsigned) a[i] + (unsigned) b[i]);
+    break;
+  case OP_SHL:
+    for (i = 0; i < n; i++) {
+      bad |= (unsigned) b[i] > 31;
+      r[i] = (int) ((unsigned) a[i] << (b[i] & 31));
+    }
+    break;
+  default:
+    for (i = 0; i < n; i++) {
+      bad |= (unsigned) b[i] > 31;
+      r[i] = a[i] >> (b[i] & 31);
+    }
+    break;
+  }
+  return bad != 0;
+}
+
+/*
+ * eval1 - a op b on one input, in *r. Returns nonzero for a bad shift
+ */
+static int eval1(int op, int a, int b, int *r)
+{
+  switch (op) {
+  case OP_NOT: *r = !a; return 0;
+  case OP_INV: *r = ~a; return 0;
+  case OP_NEG: *r = (int) -(unsigned) a; return 0;
+  case OP_AND: *r = a & b; return 0;
+  case OP_XOR: *r = a ^ b; return 0;
+  case OP_OR: *r = a | b; return 0;
+  case OP_ADD: *r = (int) ((unsigned) a + (unsigned) b); return 0;
+  case OP_SHL: *r = (int) ((unsigned) a << (b & 31)); return (unsigned) b > 31;
+  default: *r = a >> (b & 31); return (unsigned) b > 31;
+  }
+}
+
+BATCH static int same(const int *restrict a, const int *restrict b, int n)
+{
+  int i, diff = 0;
+
+  for (i = 0; i < n; i++)
+    diff |= a[i] ^ b[i];
+  return diff == 0;
+}
+
+/*
+ * run - Results of program p of length n on the inputs in args
+ */
+static const int *run(const insn_t *p, int n, int *args[2], int count)
+{
+  static int v[MAX_LEN][CHUNK], c[MAX_CONSTS][CHUNK];
+  static int c_filled;
+  const int *src[MAX_VALS];
+  int i, k;
+
+  if (!c_filled) {
+    for (k = 0; k < MAX_CONSTS; k++)
+      for (i = 0; i < CHUNK; i++)
+        c[k][i] = consts[k];
+    c_filled = 1;
+  }
+  for (k = 0; k < tgt->args; k++)
+    src[k] = args[k];
+  for (k = 0; k < nconsts; k++)
+    src[tgt->args + k] = c[k];
+  for (k = 0; k < n; k++) {
+    if (eval(p[k].op, src[p[k].a], src[p[k].b], v[k], count))
+      return NULL;
+    src[nleaves + k] = v[k];
+  }
+  return v[n - 1];
+}
+
+/*
+ * check_chunk - Nonzero if the program agrees with the reference on
+ *     count inputs, and has no out-of-range shift
+ */
+static int check_chunk(const insn_t *p, int n, int *args[2], int count)
+{
+  static int rt[CHUNK];
+  const int *r = run(p, n, args, count);
+
+  if (!r)
+    return 0;
+  tgt->ref(args, rt, count);
+  return same(r, rt, count);
+}
+
+/*
+ * random_arg - A random value of argument k, of random width so that
+ *     small values are common
+ */
+static int random_arg(int k)
+{
+  long long lo = tgt->range[k][0], hi = tgt->range[k][1];
+  unsigned u = next_rand() >> (next_rand() & 31);
+
+  if (next_rand() & 1)
+    u = -u;
+  if (lo == INT_MIN && hi == INT_MAX)
+    return (int) u;
+  return (int) (lo + u % (unsigned long long) (hi - lo + 1));
+}
+
+/* Values around the edges of the integer puzzles */
+static const int edges[] = {
+  0, 1, -1, 2, -2, 31, 32, INT_MIN, INT_MAX, INT_MIN + 1, INT_MAX - 1,
+  0x40000000, 0x3fffffff, 0x55555555, (int) 0xaaaaaaaa, 16, 30
+};
+#define NEDGES ((int) (sizeof(edges) / sizeof(edges[0])))
+
+static int edge_arg(int k)
+{
+  int v = edges[next_rand() % NEDGES];
+
+  if (v < tgt->range[k][0] || v > tgt->range[k][1])
+    return random_arg(k);
+  return v;
+}
+
+/*
+ * first_wrong - The first input in a chunk on which the program and the
+ *     reference differ
+ */
+static void first_wrong(const insn_t *p, int n, int *args[2], int count, int cex[2])
+{
+  int *one[2], i, r;
+  const int *v;
+
+  for (i = 0; i < count; i++) {
+    one[0] = &args[0][i];
+    one[1] = &args[1][i];
+    tgt->ref(one, &r, 1);
+    if ((v = run(p, n, one, 1)) == NULL || *v != r)
+      break;
+  }
+  cex[0] = args[0][i < count ? i : 0];
+  cex[1] = args[1][i < count ? i : 0];
+}
+
+/*
+ * verify - Check a program that passed the test vectors on more
+ *     inputs: on random ones, or with prove set, on every input if
+ *     there are at most 2^exhaustive_max_log of them. Returns 2 if it
+ *     is correct on every input, 1 if on all those tried, 0 if it is
+ *     wrong, with an input it gets wrong in cex
+ */
+static int verify(const insn_t *p, int n, int prove, long long *inputs, int cex[2])
+{
+  static int a0[CHUNK], a1[CHUNK];
+  int *args[2] = {a0, a1};
+  double space = 1;
+  long long k, total;
+  int i, j, count, x, y, row;
+
+  /* More edge and random inputs */
+  for (j = 0; j < 16; j++) {
+    for (i = 0; i < CHUNK; i++) {
+      a0[i] = (i & 1) ? random_arg(0) : edge_arg(0);
+      a1[i] = (i & 2) ? random_arg(1 % tgt->args) : edge_arg(1 % tgt->args);
+    }
+    if (!check_chunk(p, n, args, CHUNK)) {
+      first_wrong(p, n, args, CHUNK, cex);
+      return 0;
+    }
+  }
+
+  for (i = 0; i < tgt->args; i++)
+    space *= (double) tgt->range[i][1] - tgt->range[i][0] + 1;
+  if (prove && space <= (double) (1LL << exhaustive_max_log)) {
+    /* Every input: the first argument fastest, a chunk within a row */
+    x = tgt->range[0][0];
+    y = tgt->range[1 % tgt->args][0];
+    for (k = 0; k < (long long) space; k += count) {
+      row = (int) ((long long) tgt->range[0][1] - x + 1 < CHUNK ?
+                   (long long) tgt->range[0][1] - x + 1 : CHUNK);
+      count = (int) ((long long) space - k < row ? (long long) space - k : row);
+      for (i = 0; i < count; i++) {
+        a0[i] = (int) ((unsigned) x + i);
+        a1[i] = y;
+      }
+      if (count == (long long) tgt->range[0][1] - x + 1) {
+        x = tgt->range[0][0];
+        y++;
+      } else
+        x += count;
+      if (!check_chunk(p, n, args, count)) {
+        first_wrong(p, n, args, count, cex);
+        return 0;
+      }
+    }
+    *inputs = (long long) space;
+    return 2;
+  }
+
+  for (total = 0; total < RANDOM_CHECKS; total += CHUNK) {
+    for (i = 0; i < CHUNK; i++) {
+      a0[i] = random_arg(0);
+      a1[i] = random_arg(1 % tgt->args);
+    }
+    if (!check_chunk(p, n, args, CHUNK)) {
+      first_wrong(p, n, args, CHUNK, cex);
+      return 0;
+    }
+  }
+  *inputs = total + 16 * CHUNK;
+  return 1;
+}
+
+/*
+ * program_depth - The latency of the program: when its result is ready
+ */
+static int program_depth(void)
+{
+  return depth[nleaves + len - 1];
+}
+
+static void print_program(FILE *fp, const insn_t *p, int n);
+
+/*
+ * found - The last instruction produces the target on the test vectors
+ */
+static void found(void)
+{
+  int d = program_depth(), cex[2];
+  long long inputs;
+
+  if (!verify(prog, len, 0, &inputs, cex))
+    return;
+  nfound++;
+  if (print_all) {
+    printf("/* %d ops, latency %d */\n", len, d);
+    print_program(stdout, prog, len);
+  }
+  if (best_len == 0 || d < best_depth) {
+    memcpy(best, prog, len * sizeof(insn_t));
+    best_len = len;
+    best_depth = d;
+    best_inputs = inputs;
+    /* Only a shorter chain is of interest now */
+    max_depth = d - 1;
+  }
+}
+
+/*
+ * search - Try every instruction k, and the rest of the program after it
+ */
+static void search(int k)
+{
+  int v = nleaves + k, last = (k == len - 1);
+  int o, op, a, b, bmin, bmax, d, freed, unused, r0, other = -1;
+  insn_t *prev = k ? &prog[k - 1] : NULL;
+
+  if (timed_out || ((ntried & ~0xfffffLL) != last_check && now() > deadline)) {
+    timed_out = 1;
+    return;
+  }
+  last_check = ntried & ~0xfffffLL;
+
+  /* With two values unused, the last instruction takes exactly those */
+  if (last && nunused == 2)
+    for (other = nleaves; uses[other]; other++)
+      ;
+
+  for (o = 0; o < nops; o++) {
+    op = ops[o];
+    for (a = 0; a < v; a++) {
+      bmin = optab[op].unary ? a : optab[op].commutes ? a : 0;
+      bmax = optab[op].unary ? a : v - 1;
+      /* Nothing uses the instruction before the last yet: the last must */
+      if (last && k > 0 && a != v - 1)
+        bmin = v - 1;
+      if (other >= 0) {
+        if (optab[op].unary || (a != other && a != v - 1))
+          continue;
+        bmin = bmax = (a == other) ? v - 1 : other;
+        if (optab[op].commutes && bmin < a)
+          continue;
+      }
+      for (b = bmin; b <= bmax; b++) {
+        /* Two constants combine to a constant; leave those to the end
+           unless they are shifted into a new one */
+        if (a >= tgt->args && a < nleaves && b >= tgt->args && b < nleaves &&
+            !optab[op].unary && op != OP_SHL && op != OP_SAR)
+          continue;
+
+        /* Independent neighbours appear in one order */
+        if (prev && a != v - 1 && b != v - 1 &&
+            (op < prev->op || (op == prev->op && (a < prev->a ||
+                                                  (a == prev->a && b <= prev->b)))))
+          continue;
+
+        /* Every instruction must be used by a later one */
+        freed = (a >= nleaves && !uses[a]) + (b != a && b >= nleaves && !uses[b]);
+        unused = nunused - freed + 1;
+        if (last ? unused != 1 : unused - (len - 1 - k) > 1)
+          continue;
+
+        d = (depth[a] > depth[b] ? depth[a] : depth[b]) + optab[op].latency;
+        if (d > max_depth)
+          continue;
+
+        /* Most last instructions are wrong on the first test vector */
+        ntried++;
+        if (last && (eval1(op, vals[a][0], vals[b][0], &r0) || r0 != target[0]))
+          continue;
+        if (eval(op, vals[a], vals[b], vals[v], NVEC))
+          continue;
+        prog[k].op = op;
+        prog[k].a = a;
+        prog[k].b = b;
+        depth[v] = d;
+
+        if (last) {
+          if (same(vals[v], target, NVEC))
+            found();
+          continue;
+        }
+
+        /* Observational equivalence: skip values the program has */
+        {
+          int w;
+          for (w = 0; w < v; w++)
+            if (vals[w][0] == vals[v][0] && same(vals[w], vals[v], NVEC))
+              break;
+          if (w < v)
+            continue;
+        }
+
+        uses[a]++;
+        if (b != a)
+          uses[b]++;
+        nunused = unused;
+        search(k + 1);
+        nunused += freed - 1;
+        uses[a]--;
+        if (b != a)
+          uses[b]--;
+        if (timed_out)
+          return;
+      }
+    }
+  }
+}
+
+/*
+ * leaf_name - How value v is written in C
+ */
+static void leaf_name(char *buf, int v)
+{
+  static const char *names[] = {"x", "y"};
+  int c;
+
+  if (v < tgt->args) {
+    strcpy(buf, names[v]);
+    return;
+  }
+  c = consts[v - tgt->args];
+  sprintf(buf, (c > 255 || c < -255) ? "0x%x" : "%d", c);
+}
+
+/*
+ * expr_text - Program value v as a C expression. Values used more than
+ *     once are in variables t1, t2, ... Returns 1 if the text can be an
+ *     operand without parentheses
+ */
+static int expr_text(char *buf, const insn_t *p, const int *nuses, int v, int top)
+{
+  char a[1024], b[1024];
+  const insn_t *in;
+  int pa, pb;
+
+  if (v < nleaves) {
+    leaf_name(buf, v);
+    return 1;
+  }
+  if (!top && nuses[v] > 1) {
+    sprintf(buf, "t%d", v - nleaves + 1);
+    return 1;
+  }
+  in = &p[v - nleaves];
+  pa = expr_text(a, p, nuses, in->a, 0);
+  if (optab[in->op].unary) {
+    sprintf(buf, pa ? "%s%s" : "%s(%s)", optab[in->op].name, a);
+    return 1;
+  }
+  pb = expr_text(b, p, nuses, in->b, 0);
+  sprintf(buf, "%s%s%s %s %s%s%s", pa ? "" : "(", a, pa ? "" : ")",
+          optab[in->op].name, pb ? "" : "(", b, pb ? "" : ")");
+  return 0;
+}
+
+/*
+ * print_program - Print program p of length n as a C function
+ */
+static void print_program(FILE *fp, const insn_t *p, int n)
+{
+  int nuses[MAX_VALS] = {0};
+  char buf[1024];
+  int k;
+
+  for (k = 0; k < n; k++) {
+    nuses[p[k].a]++;
+    if (p[k].b != p[k].a)
+      nuses[p[k].b]++;
+  }
+  fprintf(fp, "int %s(int x%s) {\n", tgt->name, tgt->args > 1 ? ", int y" : "");
+  for (k = 0; k < n - 1; k++)
+    if (nuses[nleaves + k] > 1) {
+      expr_text(buf, p, nuses, nleaves + k, 1);
+      fprintf(fp, "  int t%d = %s;\n", k + 1, buf);
+    }
+  expr_text(buf, p, nuses, nleaves + n - 1, 1);
+  fprintf(fp, "  return %s;\n}\n", buf);
+}
+
+/*
+ * setup - Fill in the test vectors and the leaves for target t
+ */
+static void setup(const target_t *t, const char *op_list)
+{
+  int i, k;
+  int *args[2] = {vals[0], vals[1]};
+
+  tgt = t;
+  nops = 0;
+  for (k = 0; k < NOPS; k++) {
+    const char *s = op_list;
+    size_t n = strlen(optab[k].name);
+    while ((s = strstr(s, optab[k].name)) != NULL) {
+      if ((s == op_list || s[-1] == ' ') && (s[n] == ' ' || s[n] == '\0')) {
+        ops[nops++] = k;
+        break;
+      }
+      s += n;
+    }
+  }
+
+  /* The test vectors: every edge value of each argument with random
+     others, then random ones */
+  rng = 0x9e3779b97f4a7c15ULL;
+  for (i = 0; i < NVEC; i++)
+    for (k = 0; k < t->args; k++)
+      vals[k][i] = (i < 2 * NEDGES) ? edge_arg(k) : random_arg(k);
+  for (i = 0; i < NEDGES && i < NVEC; i++)
+    if (edges[i] >= t->range[0][0] && edges[i] <= t->range[0][1])
+      vals[0][i] = edges[i];
+
+  nleaves = t->args + nconsts;
+  for (k = 0; k < nconsts; k++)
+    for (i = 0; i < NVEC; i++)
+      vals[t->args + k][i] = consts[k];
+  tgt->ref(args, target, NVEC);
+  for (k = 0; k < nleaves; k++)
+    depth[k] = 0;
+}
+
+/*
+ * superopt - Search for target t up to max_len instructions, for at
+ *     most limit seconds
+ */
+static void superopt(const target_t *t, const char *op_list, int max_len, int limit)
+{
+  double start = now();
+  int i, k, proved, cex[2];
+  int *args[2] = {vals[0], vals[1]};
+
+  setup(t, op_list);
+  best_len = 0;
+  nfound = 0;
+  ntried = last_check = 0;
+  timed_out = 0;
+  deadline = start + limit;
+  max_depth = INT_MAX;
+
+  /* A leaf that already is the answer */
+  for (k = 0; k < nleaves; k++)
+    if (same(vals[k], target, NVEC)) {
+      printf("/* %s: one of its leaves */\n", t->name);
+      return;
+    }
+
+  for (;;) {
+    for (len = 1; len <= max_len && !timed_out; len++) {
+      /* Unless the chain comes first, the first length with a solution
+         is the answer */
+      if (best_len && !latency_first)
+        break;
+      for (i = 0; i < MAX_VALS; i++)
+        uses[i] = 0;
+      nunused = 0;
+      search(0);
+      if (!print_all && !latency_first && best_len)
+        break;
+    }
+    if (!best_len)
+      break;
+
+    /* Prove the best on every input, outside the time limit. An input
+       it gets wrong becomes the last test vector, and the search
+       starts over */
+    if ((proved = verify(best, best_len, 1, &best_inputs, cex)) != 0) {
+      best_proved = (proved == 2);
+      break;
+    }
+    printf("/* %s: a %d-op candidate is wrong on x = %d", t->name, best_len, cex[0]);
+    if (t->args > 1)
+      printf(", y = %d", cex[1]);
+    printf("; searching again */\n");
+    for (k = 0; k < t->args; k++)
+      vals[k][NVEC - 1] = cex[k];
+    t->ref(args, target, NVEC);
+    best_len = 0;
+    max_depth = INT_MAX;
+  }
+
+  if (!best_len) {
+    printf("/* %s: nothing found with up to %d ops%s (%.1f s) */\n\n", t->name,
+           len - 1, timed_out ? " before the time limit" : "", now() - start);
+    return;
+  }
+  printf("/* %s: %d op%s, latency %d%s; %s %lld inputs (%.1f s, %lld instructions tried) */\n",
+         t->name, best_len, best_len == 1 ? "" : "s", best_depth,
+         timed_out ? ", search cut short by the time limit" : "",
+         best_proved ? "proved on all" : "tested on", best_inputs, now() - start, ntried);
+  print_program(stdout, best, best_len);
+  printf("\n");
+}
+
+static void usage(char *cmd)
+{
+  printf("Usage: %s [-halq] [-f <name>] [-n <len>] [-c <consts>] [-o <ops>] [-T <secs>]\n", cmd);
+  printf("  -a         Print every solution found, not just the best\n");
+  printf("  -c <list>  Constants to use, comma separated (default 0,1,31)\n");
+  printf("  -f <name>  Search only for the named puzzle\n");
+  printf("  -h         Print this message\n");
+  printf("  -l         Minimize the latency first, then the op count\n");
+  printf("  -n <len>   Longest program to try (default 6)\n");
+  printf("  -o <ops>   Operators to use, as in decl.c (default: the puzzle's)\n");
+  printf("  -q         Prove the result on up to 2^32 inputs instead of 2^40\n");
+  printf("  -T <secs>  Time limit per puzzle's search (default 600)\n");
+  exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+  char c, *name = NULL, *op_list = NULL, *s;
+  int max_len = 6, limit = 600, i, done = 0;
+
+  consts[nconsts++] = 0;
+  consts[nconsts++] = 1;
+  consts[nconsts++] = 31;
+
+  while ((c = getopt(argc, argv, "halqf:n:c:o:T:")) != -1) {
+    switch (c) {
+    case 'a':
+      print_all = 1;
+      break;
+    case 'c':
+      for (nconsts = 0, s = optarg; *s && nconsts < MAX_CONSTS; ) {
+        consts[nconsts++] = (int) strtol(s, &s, 0);
+        if (*s == ',')
+          s++;
+        else if (*s)
+          usage(argv[0]);
+      }
+      break;
+    case 'f':
+      name = optarg;
+      break;
+    case 'l':
+      latency_first = 1;
+      break;
+    case 'n':
+      max_len = atoi(optarg);
+      if (max_len < 1 || max_len > MAX_LEN)
+        usage(argv[0]);
+      break;
+    case 'o':
+      op_list = optarg;
+      break;
+    case 'q':
+      exhaustive_max_log = 32;
+      break;
+    case 'T':
+      limit = atoi(optarg);
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+
+  for (i = 0; i < NTARGETS; i++) {
+    if (name && strcmp(name, targets[i].name))
+      continue;
+    superopt(&targets[i], op_list ? op_list : targets[i].ops, max_len, limit);
+    done = 1;
+  }
+  if (!done) {
+    printf("No puzzle named %s\n", name);
+    return 1;
+  }
+  return 0;
+}
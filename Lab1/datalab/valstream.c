@@ -0,0 +1,205 @@
+/*
+ * CS:APP Data Lab
+ *
+ * valstream.c - Streams of 32-bit values for fshow and ishow
+ *
+ * A regular file is mapped a window at a time, so a dump larger than
+ * the address space of a 32-bit build can still be read, and binary
+ * values are passed to the caller straight from the mapping. A pipe is
+ * read into a buffer instead. Text is split into tokens by a small
+ * state machine that carries a token across the end of a window.
+ */
+#define _FILE_OFFSET_BITS 64
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "valstream.h"
+
+/* Bytes mapped or read at a time: a multiple of the page size and of 4 */
+#define WINDOW (64 << 20)
+#define READ_BUF (1 << 20)
+
+/* The longest text token */
+#define MAX_TOKEN 64
+
+typedef struct {
+  int binary;
+  parse_fn parse;
+  block_fn block;
+  void *ctx;
+  unsigned vals[STREAM_BLOCK];   /* parsed values not yet passed on */
+  size_t nvals;
+  char tok[MAX_TOKEN];           /* the token being read */
+  int toklen;
+  long long count, bad;
+} state_t;
+
+static void flush_vals(state_t *st)
+{
+  if (st->nvals) {
+    st->block(st->vals, st->nvals, st->ctx);
+    st->nvals = 0;
+  }
+}
+
+static void end_token(state_t *st)
+{
+  unsigned v;
+
+  if (st->toklen == 0)
+    return;
+  if (st->toklen < MAX_TOKEN) {
+    st->tok[st->toklen] = '\0';
+    if (st->parse(st->tok, &v)) {
+      st->vals[st->nvals++] = v;
+      st->count++;
+      if (st->nvals == STREAM_BLOCK)
+        flush_vals(st);
+    } else
+      st->bad++;
+  } else
+    st->bad++;                   /* too long to be a value */
+  st->toklen = 0;
+}
+
+/*
+ * scan_text - Tokenize n bytes of text
+ */
+static void scan_text(state_t *st, const char *p, size_t n)
+{
+  size_t i;
+  char c;
+
+  for (i = 0; i < n; i++) {
+    c = p[i];
+    if (c == ' ' || c == '\n' || c == '\t' || c == ',' || c == '\r' ||
+        c == '\f' || c == '\v')
+      end_token(st);
+    else if (st->toklen < MAX_TOKEN)
+      st->tok[st->toklen++] = c;
+  }
+}
+
+/*
+ * scan_binary - Pass on n bytes of whole words, which the windows keep
+ *     aligned, in blocks
+ */
+static void scan_binary(state_t *st, const char *p, size_t n)
+{
+  const unsigned *w = (const unsigned *) p;
+  size_t nw = n / 4, i, m;
+
+  for (i = 0; i < nw; i += m) {
+    m = (nw - i < STREAM_BLOCK) ? nw - i : STREAM_BLOCK;
+    st->block(w + i, m, st->ctx);
+  }
+  st->count += nw;
+}
+
+static void scan(state_t *st, const char *p, size_t n)
+{
+  if (st->binary)
+    scan_binary(st, p, n);
+  else
+    scan_text(st, p, n);
+}
+
+/*
+ * read_full - Read until buf is full or the input ends
+ */
+static ssize_t read_full(int fd, char *buf, size_t n)
+{
+  size_t got = 0;
+  ssize_t r;
+
+  while (got < n) {
+    r = read(fd, buf + got, n - got);
+    if (r < 0 && errno == EINTR)
+      continue;
+    if (r < 0)
+      return -1;
+    if (r == 0)
+      break;
+    got += r;
+  }
+  return got;
+}
+
+long long stream_values(const char *path, int binary, parse_fn parse,
+                        block_fn block, void *ctx, long long *nbad)
+{
+  static state_t st;
+  static char buf[READ_BUF];
+  struct stat sb;
+  off_t off;
+  size_t n;
+  ssize_t r;
+  void *map;
+  int fd = strcmp(path, "-") ? open(path, O_RDONLY) : 0;
+
+  if (fd < 0) {
+    perror(path);
+    return -1;
+  }
+  st.binary = binary;
+  st.parse = parse;
+  st.block = block;
+  st.ctx = ctx;
+  st.nvals = 0;
+  st.toklen = 0;
+  st.count = st.bad = 0;
+
+  if (fstat(fd, &sb) == 0 && S_ISREG(sb.st_mode)) {
+    for (off = 0; off < sb.st_size; off += n) {
+      n = (sb.st_size - off < WINDOW) ? (size_t) (sb.st_size - off) : WINDOW;
+      map = mmap(NULL, n, PROT_READ, MAP_PRIVATE, fd, off);
+      if (map == MAP_FAILED) {
+        perror(path);
+        goto fail;
+      }
+      madvise(map, n, MADV_SEQUENTIAL);   /* advice values do not combine */
+      madvise(map, n, MADV_WILLNEED);
+      scan(&st, map, n);
+      munmap(map, n);
+    }
+    st.bad += binary ? sb.st_size % 4 : 0;
+  } else {
+    while ((r = read_full(fd, buf, READ_BUF)) > 0) {
+      scan(&st, buf, r);
+      st.bad += binary ? r % 4 : 0;
+      if (r < READ_BUF)
+        break;
+    }
+    if (r < 0) {
+      perror(path);
+      goto fail;
+    }
+  }
+  end_token(&st);
+  flush_vals(&st);
+  if (fd != 0)
+    close(fd);
+  *nbad += st.bad;
+  return st.count;
+
+ fail:
+  if (fd != 0)
+    close(fd);
+  return -1;
+}
+
+void stream_bar(char *buf, int width, unsigned long long count,
+                unsigned long long max)
+{
+  int n = max ? (int) ((double) count * width / max + 0.5) : 0;
+
+  if (count && n == 0)
+    n = 1;
+  memset(buf, '#', n);
+  buf[n] = '\0';
+}
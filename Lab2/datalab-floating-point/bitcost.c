@@ -0,0 +1,975 @@
+/*
+ * CS:APP Data Lab
+ *
+ * bitcost.c - Operator counts and critical paths of the puzzles in bits.c
+ *
+ * bitcost reads the C source of the puzzle functions and, for each one,
+ * counts the operators the way dlc does, and also works out the length
+ * of the longest chain of dependent operations from the arguments to a
+ * returned value, in cycles. The op count says how much work a function
+ * is, and so how many calls per cycle a superscalar core can sustain;
+ * the path says how long one call takes when its result is needed
+ * right away. Two versions of a puzzle with the same op count can
+ * differ a lot in the second.
+ *
+ * Branches (if, ?:, && and ||) and loops are flagged. Both sides of an
+ * if are followed and the longer taken; the condition is left off the
+ * path, as a predicted branch does not wait for it. A loop body is
+ * followed once more than the number of iterations assumed (-l, 1 by
+ * default) to find how much latency each iteration adds through the
+ * variables it carries.
+ *
+ * The legal operators and op limit of each puzzle are taken from
+ * decl.c, and the same rules as dlc are checked: only the legal
+ * operators, no constants above 255, and no control flow, casts or
+ * calls in the integer puzzles. Like dlc, which parses C89, it does not
+ * accept declarations after a statement or in a for. Functions not in decl.c are analyzed
+ * without checks, so alternative versions can be kept in another file
+ * and compared.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+
+#define MAX_TOKENS 200000
+#define MAX_NAME 64
+#define MAX_VARS 256
+#define MAX_PUZZLES 64
+#define MAX_LINE 4096
+
+/* The issue width assumed for the throughput estimate */
+#define ISSUE_WIDTH 4
+
+enum { T_EOF, T_IDENT, T_NUMBER, T_STRING, T_PUNCT };
+
+typedef struct {
+  int type;
+  char text[MAX_NAME];
+  unsigned long long val;
+  int line;
+} token_t;
+
+/*
+ * Operators, in the order they are listed by -v, and their latency in
+ * cycles on a recent x86 core. A comparison or ! is a compare and a
+ * setcc; && and || are counted like a comparison, though they may
+ * compile to a branch
+ */
+static const struct {
+  const char *name;
+  int latency;
+} optab[] = {
+  {"!", 2}, {"~", 1}, {"&", 1}, {"^", 1}, {"|", 1}, {"+", 1}, {"-", 1},
+  {"<<", 1}, {">>", 1}, {"*", 3}, {"/", 26}, {"%", 26},
+  {"==", 2}, {"!=", 2}, {"<", 2}, {">", 2}, {"<=", 2}, {">=", 2},
+  {"&&", 2}, {"||", 2}, {"++", 1}, {"--", 1}
+};
+#define NOPS ((int) (sizeof(optab) / sizeof(optab[0])))
+
+typedef struct {
+  char name[MAX_NAME];
+  int depth;
+} var_t;
+
+typedef struct {
+  var_t v[MAX_VARS];
+  int n;
+} vars_t;
+
+/* A puzzle's rules, from decl.c */
+typedef struct {
+  char name[MAX_NAME];
+  char ops[MAX_NAME];
+  int limit;
+} puzzle_t;
+
+/* What is known about the function being analyzed */
+typedef struct {
+  char name[MAX_NAME];
+  int end_line;
+  puzzle_t *rules;        /* NULL if not in decl.c */
+  int counts[NOPS];
+  int nops;
+  int path;               /* longest chain to a return, in cycles */
+  int carried;            /* most latency a loop iteration carries */
+  int nif, nsel, nlogic, nloop, ncall, ncast;
+} func_t;
+
+static token_t *toks;
+static int ntoks, pos;
+
+static puzzle_t puzzles[MAX_PUZZLES];
+static int npuzzles;
+
+static const char *src_name;
+static func_t fn;
+static vars_t vars;
+static int counting;      /* 0 while following a loop body again */
+static int loop_iters = 1;  /* iterations of each loop on the path (-l) */
+static int errors;
+
+/*********************
+ * Reading the source
+ *********************/
+
+/*
+ * read_lines - Read file name, dropping the lines removed by #if 0 and
+ *     the other preprocessor lines, which are left empty so that line
+ *     numbers still match. Returns the text, or NULL
+ */
+static char *read_lines(const char *name)
+{
+  FILE *fp = fopen(name, "r");
+  char line[MAX_LINE], *buf, *p;
+  size_t size = 1 << 16, len = 0, n;
+  int skip = 0, cont = 0;
+
+  if (!fp)
+    return NULL;
+  if (!(buf = malloc(size))) {
+    fprintf(stderr, "bitcost: out of memory\n");
+    exit(1);
+  }
+  while (fgets(line, sizeof(line), fp)) {
+    for (p = line; *p == ' ' || *p == '\t'; p++)
+      ;
+    n = strlen(line);
+    if (cont || *p == '#') {
+      /* A directive, maybe continued with a backslash */
+      cont = n >= 2 && line[n - 2] == '\\';
+      if (!strncmp(p, "#if", 3))
+        skip += skip || !strncmp(p, "#if 0", 5);
+      else if (!strncmp(p, "#endif", 6) && skip)
+        skip--;
+      else if (!strncmp(p, "#else", 5) && skip == 1)
+        skip = 0;
+      strcpy(line, "\n");
+    } else if (skip)
+      strcpy(line, "\n");
+    n = strlen(line);
+    if (len + n + 1 > size) {
+      size *= 2;
+      if (!(buf = realloc(buf, size))) {
+        fprintf(stderr, "bitcost: out of memory\n");
+        exit(1);
+      }
+    }
+    memcpy(buf + len, line, n);
+    len += n;
+  }
+  buf[len] = '\0';
+  fclose(fp);
+  return buf;
+}
+
+/*
+ * tokenize - Split text into toks, skipping comments
+ */
+static void tokenize(const char *s)
+{
+  static const char *puncts[] = {
+    "<<=", ">>=", "<<", ">>", "<=", ">=", "==", "!=", "&&", "||", "++", "--",
+    "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=", "->", NULL
+  };
+  int line = 1, i, n;
+  char *end;
+
+  ntoks = 0;
+  while (*s) {
+    token_t *t = &toks[ntoks];
+
+    if (*s == '\n') {
+      line++;
+      s++;
+      continue;
+    }
+    if (isspace((unsigned char) *s)) {
+      s++;
+      continue;
+    }
+    if (s[0] == '/' && s[1] == '/') {
+      while (*s && *s != '\n')
+        s++;
+      continue;
+    }
+    if (s[0] == '/' && s[1] == '*') {
+      for (s += 2; *s && !(s[0] == '*' && s[1] == '/'); s++)
+        line += *s == '\n';
+      s += *s ? 2 : 0;
+      continue;
+    }
+    if (ntoks == MAX_TOKENS - 1) {
+      fprintf(stderr, "bitcost: %s: too many tokens\n", src_name);
+      exit(1);
+    }
+
+    t->line = line;
+    t->val = 0;
+    if (isalpha((unsigned char) *s) || *s == '_') {
+      for (n = 0; isalnum((unsigned char) s[n]) || s[n] == '_'; n++)
+        ;
+      t->type = T_IDENT;
+    } else if (isdigit((unsigned char) *s)) {
+      t->type = T_NUMBER;
+      t->val = strtoull(s, &end, 0);
+      for (n = end - s; isalnum((unsigned char) s[n]); n++)
+        ;                       /* u and l suffixes */
+    } else if (*s == '"' || *s == '\'') {
+      /* Keep the text without the quotes */
+      for (n = 1; s[n] && s[n] != s[0] && s[n] != '\n'; n++)
+        n += s[n] == '\\' && s[n + 1];
+      t->type = T_STRING;
+      i = (n - 1 < MAX_NAME) ? n - 1 : MAX_NAME - 1;
+      memcpy(t->text, s + 1, i);
+      t->text[i] = '\0';
+      s += n + (s[n] == s[0]);
+      ntoks++;
+      continue;
+    } else {
+      t->type = T_PUNCT;
+      n = 1;
+      for (i = 0; puncts[i]; i++)
+        if (!strncmp(s, puncts[i], strlen(puncts[i]))) {
+          n = strlen(puncts[i]);
+          break;
+        }
+    }
+    if (n >= MAX_NAME) {
+      fprintf(stderr, "bitcost:%s:%d: token too long\n", src_name, line);
+      exit(1);
+    }
+    memcpy(t->text, s, n);
+    t->text[n] = '\0';
+    s += n;
+    ntoks++;
+  }
+  toks[ntoks].type = T_EOF;
+  toks[ntoks].text[0] = '\0';
+  toks[ntoks].line = line;
+}
+
+/*
+ * read_decl - Load the puzzle rules from decl.c, whose entries look like
+ *     {"name", (funct_t) name, (funct_t) test_name, args, "ops", limit, ...
+ */
+static void read_decl(const char *name)
+{
+  char *text = read_lines(name);
+  int i;
+
+  if (!text)
+    return;
+  tokenize(text);
+  free(text);
+  for (i = 0; i + 16 < ntoks && npuzzles < MAX_PUZZLES; i++) {
+    token_t *t = &toks[i];
+    if (t[0].type != T_STRING || strcmp(t[1].text, ",") || strcmp(t[3].text, "funct_t"))
+      continue;
+    if (t[14].type != T_STRING || t[16].type != T_NUMBER)
+      continue;
+    strcpy(puzzles[npuzzles].name, t[0].text);
+    strcpy(puzzles[npuzzles].ops, t[14].text);
+    puzzles[npuzzles].limit = (int) t[16].val;
+    npuzzles++;
+  }
+}
+
+/*****************
+ * The analysis
+ *****************/
+
+static token_t *peek(void)
+{
+  return &toks[pos];
+}
+
+static int is(const char *text)
+{
+  return toks[pos].type != T_STRING && !strcmp(toks[pos].text, text);
+}
+
+static int accept(const char *text)
+{
+  if (!is(text))
+    return 0;
+  pos++;
+  return 1;
+}
+
+static void expect(const char *text)
+{
+  if (!accept(text)) {
+    fprintf(stderr, "bitcost:%s:%d: expected '%s' before '%s'\n", src_name,
+            peek()->line, text, peek()->text);
+    exit(1);
+  }
+}
+
+static int is_type(const token_t *t)
+{
+  static const char *types[] = {
+    "int", "unsigned", "signed", "long", "short", "char", "float", "double",
+    "void", "const", "register", "static", NULL
+  };
+  int i;
+
+  for (i = 0; t->type == T_IDENT && types[i]; i++)
+    if (!strcmp(t->text, types[i]))
+      return 1;
+  return 0;
+}
+
+static int max(int a, int b)
+{
+  return a > b ? a : b;
+}
+
+/*
+ * violation - Report a rule the function breaks, once per place
+ */
+static void violation(int line, const char *what, const char *arg)
+{
+  if (!counting || !fn.rules)
+    return;
+  printf("bitcost:%s:%d:%s: %s (%s)\n", src_name, line, fn.name, what, arg);
+  errors++;
+}
+
+static int int_puzzle(void)
+{
+  return fn.rules && strcmp(fn.rules->ops, "$") != 0;
+}
+
+/*
+ * legal_op - Nonzero if op is in the puzzle's list of legal operators
+ */
+static int legal_op(const char *op)
+{
+  const char *s = fn.rules->ops;
+  size_t n = strlen(op);
+
+  if (!int_puzzle())
+    return 1;
+  while ((s = strstr(s, op)) != NULL) {
+    if ((s == fn.rules->ops || s[-1] == ' ') && (s[n] == ' ' || s[n] == '\0'))
+      return 1;
+    s += n;
+  }
+  return 0;
+}
+
+/*
+ * op - Count one use of operator name on the given line, whose operands
+ *     are ready after depth cycles. Returns when its result is ready
+ */
+static int op(const char *name, int line, int depth)
+{
+  int i;
+
+  for (i = 0; i < NOPS; i++)
+    if (!strcmp(optab[i].name, name))
+      break;
+  if (i == NOPS)
+    return depth;
+  if (counting) {
+    fn.counts[i]++;
+    fn.nops++;
+    if (!legal_op(name))
+      violation(line, "Illegal operator", name);
+  }
+  return depth + optab[i].latency;
+}
+
+static var_t *lookup(const char *name)
+{
+  int i;
+
+  for (i = vars.n - 1; i >= 0; i--)
+    if (!strcmp(vars.v[i].name, name))
+      return &vars.v[i];
+  return NULL;
+}
+
+static void set_var(const char *name, int depth)
+{
+  var_t *v = lookup(name);
+
+  if (!v) {
+    if (vars.n == MAX_VARS) {
+      fprintf(stderr, "bitcost: %s: too many variables\n", fn.name);
+      exit(1);
+    }
+    v = &vars.v[vars.n++];
+    strcpy(v->name, name);
+  }
+  v->depth = depth;
+}
+
+/*
+ * merge_vars - Each variable is ready when it is ready on both paths
+ */
+static void merge_vars(const vars_t *other)
+{
+  int i;
+  var_t *v;
+
+  for (i = 0; i < other->n; i++) {
+    v = lookup(other->v[i].name);
+    if (!v || other->v[i].depth > v->depth)
+      set_var(other->v[i].name, other->v[i].depth);
+  }
+}
+
+static int expr(void);
+static int assign_expr(void);
+static void statement(void);
+
+/*
+ * primary_expr - A name, a constant, a call or a parenthesized expression
+ */
+static int primary_expr(void)
+{
+  token_t *t = peek();
+  var_t *v;
+  int d = 0;
+
+  if (accept("(")) {
+    d = expr();
+    expect(")");
+    return d;
+  }
+  pos++;
+  if (t->type == T_NUMBER) {
+    if (int_puzzle() && t->val > 255)
+      violation(t->line, "Illegal constant", t->text);
+    return 0;
+  }
+  if (t->type != T_IDENT) {
+    fprintf(stderr, "bitcost:%s:%d: unexpected '%s'\n", src_name, t->line, t->text);
+    exit(1);
+  }
+  if (accept("(")) {
+    if (counting)
+      fn.ncall++;
+    violation(t->line, "Illegal function call", t->text);
+    while (!accept(")")) {
+      d = max(d, assign_expr());
+      accept(",");
+    }
+    return d;
+  }
+  v = lookup(t->text);
+  return v ? v->depth : 0;
+}
+
+/*
+ * postfix_expr - x++ and x--
+ */
+static int postfix_expr(void)
+{
+  token_t *t = peek();
+  int d = primary_expr();
+
+  while (is("++") || is("--")) {
+    int line = peek()->line;
+    const char *name = peek()->text;
+    pos++;
+    if (t->type == T_IDENT)
+      set_var(t->text, op(name, line, d));
+  }
+  return d;
+}
+
+static int unary_expr(void)
+{
+  token_t *t = peek();
+  int d;
+
+  if (is("!") || is("~") || is("-")) {
+    pos++;
+    return op(t->text, t->line, unary_expr());
+  }
+  if (accept("+"))
+    return unary_expr();
+  if (is("++") || is("--")) {
+    pos++;
+    d = op(t->text, t->line, unary_expr());
+    if (toks[pos - 1].type == T_IDENT)
+      set_var(toks[pos - 1].text, d);
+    return d;
+  }
+  if (is("(") && is_type(&toks[pos + 1])) {
+    /* A cast costs nothing, but dlc does not allow it */
+    pos++;
+    while (!accept(")"))
+      pos++;
+    if (counting)
+      fn.ncast++;
+    violation(t->line, "Illegal cast", toks[pos - 2].text);
+    return unary_expr();
+  }
+  return postfix_expr();
+}
+
+static int precedence(const token_t *t)
+{
+  static const char *levels[][4] = {
+    {"||"}, {"&&"}, {"|"}, {"^"}, {"&"}, {"==", "!="}, {"<", ">", "<=", ">="},
+    {"<<", ">>"}, {"+", "-"}, {"*", "/", "%"}
+  };
+  int i, j;
+
+  if (t->type != T_PUNCT)
+    return 0;
+  for (i = 0; i < 10; i++)
+    for (j = 0; j < 4 && levels[i][j]; j++)
+      if (!strcmp(t->text, levels[i][j]))
+        return i + 1;
+  return 0;
+}
+
+/*
+ * binary_expr - Operators binding at least as tightly as level prec.
+ *     An operation starts when both of its operands are ready
+ */
+static int binary_expr(int prec)
+{
+  int d = unary_expr(), p;
+
+  while ((p = precedence(peek())) >= prec) {
+    token_t *t = peek();
+    pos++;
+    if (counting && (!strcmp(t->text, "&&") || !strcmp(t->text, "||")))
+      fn.nlogic++;
+    d = op(t->text, t->line, max(d, binary_expr(p + 1)));
+  }
+  return d;
+}
+
+static int cond_expr(void)
+{
+  token_t *t;
+  int d = binary_expr(1), a, b;
+
+  if (!is("?"))
+    return d;
+  t = peek();
+  pos++;
+  a = expr();
+  expect(":");
+  b = cond_expr();
+  if (counting)
+    fn.nsel++;
+  if (int_puzzle())
+    violation(t->line, "Illegal operator", "?:");
+  /* A conditional move */
+  return max(d, max(a, b)) + 1;
+}
+
+static int assign_expr(void)
+{
+  token_t *t = peek(), *a = &toks[pos + 1];
+  char name[MAX_NAME];
+  var_t *v;
+  int d;
+
+  if (t->type != T_IDENT || a->type != T_PUNCT || a->text[strlen(a->text) - 1] != '=' ||
+      !strcmp(a->text, "==") || !strcmp(a->text, "!=") ||
+      !strcmp(a->text, "<=") || !strcmp(a->text, ">="))
+    return cond_expr();
+
+  pos += 2;
+  d = assign_expr();
+  if (strcmp(a->text, "=")) {
+    /* x op= y is one op */
+    strcpy(name, a->text);
+    name[strlen(name) - 1] = '\0';
+    v = lookup(t->text);
+    d = op(name, a->line, max(d, v ? v->depth : 0));
+  }
+  set_var(t->text, d);
+  return d;
+}
+
+static int expr(void)
+{
+  int d = assign_expr();
+
+  while (accept(","))
+    d = assign_expr();
+  return d;
+}
+
+/*
+ * declaration - int x = e, y; The type has been read
+ */
+static void declaration(void)
+{
+  token_t *t;
+
+  while (!accept(";")) {
+    while (accept("*"))
+      ;
+    t = peek();
+    pos++;
+    set_var(t->text, accept("=") ? assign_expr() : 0);
+    accept(",");
+  }
+}
+
+/*
+ * skip_parens - Step past the ) that closes an ( already read
+ */
+static void skip_parens(void)
+{
+  int depth = 1;
+
+  for (; depth > 0 && peek()->type != T_EOF; pos++)
+    depth += is("(") - is(")");
+}
+
+/*
+ * skip_stmt - Step over a statement without analyzing it
+ */
+static void skip_stmt(void)
+{
+  int depth = 1;
+
+  if (accept("{")) {
+    for (; depth > 0 && peek()->type != T_EOF; pos++)
+      depth += is("{") - is("}");
+    return;
+  }
+  if (accept("if") || accept("while") || accept("for")) {
+    expect("(");
+    skip_parens();
+    skip_stmt();
+    if (accept("else"))
+      skip_stmt();
+    return;
+  }
+  if (accept("do")) {
+    skip_stmt();
+    while (!accept(";") && peek()->type != T_EOF)
+      pos++;
+    return;
+  }
+  while (!accept(";") && peek()->type != T_EOF)
+    pos++;
+}
+
+/*
+ * loop - Follow a loop whose condition, body and step start at the
+ *     given tokens (cond and step may be -1), and return with pos after
+ *     it. The variables are left as after loop_iters iterations; one
+ *     more shows the latency an iteration adds through each of them
+ */
+static void loop(const char *kind, int cond, int body, int step, int line)
+{
+  vars_t kept;
+  int i, end = pos, was_counting = counting;
+  var_t *v;
+
+  if (counting)
+    fn.nloop++;
+  if (int_puzzle())
+    violation(line, "Illegal control statement", kind);
+
+  for (i = 0; i <= loop_iters; i++) {
+    if (i == loop_iters)
+      kept = vars;
+    if (cond >= 0) {
+      pos = cond;
+      if (!is(";"))
+        expr();
+    }
+    pos = body;
+    statement();
+    end = pos;
+    if (step >= 0) {
+      pos = step;
+      if (!is(")"))
+        expr();
+    }
+    counting = 0;
+  }
+  counting = was_counting;
+
+  for (i = 0; i < kept.n && counting; i++)
+    if ((v = lookup(kept.v[i].name)) != NULL)
+      fn.carried = max(fn.carried, v->depth - kept.v[i].depth);
+  vars = kept;
+  pos = end;
+}
+
+static void statement(void)
+{
+  token_t *t = peek();
+  vars_t before, after;
+  int cond, body, step, seen_stmt;
+
+  if (accept("{")) {
+    /* dlc parses C89: declarations only at the start of a block */
+    for (seen_stmt = 0; !accept("}"); statement()) {
+      if (peek()->type == T_EOF)
+        return;
+      if (!is_type(peek()))
+        seen_stmt = 1;
+      else if (seen_stmt)
+        violation(peek()->line, "Illegal declaration", "after a statement");
+    }
+    return;
+  }
+  if (accept(";"))
+    return;
+  if (accept("if")) {
+    if (counting)
+      fn.nif++;
+    if (int_puzzle())
+      violation(t->line, "Illegal control statement", "if");
+    expect("(");
+    expr();
+    expect(")");
+    before = vars;
+    statement();
+    if (accept("else")) {
+      after = vars;
+      vars = before;
+      statement();
+      merge_vars(&after);
+    } else
+      merge_vars(&before);
+    return;
+  }
+  if (accept("while")) {
+    expect("(");
+    cond = pos;
+    skip_parens();
+    loop("while", cond, pos, -1, t->line);
+    return;
+  }
+  if (accept("for")) {
+    expect("(");
+    if (is_type(peek())) {
+      violation(t->line, "Illegal declaration", "in for");
+      while (is_type(peek()))
+        pos++;
+      declaration();
+    } else {
+      if (!is(";"))
+        expr();
+      expect(";");
+    }
+    cond = pos;
+    while (!accept(";") && peek()->type != T_EOF)
+      pos++;
+    step = pos;
+    skip_parens();
+    loop("for", cond, pos, step, t->line);
+    return;
+  }
+  if (accept("do")) {
+    body = pos;
+    skip_stmt();
+    expect("while");
+    expect("(");
+    cond = pos;
+    loop("do", -1, body, -1, t->line);
+    pos = cond;
+    expr();
+    expect(")");
+    expect(";");
+    return;
+  }
+  if (accept("return")) {
+    if (!is(";")) {
+      int d = expr();
+      if (counting)
+        fn.path = max(fn.path, d);
+    }
+    expect(";");
+    return;
+  }
+  if (accept("break") || accept("continue")) {
+    expect(";");
+    return;
+  }
+  if (is_type(t)) {
+    while (is_type(peek()))
+      pos++;
+    declaration();
+    return;
+  }
+  expr();
+  expect(";");
+}
+
+/*********
+ * Report
+ *********/
+
+static void report(int verbose, int dlc_style)
+{
+  char path[32], flags[128];
+  int i, n = 0;
+
+  if (dlc_style) {
+    printf("bitcost:%s:%d:%s: %d operators\n", src_name, fn.end_line, fn.name, fn.nops);
+    return;
+  }
+  if (fn.rules && fn.nops > fn.rules->limit) {
+    printf("bitcost:%s:%d:%s: %d operators exceeds max of %d\n", src_name,
+           fn.end_line, fn.name, fn.nops, fn.rules->limit);
+    errors++;
+  }
+
+  /* The path is a lower bound if the loops may run longer */
+  snprintf(path, sizeof(path), "%d%s", fn.path, fn.nloop ? "+" : "");
+  flags[0] = '\0';
+  if (fn.nif)
+    n += snprintf(flags + n, sizeof(flags) - n, "if x%d ", fn.nif);
+  if (fn.nsel)
+    n += snprintf(flags + n, sizeof(flags) - n, "?: x%d ", fn.nsel);
+  if (fn.nlogic)
+    n += snprintf(flags + n, sizeof(flags) - n, "&&/|| x%d ", fn.nlogic);
+  if (fn.nloop)
+    n += snprintf(flags + n, sizeof(flags) - n, "loop x%d (+%d/iter) ", fn.nloop, fn.carried);
+  if (fn.ncall)
+    n += snprintf(flags + n, sizeof(flags) - n, "call x%d ", fn.ncall);
+  if (fn.ncast)
+    n += snprintf(flags + n, sizeof(flags) - n, "cast x%d ", fn.ncast);
+
+  if (fn.rules)
+    printf("%-16s %5d %5d", fn.name, fn.nops, fn.rules->limit);
+  else
+    printf("%-16s %5d %5s", fn.name, fn.nops, "-");
+  printf(" %6s %6.2f  %s\n", path, (double) fn.nops / ISSUE_WIDTH, flags);
+
+  if (verbose) {
+    printf("  ");
+    for (i = 0; i < NOPS; i++)
+      if (fn.counts[i])
+        printf(" %s:%d", optab[i].name, fn.counts[i]);
+    printf("\n");
+  }
+}
+
+/*
+ * analyze - Go through the functions defined in the token stream
+ */
+static void analyze(const char *only, int verbose, int dlc_style)
+{
+  int i, start, depth;
+
+  if (!dlc_style)
+    printf("%-16s %5s %5s %6s %6s  %s\n", "Function", "Ops", "Max", "Path", "Tput", "Flags");
+
+  for (pos = 0; peek()->type != T_EOF; ) {
+    /* A definition: type name ( params ) { */
+    start = pos;
+    while (is_type(peek()))
+      pos++;
+    if (pos == start || peek()->type != T_IDENT || strcmp(toks[pos + 1].text, "(")) {
+      /* Something else at top level */
+      for (depth = 0; peek()->type != T_EOF; pos++) {
+        depth += is("{") - is("}");
+        if (depth == 0 && (is(";") || is("}"))) {
+          pos++;
+          break;
+        }
+      }
+      if (pos == start)
+        pos++;
+      continue;
+    }
+
+    memset(&fn, 0, sizeof(fn));
+    strcpy(fn.name, peek()->text);
+    for (i = 0; i < npuzzles; i++)
+      if (!strcmp(puzzles[i].name, fn.name))
+        fn.rules = &puzzles[i];
+    vars.n = 0;
+    pos += 2;
+    while (!accept(")") && peek()->type != T_EOF) {
+      if (peek()->type == T_IDENT && !is_type(peek()) &&
+          (!strcmp(toks[pos + 1].text, ",") || !strcmp(toks[pos + 1].text, ")")))
+        set_var(peek()->text, 0);
+      pos++;
+    }
+    if (accept(";"))
+      continue;             /* a prototype */
+
+    counting = !only || !strcmp(only, fn.name);
+    if (!counting) {
+      skip_stmt();
+      continue;
+    }
+    start = pos;
+    skip_stmt();
+    fn.end_line = toks[pos - 1].line;
+    pos = start;
+    statement();
+    report(verbose, dlc_style);
+  }
+}
+
+static void usage(char *cmd)
+{
+  printf("Usage: %s [-hev] [-d <decl file>] [-f <name>] [-l <iters>] [<file>]\n", cmd);
+  printf("  -d <file> Take the puzzle rules from file (default decl.c)\n");
+  printf("  -e        Only print the operator counts, as dlc -e does\n");
+  printf("  -f <name> Analyze only the named function\n");
+  printf("  -h        Print this message\n");
+  printf("  -l <n>    Count n iterations of each loop in the path (default 1)\n");
+  printf("  -v        Also print the count of each operator\n");
+  printf("  <file>    Source to analyze (default bits.c)\n");
+  exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+  char c, *text;
+  char *decl = "decl.c", *only = NULL;
+  int verbose = 0, dlc_style = 0;
+
+  while ((c = getopt(argc, argv, "hevd:f:l:")) != -1) {
+    switch (c) {
+    case 'd':
+      decl = optarg;
+      break;
+    case 'e':
+      dlc_style = 1;
+      break;
+    case 'f':
+      only = optarg;
+      break;
+    case 'l':
+      loop_iters = atoi(optarg);
+      if (loop_iters < 1)
+        usage(argv[0]);
+      break;
+    case 'v':
+      verbose = 1;
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+  src_name = optind < argc ? argv[optind] : "bits.c";
+
+  if (!(toks = malloc(MAX_TOKENS * sizeof(*toks)))) {
+    fprintf(stderr, "bitcost: out of memory\n");
+    exit(1);
+  }
+  read_decl(decl);
+  if (!(text = read_lines(src_name))) {
+    fprintf(stderr, "bitcost: cannot read %s\n", src_name);
+    exit(1);
+  }
+  tokenize(text);
+  free(text);
+  analyze(only, verbose, dlc_style);
+  return errors ? 1 : 0;
+}
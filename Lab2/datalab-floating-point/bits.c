@@ -238,27 +238,30 @@ unsigned float_twice(unsigned uf) {
  */
 unsigned float_i2f(int x) {
 
-    unsigned s = x < 0;
-    unsigned f, exp, ux, round;
-    unsigned check = 0x80000000u;
-    int length = 32;
-
-    if (x == 0) return 0;
-
-    if (s) x = -x;
-
-    ux = x;
-    for (; length && !(ux & check); length--, ux <<= 1);
-
-    f = ux >> 7; // 25 bits (1 + 23 + 1)
-    round = ((ux << 25) != 0) | ((f >> 1) & 1);
-    round &= (f & 1);
-    f += round;
-    f = (f << 8) >> 9; // 23 bits
-
-    exp = 126 + length; // <=> 127 + (length - 1)
-
-    return (s << 31) | ((exp + (round & !f)) << 23) | f; // if (f) was rounded up and (f) is 0...0 then we must use (exp + 1) instead of (exp)
+    unsigned m = x >> 31;
+    unsigned s = x & 0x80000000u;
+    unsigned ux = (x ^ m) - m; // |x|, also for 0x80000000
+    unsigned e = 158;          // 127(BIAS) + 31
+    unsigned k = 16;
+    unsigned t, f, rem, round;
+
+    // Move the leading one up to bit 31 by a binary search over the shift.
+    // The loop always runs 5 times, so the time does not depend on x.
+    // The test compares ux with a bound that depends on k only, and the
+    // shift is a masked select, so each step waits on ux for just a
+    // compare, a mask and an xor
+    while (k) {
+        t = -(ux < (1u << (32 - k)));
+        ux ^= (ux ^ (ux << k)) & t;
+        e -= k & t;
+        k >>= 1;
+    }
+
+    f = ux >> 8; // 24 bits (1 + 23)
+    rem = ux & 0xff;
+    round = (rem > 0x80) | ((rem == 0x80) & f); // to nearest even
+
+    return (s | ((e << 23) + (f & 0x7fffff) + round)) & -!!x; // a carry out of (f) bumps the exponent
 }
 /* 
  * float_f2i - Return bit-level equivalent of expression (int) f
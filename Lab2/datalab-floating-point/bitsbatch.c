@@ -0,0 +1,102 @@
+/*
+ * CS:APP Data Lab
+ *
+ * bitsbatch.c - Array versions of the puzzles in bits.c
+ *
+ * The float puzzles in bits.c branch on the exponent and float_i2f
+ * loops to find the leading one. Here every case is computed and the
+ * answer is picked with a select, and the leading one is found with a
+ * fixed five-step binary search, so each loop body is straight-line
+ * code that gcc can vectorize. Per-element shifts (float_f2i) need
+ * AVX2, so every function is also cloned for it.
+ */
+#include "bitsbatch.h"
+
+#define BATCH __attribute__((target_clones("avx2", "default")))
+
+BATCH
+void negate_batch(const int *restrict x, int *restrict out, size_t n)
+{
+    size_t i;
+    for (i = 0; i < n; i++)
+        out[i] = (int) (~(unsigned) x[i] + 1);
+}
+
+BATCH
+void isLess_batch(const int *restrict x, const int *restrict y, int *restrict out, size_t n)
+{
+    size_t i;
+    for (i = 0; i < n; i++) {
+        /* Signs differ: x < y iff x is negative. Otherwise the sign of x - y */
+        int diff = (x[i] ^ y[i]) >> 31;
+        int sub = (int) ((unsigned) x[i] + ~(unsigned) y[i] + 1) >> 31;
+        out[i] = ((diff & x[i]) | (~diff & sub)) >> 31 & 1;
+    }
+}
+
+BATCH
+void float_abs_batch(const unsigned *restrict uf, unsigned *restrict out, size_t n)
+{
+    size_t i;
+    for (i = 0; i < n; i++) {
+        unsigned mag = uf[i] & 0x7fffffff;
+        out[i] = mag > 0x7f800000 ? uf[i] : mag;    /* NaN is returned as is */
+    }
+}
+
+BATCH
+void float_twice_batch(const unsigned *restrict uf, unsigned *restrict out, size_t n)
+{
+    size_t i;
+    for (i = 0; i < n; i++) {
+        unsigned u = uf[i];
+        unsigned s = u & 0x80000000;
+        unsigned exp = (u >> 23) & 0xff;
+        unsigned r = u + (1 << 23);                 /* normalized */
+        r = exp == 0 ? s | (u << 1) : r;            /* denormalized */
+        r = exp == 254 ? s | 0x7f800000 : r;        /* overflows to infinity */
+        out[i] = exp == 255 ? u : r;                /* infinity and NaN */
+    }
+}
+
+BATCH
+void float_i2f_batch(const int *restrict x, unsigned *restrict out, size_t n)
+{
+    size_t i;
+    for (i = 0; i < n; i++) {
+        unsigned s = x[i] & 0x80000000;
+        unsigned ux = s ? ~(unsigned) x[i] + 1 : (unsigned) x[i];
+        unsigned e = 158;                           /* 127 + 31 */
+        unsigned mant, rem, bits;
+
+        /* Shift the leading one up to bit 31 */
+        e -= (ux >> 16) == 0 ? 16 : 0; ux = (ux >> 16) == 0 ? ux << 16 : ux;
+        e -= (ux >> 24) == 0 ? 8 : 0;  ux = (ux >> 24) == 0 ? ux << 8 : ux;
+        e -= (ux >> 28) == 0 ? 4 : 0;  ux = (ux >> 28) == 0 ? ux << 4 : ux;
+        e -= (ux >> 30) == 0 ? 2 : 0;  ux = (ux >> 30) == 0 ? ux << 2 : ux;
+        e -= (ux >> 31) == 0 ? 1 : 0;  ux = (ux >> 31) == 0 ? ux << 1 : ux;
+
+        /* Round to nearest even; a carry out of the fraction bumps e */
+        mant = ux >> 8;
+        rem = ux & 0xff;
+        bits = (e << 23) + (mant & 0x7fffff);
+        bits += rem > 0x80 || (rem == 0x80 && (mant & 1));
+        out[i] = x[i] == 0 ? 0 : s | bits;
+    }
+}
+
+BATCH
+void float_f2i_batch(const unsigned *restrict uf, int *restrict out, size_t n)
+{
+    size_t i;
+    for (i = 0; i < n; i++) {
+        unsigned exp = (uf[i] >> 23) & 0xff;
+        unsigned f = (uf[i] & 0x7fffff) | 0x800000;
+        unsigned l = f << ((exp - 150) & 31), r = f >> ((150 - exp) & 31);
+        unsigned neg = (unsigned) ((int) uf[i] >> 31);
+        unsigned v = exp > 150 ? l : r;
+        v = (v ^ neg) - neg;                        /* negate if the sign is set */
+        v = exp < 127 ? 0 : v;
+        out[i] = (int) (exp > 157 ? 0x80000000 : v); /* 127 + 30 */
+    }
+}
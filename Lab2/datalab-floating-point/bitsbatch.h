@@ -0,0 +1,23 @@
+/*
+ * CS:APP Data Lab
+ *
+ * bitsbatch.h - Array versions of the puzzles in bits.c
+ *
+ * Each function applies one puzzle to n elements without branches, so
+ * that gcc vectorizes it. Floats are passed as their bit patterns, as
+ * in bits.c. bitsbatch.c is built for AVX2 and for the base instruction
+ * set, and the loader picks the right one (target_clones).
+ */
+#ifndef BITSBATCH_H
+#define BITSBATCH_H
+
+#include <stddef.h>
+
+void negate_batch(const int *x, int *out, size_t n);
+void isLess_batch(const int *x, const int *y, int *out, size_t n);
+void float_abs_batch(const unsigned *uf, unsigned *out, size_t n);
+void float_twice_batch(const unsigned *uf, unsigned *out, size_t n);
+void float_i2f_batch(const int *x, unsigned *out, size_t n);
+void float_f2i_batch(const unsigned *uf, int *out, size_t n);
+
+#endif /* BITSBATCH_H */
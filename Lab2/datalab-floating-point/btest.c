@@ -18,9 +18,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
-#include <signal.h>
-#include <setjmp.h>
+#include <errno.h>
 #include <math.h>
+#include <time.h>
+#include <pthread.h>
 #include "btest.h"
 
 /* Not declared in some stdlib.h files, so define here */
@@ -31,7 +32,7 @@ float strtof(const char *nptr, char **endptr);
  *************************/
 
 /* Handle infinite loops by setting upper limit on execution time, in
-   seconds */
+   seconds. Enforced per function by a watchdog; 0 means no limit */
 #define TIMEOUT_LIMIT 10
 
 /* For functions with a single argument, generate TEST_RANGE values
@@ -46,6 +47,19 @@ float strtof(const char *nptr, char **endptr);
    TEST_RANGE, thus MAX_TEST_VALS must be at least k*TEST_RANGE */
 #define MAX_TEST_VALS 13*TEST_RANGE
 
+/* Default time limit for one exhaustive (-x) test, in seconds */
+#define EXHAUSTIVE_TIMEOUT_LIMIT 600
+
+/* Inputs a worker thread checks at a time, and the most workers */
+#define SWEEP_BATCH 4096
+#define MAX_THREADS 256
+
+/* Fuzzer (-z): log2 of the number of feature slots, the most inputs
+   each worker keeps in its corpus, and the most shrinking steps */
+#define FUZZ_MAP_BITS 16
+#define FUZZ_CORPUS 4096
+#define FUZZ_SHRINK_STEPS 10000
+
 /**********************************
  * Globals defined in other modules 
  **********************************/
@@ -63,6 +77,18 @@ static int grade = 0;
 
 /* Time out after this number of seconds */
 static int timeout_limit = TIMEOUT_LIMIT; /* -T */
+static int timeout_given = 0;
+
+/* Check every value of the free argument instead of sampling (-x) */
+static int exhaustive = 0;
+
+/* Number of worker threads (-j); 0 means one per online CPU */
+static int nthreads = 0;
+
+/* Fuzz each function for this many seconds instead of testing the
+   fixed set of values (-z), starting from this seed (-s) */
+static int fuzz_secs = 0;
+static unsigned fuzz_seed = 1;
 
 /* If non-NULL, test only one function (-f) */
 static char* test_fname = NULL;  
@@ -78,32 +104,6 @@ static int global_rating = 0;
  * Helper functions
  ******************/
 
-/*
- * Signal - installs a signal handler
- */
-typedef void handler_t(int);
-
-handler_t *Signal(int signum, handler_t *handler) 
-{
-    struct sigaction action, old_action;
-
-    action.sa_handler = handler;  
-    sigemptyset(&action.sa_mask); /* block sigs of type being handled */
-    action.sa_flags = SA_RESTART; /* restart syscalls if possible */
-
-    if (sigaction(signum, &action, &old_action) < 0)
-	perror("Signal error");
-    return (old_action.sa_handler);
-}
-
-/* 
- * timeout_handler - SIGALARM hander 
- */
-sigjmp_buf envbuf;
-void timeout_handler(int sig) {
-    siglongjmp(envbuf, 1);
-}
-
 /* 
  * random_val - Return random integer value between min and max 
  */
@@ -290,15 +290,773 @@ static int test_3_arg(funct_t f, funct_t ft,
     return error;
 }
 
+/*
+ * The test engine. The inputs of one function are numbered 0..n-1:
+ * with -x, input k is lo + k for the free argument; otherwise it is
+ * the k-th combination of the generated test values, first argument
+ * slowest, which is the order the old nested loops visited them in.
+ * The numbers are cut into SWEEP_BATCH batches dealt round-robin to
+ * the worker threads. A worker runs a whole batch through the
+ * solution, then through the reference, and compares the two result
+ * arrays in one vectorizable pass; only a batch with a difference is
+ * searched for its first bad input.
+ *
+ * Workers keep the smallest failing input in sweep_t.first_fail and
+ * skip only batches that start above it, so the failure reported is
+ * the first one in input order, whatever the number of threads.
+ *
+ * Timeouts are enforced by the main thread acting as a watchdog, not by
+ * a process-wide SIGALRM. When the time limit passes it tells the
+ * workers to stop and cancels those still inside a batch; workers
+ * allow asynchronous cancellation only while running puzzle code.
+ */
+typedef struct {
+    test_ptr t;
+    int exhaustive;
+    int free_arg;               /* -x: index of the swept argument */
+    long long lo;               /* -x: its first value */
+    int counts[3];              /* sampled: test values per argument */
+    int (*vals)[MAX_TEST_VALS]; /* sampled: the test values */
+    long long n;                /* number of inputs */
+    int nthreads;
+    int fuzz;                   /* -z: fuzz instead of sweeping */
+    int fail_args[3];           /* -z: the shrunk failing input */
+    int shrinking;              /* -z: fail_args is still being shrunk */
+    int found_args[3];          /* -z: the input the fuzzer found */
+    long long checks;           /* -z: inputs tried, over all workers */
+    int features;               /* -z: features seen, summed likewise */
+    int corpus;                 /* -z: corpus entries, summed likewise */
+    long long first_fail;       /* smallest failing input, or n */
+    volatile int stop;          /* set by the watchdog */
+    pthread_mutex_t lock;
+    pthread_cond_t done;        /* signaled as each worker finishes */
+    int nrunning;
+} sweep_t;
+
+typedef struct {
+    sweep_t *sw;
+    int id;
+    pthread_t tid;
+    volatile long long next;    /* first input not yet checked */
+    volatile int in_batch;
+    int finished;
+} sweep_worker_t;
+
+/*
+ * args_at - The arguments of input k
+ */
+static void args_at(sweep_t *sw, long long k, int a[3])
+{
+    int i;
+
+    if (sw->exhaustive) {
+	for (i = 0; i < 3; i++)
+	    a[i] = (int) argval[i];
+	a[sw->free_arg] = (int) (sw->lo + k);
+	return;
+    }
+    for (i = sw->t->args - 1; i >= 0; i--) {
+	a[i] = sw->vals[i][k % sw->counts[i]];
+	k /= sw->counts[i];
+    }
+}
+
+/*
+ * call_batch - Results of the solution (r) and reference (rt) on the
+ *     n inputs laid out in av
+ */
+static void call_batch(test_ptr t, int n, int *r, int *rt,
+		       int av[3][SWEEP_BATCH])
+{
+    funct_t f = t->solution_funct, ft = t->test_funct;
+    int i;
+
+    switch (t->args) {
+    case 0:
+	for (i = 0; i < n; i++) {
+	    r[i] = f();
+	    rt[i] = ft();
+	}
+	break;
+    case 1:
+	for (i = 0; i < n; i++)
+	    r[i] = ((funct1_t) f)(av[0][i]);
+	for (i = 0; i < n; i++)
+	    rt[i] = ((funct1_t) ft)(av[0][i]);
+	break;
+    case 2:
+	for (i = 0; i < n; i++)
+	    r[i] = ((funct2_t) f)(av[0][i], av[1][i]);
+	for (i = 0; i < n; i++)
+	    rt[i] = ((funct2_t) ft)(av[0][i], av[1][i]);
+	break;
+    default:
+	for (i = 0; i < n; i++)
+	    r[i] = ((funct3_t) f)(av[0][i], av[1][i], av[2][i]);
+	for (i = 0; i < n; i++)
+	    rt[i] = ((funct3_t) ft)(av[0][i], av[1][i], av[2][i]);
+	break;
+    }
+}
+
+/*
+ * run_batch - Results of the solution (r) and reference (rt) on inputs
+ *     start..start+n-1. The arguments are laid out in av first, so each
+ *     function is called in a tight loop
+ */
+static void run_batch(sweep_t *sw, long long start, int n, int *r, int *rt,
+		      int av[3][SWEEP_BATCH])
+{
+    test_ptr t = sw->t;
+    funct_t f = t->solution_funct, ft = t->test_funct;
+    int idx[3];
+    long long k;
+    int i, j;
+
+    if (sw->exhaustive && t->args == 1) {
+	int v = (int) (sw->lo + start);
+	for (i = 0; i < n; i++)
+	    r[i] = ((funct1_t) f)(v + i);
+	for (i = 0; i < n; i++)
+	    rt[i] = ((funct1_t) ft)(v + i);
+	return;
+    }
+    if (sw->exhaustive) {
+	for (j = 0; j < 3; j++)
+	    for (i = 0; i < n; i++)
+		av[j][i] = (int) argval[j];
+	for (i = 0; i < n; i++)
+	    av[sw->free_arg][i] = (int) (sw->lo + start + i);
+    } else {
+	/* Odometer over the test value indices, last argument fastest */
+	for (k = start, j = t->args - 1; j >= 0; j--) {
+	    idx[j] = k % sw->counts[j];
+	    k /= sw->counts[j];
+	}
+	for (i = 0; i < n; i++) {
+	    for (j = 0; j < t->args; j++)
+		av[j][i] = sw->vals[j][idx[j]];
+	    for (j = t->args - 1; j >= 0 && ++idx[j] == sw->counts[j]; j--)
+		idx[j] = 0;
+	}
+    }
+    call_batch(t, n, r, rt, av);
+}
+
+/*
+ * batch_differs - Nonzero if the two result arrays differ anywhere.
+ *     Written without an early exit so that the compiler vectorizes it.
+ */
+__attribute__((optimize("O3")))
+static int batch_differs(const int *r, const int *rt, int n)
+{
+    int i;
+    int diff = 0;
+
+    for (i = 0; i < n; i++)
+	diff |= r[i] ^ rt[i];
+    return diff != 0;
+}
+
+/*
+ * record_failure - Lower sw->first_fail to k if k is smaller
+ */
+static void record_failure(sweep_t *sw, long long k)
+{
+    long long cur = __atomic_load_n(&sw->first_fail, __ATOMIC_RELAXED);
+
+    while (k < cur &&
+	   !__atomic_compare_exchange_n(&sw->first_fail, &cur, k, 0,
+					__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+	;
+}
+
+/*
+ * The fuzzer (-z). Rather than a fixed grid of test values, each worker
+ * keeps a corpus of inputs and makes every batch by mutating corpus
+ * entries toward the places where bit-level code tends to go wrong:
+ * sign flips, carries across a power of two, shift amounts 0, 31 and
+ * 32, and floating point exponent transitions. The puzzles cannot be
+ * instrumented, so coverage is judged from the input and the reference
+ * result instead. Each input is mapped to a set of edge features (is
+ * an argument zero, tmin or tmax, how wide is it, what is its exponent,
+ * does the sum of two arguments carry or overflow, what class is the
+ * result, ...) and an input showing a feature not seen before joins
+ * the corpus. Batches are run and compared like the sweep's, and a
+ * failing input is shrunk to a simpler one that still fails before it
+ * is reported.
+ */
+typedef struct {
+    unsigned long long rng;
+    int (*corpus)[3];
+    int ncorpus;
+    int nfeatures;
+    unsigned char map[1 << FUZZ_MAP_BITS];
+} fuzz_state_t;
+
+/* Values on an edge of some puzzle */
+static const unsigned fuzz_dict[] = {
+    0, 1, 0xffffffff, 2, 0xfffffffe, 31, 32, 33,
+    0x7fffffff, 0x80000000, 0x7ffffffe, 0x80000001, 0x55555555, 0xaaaaaaaa,
+    0x00800000, 0x007fffff, 0x3f800000, 0x4b000000, 0x4f000000, 0xcf000000,
+    0x7f7fffff, 0x7f800000, 0x7f800001, 0x7fc00000, 0xff800000
+};
+#define FUZZ_DICT_SIZE ((int) (sizeof(fuzz_dict) / sizeof(fuzz_dict[0])))
+
+/* Shift amounts, and exponents on either side of the float boundaries */
+static const int fuzz_shifts[] = {0, 1, 30, 31, 32, 33, -1};
+static const int fuzz_exps[] = {0, 1, 126, 127, 128, 150, 157, 158, 254, 255};
+
+/*
+ * fuzz_rand - Next number from the worker's xorshift64* generator
+ */
+static unsigned fuzz_rand(fuzz_state_t *st)
+{
+    st->rng ^= st->rng >> 12;
+    st->rng ^= st->rng << 25;
+    st->rng ^= st->rng >> 27;
+    return (unsigned) ((st->rng * 0x2545f4914f6cdd1dULL) >> 32);
+}
+
+/*
+ * fuzz_clamp - Bring v into the range of argument i. Values past an end
+ *     land on it, which is itself worth testing
+ */
+static int fuzz_clamp(test_ptr t, int i, int v)
+{
+    /* Floating point puzzles take any bit pattern */
+    if (t->arg_ranges[i][0] == 1 && t->arg_ranges[i][1] == 1)
+	return v;
+    if (v < t->arg_ranges[i][0])
+	return t->arg_ranges[i][0];
+    if (v > t->arg_ranges[i][1])
+	return t->arg_ranges[i][1];
+    return v;
+}
+
+/*
+ * fuzz_mutate - A new value for argument i of input a
+ */
+static int fuzz_mutate(fuzz_state_t *st, test_ptr t, const int a[3], int i)
+{
+    unsigned r = fuzz_rand(st);
+    unsigned v = (unsigned) a[i];
+    unsigned o = (unsigned) a[(r >> 28) % t->args];
+    unsigned e;
+    int k = (r >> 8) & 31;
+
+    switch ((r & 0xff) % 10) {
+    case 0: /* flip one bit */
+	v ^= 1u << k;
+	break;
+    case 1: /* flip the sign */
+	v = (r & 0x2000) ? -v : v ^ 0x80000000;
+	break;
+    case 2: /* step across a nearby carry */
+	e = ((r >> 14) & 7) + 1;
+	v = (r & 0x2000) ? v + e : v - e;
+	break;
+    case 3: /* a power of two or one below it, maybe negated */
+	v = (1u << k) - ((r >> 13) & 1);
+	if (r & 0x4000)
+	    v = -v;
+	break;
+    case 4: /* a shift amount */
+	v = (r & 0x2000) ? (unsigned) fuzz_shifts[(r >> 14) % 7] : (unsigned) k;
+	break;
+    case 5: /* move the exponent to a boundary or next to where it is,
+	       and maybe clear or fill the fraction */
+	e = (r & 0x2000) ? (unsigned) fuzz_exps[(r >> 14) % 10]
+	    : ((v >> 23) + ((r & 0x4000) ? 1 : -1)) & 0xff;
+	v = (v & 0x807fffff) | (e << 23);
+	if (((r >> 18) & 3) == 0)
+	    v &= 0xff800000;
+	else if (((r >> 18) & 3) == 1)
+	    v |= 0x7fffff;
+	break;
+    case 6: /* tie to another argument: equal, opposite, or summing to an edge */
+	switch ((r >> 13) & 7) {
+	case 0: v = o; break;
+	case 1: v = -o; break;
+	case 2: v = ~o; break;
+	case 3: v = o + 1; break;
+	case 4: v = o - 1; break;
+	case 5: v = 0x7fffffff - o; break;
+	case 6: v = 0x80000000 - o; break;
+	default: v = o ^ 0x80000000; break;
+	}
+	break;
+    case 7: /* the same argument of another corpus entry */
+	v = (unsigned) st->corpus[(r >> 8) % st->ncorpus][i];
+	break;
+    case 8:
+	v = fuzz_dict[(r >> 8) % FUZZ_DICT_SIZE];
+	break;
+    default:
+	v = fuzz_rand(st);
+	break;
+    }
+    return fuzz_clamp(t, i, (int) v);
+}
+
+/*
+ * fuzz_note - Mark feature x of the given kind as seen. Returns 1 if
+ *     it had not been
+ */
+static int fuzz_note(fuzz_state_t *st, unsigned kind, unsigned x)
+{
+    unsigned h = kind * 0x9e3779b1u ^ x * 0x85ebca6bu;
+
+    h ^= h >> 15;
+    h *= 0xc2b2ae35u;
+    h = (h ^ (h >> 16)) & ((1 << FUZZ_MAP_BITS) - 1);
+    if (st->map[h])
+	return 0;
+    st->map[h] = 1;
+    st->nfeatures++;
+    return 1;
+}
+
+/* Minus one, zero, one, tmin, tmax, other positive, other negative */
+static unsigned int_class(int v)
+{
+    if (v >= -1 && v <= 1)
+	return v + 1;
+    if (v == INT_MIN)
+	return 3;
+    if (v == INT_MAX)
+	return 4;
+    return v > 0 ? 5 : 6;
+}
+
+/* The sign of v and the number of bits after it */
+static unsigned int_width(int v)
+{
+    unsigned u = v < 0 ? ~(unsigned) v : (unsigned) v;
+    return (v < 0) << 6 | (u ? 32 - __builtin_clz(u) : 0);
+}
+
+/* The sign and exponent of v as a float, and whether the fraction is 0 */
+static unsigned float_class(int v)
+{
+    return ((unsigned) v >> 23) | ((v & 0x7fffff) == 0) << 9;
+}
+
+/*
+ * fuzz_features - Mark the features of input a, whose reference result
+ *     is rt. Returns the number that are new
+ */
+static int fuzz_features(fuzz_state_t *st, test_ptr t, const int a[3], int rt)
+{
+    int i, j, nnew = 0;
+
+    for (i = 0; i < t->args; i++) {
+	int v = a[i];
+	nnew += fuzz_note(st, 8 * i, int_class(v));
+	nnew += fuzz_note(st, 8 * i + 1, int_width(v));
+	nnew += fuzz_note(st, 8 * i + 2, v < 0 ? 33 : v > 32 ? 34 : v);
+	nnew += fuzz_note(st, 8 * i + 3, float_class(v));
+	for (j = i + 1; j < t->args; j++) {
+	    int b = a[j];
+	    unsigned sum = (unsigned) v + b, diff = (unsigned) v - b;
+	    unsigned rel = (v == b) | (v < b) << 1 | ((v ^ b) < 0) << 2
+		| (sum < (unsigned) v) << 3             /* carry out */
+		| ((v ^ sum) & (b ^ sum)) >> 31 << 4    /* v+b overflows */
+		| ((v ^ b) & (v ^ diff)) >> 31 << 5;    /* v-b overflows */
+	    nnew += fuzz_note(st, 32 + 8 * (i + j), rel);
+	    nnew += fuzz_note(st, 33 + 8 * (i + j), int_width(v ^ b));
+	    nnew += fuzz_note(st, 34 + 8 * (i + j), int_class(v) * 7 + int_class(b));
+	}
+    }
+    nnew += fuzz_note(st, 64, int_class(rt));
+    nnew += fuzz_note(st, 65, int_width(rt));
+    nnew += fuzz_note(st, 66, float_class(rt));
+    nnew += fuzz_note(st, 67, int_class(a[0]) * 7 + int_class(rt));
+    return nnew;
+}
+
+/*
+ * fuzz_keep - Add input a to the corpus, over a random entry if it is full
+ */
+static void fuzz_keep(fuzz_state_t *st, const int a[3])
+{
+    int k = (st->ncorpus < FUZZ_CORPUS) ? st->ncorpus++
+	: (int) (fuzz_rand(st) % FUZZ_CORPUS);
+
+    memcpy(st->corpus[k], a, sizeof(st->corpus[k]));
+}
+
+/*
+ * call_one - The result of f on the arguments a
+ */
+static int call_one(funct_t f, int args, const int a[3])
+{
+    switch (args) {
+    case 0:
+	return f();
+    case 1:
+	return ((funct1_t) f)(a[0]);
+    case 2:
+	return ((funct2_t) f)(a[0], a[1]);
+    default:
+	return ((funct3_t) f)(a[0], a[1], a[2]);
+    }
+}
+
+/*
+ * fuzz_cost - How complicated v looks: first the number of bits that
+ *     differ from its sign, then its magnitude
+ */
+static unsigned long long fuzz_cost(int v)
+{
+    unsigned u = (unsigned) v;
+    unsigned long long bits = __builtin_popcount(v < 0 ? ~u : u);
+
+    return bits << 33 | (unsigned long long) (v < 0) << 32 | (v < 0 ? -u : u);
+}
+
+/*
+ * fuzz_shrink - Simplify the failing input a while it keeps failing.
+ *     Each step replaces one free argument by a cheaper candidate: an
+ *     edge value, another argument, half of it, or it with one bit
+ *     cleared or set, or moved by one. Every step is copied to
+ *     sw->fail_args, so that if the watchdog cancels the worker in the
+ *     middle, the input reported is the simplest one found so far.
+ */
+static void fuzz_shrink(sweep_worker_t *w, int a[3])
+{
+    sweep_t *sw = w->sw;
+    test_ptr t = sw->t;
+    int cand[80], b[3];
+    int i, j, c, nc, v, tied, steps, differs, oldtype, progress = 1;
+
+    for (steps = 0; progress && steps < FUZZ_SHRINK_STEPS; steps++) {
+	progress = 0;
+	for (i = 0; i < t->args && !progress; i++) {
+	    if (has_arg[i])
+		continue;
+	    v = a[i];
+	    nc = 0;
+	    cand[nc++] = 0;
+	    cand[nc++] = 1;
+	    cand[nc++] = -1;
+	    cand[nc++] = INT_MIN;
+	    cand[nc++] = INT_MAX;
+	    for (j = 0; j < t->args; j++)
+		cand[nc++] = a[j];
+	    cand[nc++] = v / 2;
+	    cand[nc++] = v >> 1;
+	    for (j = 31; j >= 0; j--)
+		cand[nc++] = (int) ((unsigned) v & ~(1u << j));
+	    for (j = 31; j >= 0; j--)
+		cand[nc++] = (int) ((unsigned) v | (1u << j));
+	    cand[nc++] = (int) -(unsigned) v;
+	    cand[nc++] = (int) ((unsigned) v - 1);
+	    cand[nc++] = (int) ((unsigned) v + 1);
+
+	    /* Arguments equal to this one change with it first, since a
+	       failure often depends on them being equal */
+	    for (c = 0; c < nc && !progress; c++) {
+		if (fuzz_clamp(t, i, cand[c]) != cand[c] ||
+		    fuzz_cost(cand[c]) >= fuzz_cost(v))
+		    continue;
+		for (tied = 1; tied >= 0 && !progress; tied--) {
+		    memcpy(b, a, sizeof(b));
+		    for (j = 0; j < t->args; j++)
+			if (j == i || (tied && b[j] == v && !has_arg[j] &&
+				       fuzz_clamp(t, j, cand[c]) == cand[c]))
+			    b[j] = cand[c];
+		    w->in_batch = 1;
+		    pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, &oldtype);
+		    differs = call_one(t->solution_funct, t->args, b) !=
+			call_one(t->test_funct, t->args, b);
+		    pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, &oldtype);
+		    w->in_batch = 0;
+		    if (differs) {
+			memcpy(a, b, sizeof(b));
+			pthread_mutex_lock(&sw->lock);
+			memcpy(sw->fail_args, a, sizeof(sw->fail_args));
+			pthread_mutex_unlock(&sw->lock);
+			progress = 1;
+		    }
+		}
+	    }
+	}
+    }
+}
+
+/*
+ * fuzz_inputs - One fuzzing worker. Mutates, runs and compares batches
+ *     until told to stop or until it finds a failure, which it records
+ *     in sw, stopping the other workers, and then shrinks
+ */
+static void fuzz_inputs(sweep_worker_t *w)
+{
+    sweep_t *sw = w->sw;
+    test_ptr t = sw->t;
+    fuzz_state_t *st;
+    int r[SWEEP_BATCH], rt[SWEEP_BATCH];
+    int av[3][SWEEP_BATCH];
+    int a[3], found[3];
+    int i, j, m, oldtype, first;
+    long long checks = 0;
+
+    st = calloc(1, sizeof(*st));
+    if (st)
+	st->corpus = malloc(FUZZ_CORPUS * sizeof(*st->corpus));
+    if (!st || !st->corpus) {
+	printf("Error: out of memory\n");
+	exit(1);
+    }
+    st->rng = (((unsigned long long) fuzz_seed << 16) + w->id + 1) * 0x9e3779b97f4a7c15ULL;
+    for (i = 0; i < 3; i++)
+	st->corpus[0][i] = has_arg[i] ? (int) argval[i] : fuzz_clamp(t, i, 0);
+    st->ncorpus = 1;
+
+    while (!sw->stop) {
+	for (i = 0; i < SWEEP_BATCH; i++) {
+	    memcpy(a, st->corpus[fuzz_rand(st) % st->ncorpus], sizeof(a));
+	    for (m = 1 + fuzz_rand(st) % 3; m > 0; m--) {
+		j = fuzz_rand(st) % t->args;
+		if (!has_arg[j])
+		    a[j] = fuzz_mutate(st, t, a, j);
+	    }
+	    for (j = 0; j < 3; j++)
+		av[j][i] = a[j];
+	}
+
+	w->in_batch = 1;
+	pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, &oldtype);
+	call_batch(t, SWEEP_BATCH, r, rt, av);
+	pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, &oldtype);
+	w->in_batch = 0;
+	checks += SWEEP_BATCH;
+
+	if (batch_differs(r, rt, SWEEP_BATCH)) {
+	    for (i = 0; r[i] == rt[i]; i++)
+		;
+	    for (j = 0; j < 3; j++)
+		a[j] = found[j] = av[j][i];
+
+	    /* Recorded before shrinking, which the watchdog may cut short */
+	    pthread_mutex_lock(&sw->lock);
+	    first = (sw->first_fail == sw->n);
+	    if (first) {
+		sw->first_fail = 0;
+		memcpy(sw->fail_args, a, sizeof(a));
+		memcpy(sw->found_args, found, sizeof(found));
+		sw->shrinking = 1;
+	    }
+	    sw->checks += checks;
+	    checks = 0;
+	    sw->stop = 1;
+	    pthread_mutex_unlock(&sw->lock);
+
+	    if (first) {
+		fuzz_shrink(w, a);
+		pthread_mutex_lock(&sw->lock);
+		sw->shrinking = 0;
+		pthread_mutex_unlock(&sw->lock);
+	    }
+	    break;
+	}
+
+	for (i = 0; i < SWEEP_BATCH; i++) {
+	    for (j = 0; j < 3; j++)
+		a[j] = av[j][i];
+	    if (fuzz_features(st, t, a, rt[i]))
+		fuzz_keep(st, a);
+	}
+    }
+
+    pthread_mutex_lock(&sw->lock);
+    sw->checks += checks;
+    sw->corpus += st->ncorpus;
+    if (st->nfeatures > sw->features)
+	sw->features = st->nfeatures;
+    pthread_mutex_unlock(&sw->lock);
+    free(st->corpus);
+    free(st);
+}
+
+/*
+ * sweep_inputs - One sweeping worker. Checks every nthreads-th batch
+ *     until all are done, a failure below them is known, or it is told
+ *     to stop
+ */
+static void sweep_inputs(sweep_worker_t *w)
+{
+    sweep_t *sw = w->sw;
+    long long start, step = (long long) SWEEP_BATCH * sw->nthreads;
+    int r[SWEEP_BATCH], rt[SWEEP_BATCH];
+    int av[3][SWEEP_BATCH];
+    int i, n, oldtype;
+
+    for (start = (long long) w->id * SWEEP_BATCH; ; start += step) {
+	w->next = start;
+	if (start >= sw->n || sw->stop ||
+	    start > __atomic_load_n(&sw->first_fail, __ATOMIC_RELAXED))
+	    break;
+	n = (sw->n - start < SWEEP_BATCH) ? (int) (sw->n - start) : SWEEP_BATCH;
+
+	w->in_batch = 1;
+	pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, &oldtype);
+	run_batch(sw, start, n, r, rt, av);
+	pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, &oldtype);
+	w->in_batch = 0;
+
+	if (!batch_differs(r, rt, n))
+	    continue;
+	for (i = 0; r[i] == rt[i]; i++)
+	    ;
+	record_failure(sw, start + i);
+    }
+}
+
+static void *sweep_thread(void *vargp)
+{
+    sweep_worker_t *w = (sweep_worker_t *) vargp;
+    sweep_t *sw = w->sw;
+
+    if (sw->fuzz)
+	fuzz_inputs(w);
+    else
+	sweep_inputs(w);
+
+    pthread_mutex_lock(&sw->lock);
+    w->finished = 1;
+    sw->nrunning--;
+    pthread_cond_signal(&sw->done);
+    pthread_mutex_unlock(&sw->lock);
+    return NULL;
+}
+
+/*
+ * wait_until - Wait for every worker to finish, or for the deadline.
+ *     Called with sw->lock held. Returns 0 on a timeout
+ */
+static int wait_until(sweep_t *sw, struct timespec *deadline)
+{
+    while (sw->nrunning > 0)
+	if (pthread_cond_timedwait(&sw->done, &sw->lock, deadline) == ETIMEDOUT)
+	    return sw->nrunning == 0;
+    return 1;
+}
+
+/*
+ * run_sweep - Check inputs 0..sw->n-1 on sw->nthreads threads, with a
+ *     time limit of limit seconds (none if 0). Returns 1 if the limit
+ *     passed before every input below sw->first_fail was checked
+ */
+static int run_sweep(sweep_t *sw, int limit)
+{
+    sweep_worker_t workers[MAX_THREADS];
+    struct timespec deadline;
+    /* Rounded up without overflow: a fuzz sweep has n = LLONG_MAX */
+    long long batches = sw->n / SWEEP_BATCH + (sw->n % SWEEP_BATCH != 0);
+    int i, nstarted = 0, timed_out = 0;
+
+    if (sw->nthreads > batches)
+	sw->nthreads = (int) batches;
+    sw->first_fail = sw->n;
+    sw->stop = 0;
+    pthread_mutex_init(&sw->lock, NULL);
+    pthread_cond_init(&sw->done, NULL);
+
+    pthread_mutex_lock(&sw->lock);
+    for (i = 0; i < sw->nthreads; i++) {
+	workers[i].sw = sw;
+	workers[i].id = i;
+	workers[i].next = 0;
+	workers[i].in_batch = 0;
+	workers[i].finished = 0;
+	if (pthread_create(&workers[i].tid, NULL, sweep_thread, &workers[i]) != 0) {
+	    printf("Error: cannot start %d worker threads\n", sw->nthreads);
+	    exit(1);
+	}
+	nstarted++;
+    }
+    sw->nrunning = nstarted;
+
+    /* The watchdog */
+    if (limit <= 0) {
+	while (sw->nrunning > 0)
+	    pthread_cond_wait(&sw->done, &sw->lock);
+    }
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += limit;
+    if (limit > 0 && !wait_until(sw, &deadline)) {
+	/* Give workers between batches a moment to see the stop flag,
+	   then cancel the ones stuck in puzzle code */
+	sw->stop = 1;
+	deadline.tv_nsec += 100000000;
+	if (deadline.tv_nsec >= 1000000000) {
+	    deadline.tv_sec++;
+	    deadline.tv_nsec -= 1000000000;
+	}
+	wait_until(sw, &deadline);
+	for (i = 0; i < nstarted; i++) {
+	    if (!workers[i].finished) {
+		pthread_cancel(workers[i].tid);
+		/* Fuzzing ends at the limit; only a fuzzer still inside
+		   puzzle code has timed out, unless a failure was already
+		   found (and is being shrunk), which is reported instead */
+		if (sw->fuzz && sw->first_fail == sw->n)
+		    timed_out = 1;
+	    }
+	}
+
+	/* The failure found so far stands only if everything below it
+	   was checked */
+	for (i = 0; !sw->fuzz && i < nstarted; i++)
+	    if (workers[i].next <= sw->first_fail && workers[i].next < sw->n)
+		timed_out = 1;
+    }
+    pthread_mutex_unlock(&sw->lock);
+
+    for (i = 0; i < nstarted; i++)
+	pthread_join(workers[i].tid, NULL);
+    pthread_mutex_destroy(&sw->lock);
+    pthread_cond_destroy(&sw->done);
+    return timed_out;
+}
+
+/*
+ * report_args - Print the usual message for arguments a. Returns 1
+ */
+static int report_args(test_ptr t, int a[3])
+{
+    switch (t->args) {
+    case 0:
+	return test_0_arg(t->solution_funct, t->test_funct, t->name);
+    case 1:
+	return test_1_arg(t->solution_funct, t->test_funct, a[0], t->name);
+    case 2:
+	return test_2_arg(t->solution_funct, t->test_funct, a[0], a[1], t->name);
+    default:
+	return test_3_arg(t->solution_funct, t->test_funct, a[0], a[1], a[2], t->name);
+    }
+}
+
+/*
+ * report_failure - Print the usual message for input k. Returns 1
+ */
+static int report_failure(sweep_t *sw, long long k)
+{
+    int a[3] = {0, 0, 0};
+
+    args_at(sw, k, a);
+    return report_args(sw->t, a);
+}
+
 /* 
  * test_function - Test a function.  Return number of errors 
  */
 static int test_function(test_ptr t) {
-    int test_counts[3];    /* number of test values for each arg */
     int args = t->args;    /* number of function arguments */
     int arg_test_range[3]; /* test range for each argument */
-    int i, a1, a2, a3;        
-    int errors = 0;
+    int i;
+    sweep_t sweep;
 
     /* These are the test values for each arg. Declared with the
        static attribute so that the array will be allocated in bss
@@ -335,87 +1093,122 @@ static int test_function(test_ptr t) {
 	arg_test_range[2] = 1;
 
     /* Create a test set for each argument */
+    memset(&sweep, 0, sizeof(sweep));
+    sweep.t = t;
+    sweep.vals = arg_test_vals;
+    sweep.n = 1;
     for (i = 0; i < args; i++) {
-	test_counts[i] =  gen_vals(arg_test_vals[i], 
+	sweep.counts[i] = gen_vals(arg_test_vals[i], 
 				   t->arg_ranges[i][0], /* min */
 				   t->arg_ranges[i][1], /* max */
 				   arg_test_range[i],   
 				   i);
+	sweep.n *= sweep.counts[i];
+    }
 
+    sweep.nthreads = nthreads;
+    if (run_sweep(&sweep, timeout_limit)) {
+	printf("ERROR: Test %s failed.\n  Timed out after %d secs (probably infinite loop)\n", t->name, timeout_limit);
+	return 1;
     }
+    if (sweep.first_fail < sweep.n)
+	return report_failure(&sweep, sweep.first_fail);
+    return 0;
+}
 
-    /* Handle timeouts in the test code */
-    if (timeout_limit > 0) {
-	int rc;
-	rc = sigsetjmp(envbuf, 1);
-	if (rc) {
-	    /* control will reach here if there is a timeout */
-	    errors = 1;
-	    printf("ERROR: Test %s failed.\n  Timed out after %d secs (probably infinite loop)\n", t->name, timeout_limit);
-	    return errors;
+/* 
+ * exhaustive_test - Check one function on every value of its free
+ *     argument. Return number of errors, or -1 if it cannot be swept
+ */
+static int exhaustive_test(test_ptr t)
+{
+    struct timespec t0, t1;
+    int i, nfree = 0;
+    int limit = timeout_given ? timeout_limit : EXHAUSTIVE_TIMEOUT_LIMIT;
+    sweep_t sweep;
+
+    memset(&sweep, 0, sizeof(sweep));
+    sweep.t = t;
+    sweep.exhaustive = 1;
+    for (i = 0; i < t->args; i++) {
+	if (!has_arg[i]) {
+	    sweep.free_arg = i;
+	    nfree++;
 	}
-	alarm(timeout_limit);
+    }
+    if (nfree != 1) {
+	printf("Skipping %s: exhaustive mode needs all arguments but one fixed with -1, -2 or -3\n", t->name);
+	return -1;
     }
 
+    /* Floating point puzzles take any bit pattern */
+    if (t->arg_ranges[sweep.free_arg][0] == 1 && t->arg_ranges[sweep.free_arg][1] == 1) {
+	sweep.lo = INT_MIN;
+	sweep.n = 1LL << 32;
+    } else {
+	sweep.lo = t->arg_ranges[sweep.free_arg][0];
+	sweep.n = (long long) t->arg_ranges[sweep.free_arg][1] - sweep.lo + 1;
+    }
 
-    /* Test function has no arguments */
-    if (args == 0) {
-	errors += test_0_arg(t->solution_funct, t->test_funct, t->name);
-	return errors;
-    } 
+    sweep.nthreads = nthreads;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (run_sweep(&sweep, limit)) {
+	printf("ERROR: Test %s failed.\n  Timed out after %d secs (probably infinite loop)\n", t->name, limit);
+	return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    if (sweep.first_fail < sweep.n)
+	return report_failure(&sweep, sweep.first_fail);
+    if (!grade)
+	printf("Checked %s on all %lld inputs with %d threads in %.1f secs\n", t->name,
+	       sweep.n, sweep.nthreads,
+	       (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9);
+    return 0;
+}
 
-    /* 
-     * Test function has at least one argument 
-     */
-      
-    /* Iterate over the values for first argument */
-
-    for (a1 = 0; a1 < test_counts[0]; a1++) {
-	if (args == 1) {
-	    errors += test_1_arg(t->solution_funct, 
-				 t->test_funct,
-				 arg_test_vals[0][a1],
-				 t->name);
-
-	    /* Stop testing if there is an error */
-	    if (errors)
-		return errors;
-	} 
-	else {
-	    /* if necessary, iterate over values for second argument */
-	    for (a2 = 0; a2 < test_counts[1]; a2++) {
-		if (args == 2) {
-		    errors += test_2_arg(t->solution_funct, 
-					 t->test_funct,
-					 arg_test_vals[0][a1], 
-					 arg_test_vals[1][a2],
-					 t->name);
-
-		    /* Stop testing if there is an error */
-		    if (errors)
-			return errors;
-		} 
-		else {
-		    /* if necessary, iterate over vals for third arg */
-		    for (a3 = 0; a3 < test_counts[2]; a3++) {
-			errors += test_3_arg(t->solution_funct, 
-					     t->test_funct,
-					     arg_test_vals[0][a1], 
-					     arg_test_vals[1][a2],
-					     arg_test_vals[2][a3],
-					     t->name);
-			
-			/* Stop testing if there is an error */
-			if (errors)
-			    return errors;
-		    } /* a3 */
-		}
-	    } /* a2 */
+/*
+ * fuzz_test - Fuzz one function for fuzz_secs seconds. Return number
+ *     of errors
+ */
+static int fuzz_test(test_ptr t)
+{
+    struct timespec t0, t1;
+    double secs;
+    int i;
+    sweep_t sweep;
+
+    if (t->args == 0)
+	return test_function(t);
+
+    memset(&sweep, 0, sizeof(sweep));
+    sweep.t = t;
+    sweep.fuzz = 1;
+    sweep.n = LLONG_MAX;
+    sweep.nthreads = nthreads;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (run_sweep(&sweep, fuzz_secs)) {
+	printf("ERROR: Test %s failed.\n  Timed out after %d secs (probably infinite loop)\n", t->name, fuzz_secs);
+	return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+
+    if (sweep.first_fail < sweep.n) {
+	report_args(t, sweep.fail_args);
+	if (!grade) {
+	    printf("...Found by fuzzing after %lld inputs, shrunk from %s(", sweep.checks, t->name);
+	    for (i = 0; i < t->args; i++)
+		printf("%s%d[0x%x]", i ? "," : "", sweep.found_args[i], sweep.found_args[i]);
+	    printf(")%s\n", sweep.shrinking ? ", until the time limit" : "");
 	}
-    } /* a1 */
-
-    
-    return errors;
+	return 1;
+    }
+    if (!grade)
+	printf("Fuzzed %s with %d threads: %lld inputs in %.1f secs (%.1f million/sec), %d features, %d corpus inputs\n",
+	       t->name, sweep.nthreads, sweep.checks, secs, sweep.checks / secs * 1e-6,
+	       sweep.features, sweep.corpus);
+    return 0;
 }
 
 /* 
@@ -436,7 +1229,14 @@ static int run_tests()
 	double tpoints;
 	if (!test_fname || strcmp(test_set[i].name,test_fname) == 0) {
 	    int rating = global_rating ? global_rating : test_set[i].rating;
-	    terrors = test_function(&test_set[i]);
+	    if (exhaustive) {
+		terrors = exhaustive_test(&test_set[i]);
+		if (terrors < 0)
+		    continue;
+	    } else if (fuzz_secs)
+		terrors = fuzz_test(&test_set[i]);
+	    else
+		terrors = test_function(&test_set[i]);
 	    errors += terrors;
 	    tscore = terrors == 0 ? 1.0 : 0.0;
 	    tpoints = rating * tscore;
@@ -506,15 +1306,19 @@ static int get_num_val(char *sval, unsigned *valp) {
  * usage - Display usage info
  */
 static void usage(char *cmd) {
-    printf("Usage: %s [-hg] [-r <n>] [-f <name> [-1|-2|-3 <val>]*] [-T <time limit>]\n", cmd);
+    printf("Usage: %s [-hgx] [-r <n>] [-f <name> [-1|-2|-3 <val>]*] [-T <time limit>] [-j <threads>] [-z <secs> [-s <seed>]]\n", cmd);
     printf("  -1 <val>  Specify first function argument\n");
     printf("  -2 <val>  Specify second function argument\n");
     printf("  -3 <val>  Specify third function argument\n");
     printf("  -f <name> Test only the named function\n");
     printf("  -g        Compact output for grading (with no error msgs)\n");
     printf("  -h        Print this message\n");
+    printf("  -j <n>    Use n worker threads (default: one per CPU)\n");
     printf("  -r <n>    Give uniform weight of n for all problems\n");
+    printf("  -s <n>    Seed the fuzzer with n (default 1)\n");
     printf("  -T <lim>  Set timeout limit to lim\n");
+    printf("  -x        Test every value of the one argument not given by -1/-2/-3\n");
+    printf("  -z <secs> Fuzz each function for secs seconds instead\n");
     exit(1);
 }
 
@@ -529,7 +1333,7 @@ int main(int argc, char *argv[])
     char c;
 
     /* parse command line args */
-    while ((c = getopt(argc, argv, "hgf:r:T:1:2:3:")) != -1)
+    while ((c = getopt(argc, argv, "hgxf:r:T:j:s:z:1:2:3:")) != -1)
         switch (c) {
         case 'h': /* help */
 	    usage(argv[0]);
@@ -568,13 +1372,38 @@ int main(int argc, char *argv[])
 	    break;
 	case 'T': /* Set timeout limit */
 	    timeout_limit = atoi(optarg);
+	    timeout_given = 1;
+	    break;
+	case 'j': /* number of worker threads */
+	    nthreads = atoi(optarg);
+	    if (nthreads < 1)
+		usage(argv[0]);
+	    break;
+	case 'x': /* exhaustive mode */
+	    exhaustive = 1;
+	    break;
+	case 'z': /* fuzzing mode */
+	    fuzz_secs = atoi(optarg);
+	    if (fuzz_secs < 1)
+		usage(argv[0]);
+	    break;
+	case 's': /* fuzzer seed */
+	    fuzz_seed = strtoul(optarg, NULL, 0);
 	    break;
 	default:
 	    usage(argv[0]);
 	}
 
-    if (timeout_limit > 0) {
-	Signal(SIGALRM, timeout_handler);
+    if (exhaustive && fuzz_secs)
+	usage(argv[0]);
+    if (nthreads > MAX_THREADS) {
+	printf("Warning: -j %d is more than %d threads; using %d\n",
+	       nthreads, MAX_THREADS, MAX_THREADS);
+	nthreads = MAX_THREADS;
+    }
+    if (nthreads < 1) {       /* no -j: one thread per CPU */
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	nthreads = (n < 1) ? 1 : (n > MAX_THREADS) ? MAX_THREADS : (int) n;
     }
 
     /* test each function */
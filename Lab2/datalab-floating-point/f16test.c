@@ -0,0 +1,277 @@
+/*
+ * CS:APP Data Lab
+ *
+ * f16test.c - Check the float16.c conversions, and time them
+ *
+ * Widening is checked on all 65536 half and bf16 values. Narrowing is
+ * checked on every float whose low 16 bits are one of a set of patterns
+ * around the rounding points, or with -x on all 2^32 floats. The scalar
+ * functions are compared with independent references: gcc's _Float16
+ * (the libgcc conversions) for half, and rounding through double for
+ * bf16. Every batch kernel is compared with the scalar functions. Then
+ * each kernel is timed in nanoseconds per element.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <math.h>
+#include "float16.h"
+
+/* Elements per check chunk and per timing pass */
+#define CHUNK 65536
+
+/* Keep timing one kernel until this many seconds have passed */
+#define MIN_SECS 0.1
+
+/* Mismatches printed per test */
+#define MAX_REPORTS 5
+
+/* Low 16 bits of the narrowing inputs: around the half rounding point
+   (bit 12) and the bf16 one (bit 15) */
+static const unsigned low_patterns[] = {
+  0x0000, 0x0001, 0x0fff, 0x1000, 0x1001, 0x1fff, 0x2000, 0x3000,
+  0x7fff, 0x8000, 0x8001, 0x9000, 0xffff
+};
+#define NLOW ((int) (sizeof(low_patterns) / sizeof(low_patterns[0])))
+
+static unsigned in32[CHUNK], out32[CHUNK];
+static unsigned short in16[CHUNK], out16[CHUNK];
+
+static unsigned f2u(float f)
+{
+  unsigned u;
+  memcpy(&u, &f, sizeof(u));
+  return u;
+}
+
+static float u2f(unsigned u)
+{
+  float f;
+  memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+static unsigned ref_to_half(unsigned uf)
+{
+  _Float16 h = (_Float16) u2f(uf);
+  unsigned short u;
+  memcpy(&u, &h, sizeof(u));
+  return u;
+}
+
+static unsigned ref_from_half(unsigned uh)
+{
+  unsigned short u = uh;
+  _Float16 h;
+  memcpy(&h, &u, sizeof(h));
+  return f2u((float) h);
+}
+
+/*
+ * ref_to_bf16 - Pick the nearer of the two bf16 values around uf, by
+ *     measuring both distances exactly in double
+ */
+static unsigned ref_to_bf16(unsigned uf)
+{
+  unsigned lo = uf & 0xffff0000, hi = lo + 0x10000;
+  double f = u2f(uf), dlo, dhi;
+
+  if (isnan(f))
+    return (uf >> 16) | 0x40;
+  if ((uf & 0xffff) == 0)
+    return uf >> 16;
+  dlo = fabs(f - u2f(lo));
+  /* Past the largest bf16, the next value up is 2^128 */
+  dhi = ((hi & 0x7fffffff) == 0x7f800000) ? fabs(copysign(ldexp(1, 128), f) - f)
+                                          : fabs(u2f(hi) - f);
+  if (dlo < dhi || (dlo == dhi && !((lo >> 16) & 1)))
+    return lo >> 16;
+  return (hi >> 16) & 0xffff;
+}
+
+/*
+ * ref_from_bf16 - Decode the fields of ub
+ */
+static unsigned ref_from_bf16(unsigned ub)
+{
+  int s = ub >> 15, e = (ub >> 7) & 0xff, f = ub & 0x7f;
+  double v;
+
+  if (e == 0xff)
+    return ub << 16;
+  v = e ? ldexp(128 + f, e - 134) : ldexp(f, -133);
+  return f2u((float) (s ? -v : v));
+}
+
+static int report(int *reports, const char *what, unsigned in, unsigned got, unsigned want)
+{
+  if ((*reports)++ < MAX_REPORTS)
+    printf("ERROR: %s(0x%x) gives 0x%x, should be 0x%x\n", what, in, got, want);
+  return 1;
+}
+
+/*
+ * check_widen - Check half_to_float and bf16_to_float on all inputs
+ */
+static long check_widen(void)
+{
+  long errors = 0;
+  int i, isa, reports = 0;
+
+  for (i = 0; i < CHUNK; i++) {
+    in16[i] = i;
+    if (half_to_float(i) != ref_from_half(i))
+      errors += report(&reports, "half_to_float", i, half_to_float(i), ref_from_half(i));
+    if (bf16_to_float(i) != ref_from_bf16(i))
+      errors += report(&reports, "bf16_to_float", i, bf16_to_float(i), ref_from_bf16(i));
+  }
+  for (isa = F16_ISA_SCALAR; isa < F16_NISAS; isa++) {
+    if (!float16_set_isa(isa))
+      continue;
+    half_to_float_batch(in16, out32, CHUNK);
+    for (i = 0; i < CHUNK; i++)
+      if (out32[i] != half_to_float(i))
+        errors += report(&reports, "half_to_float_batch", i, out32[i], half_to_float(i));
+    bf16_to_float_batch(in16, out32, CHUNK);
+    for (i = 0; i < CHUNK; i++)
+      if (out32[i] != bf16_to_float(i))
+        errors += report(&reports, "bf16_to_float_batch", i, out32[i], bf16_to_float(i));
+  }
+  return errors;
+}
+
+/*
+ * check_narrow_chunk - Check the narrowing functions on in32
+ */
+static long check_narrow_chunk(int *reports)
+{
+  long errors = 0;
+  int i, isa;
+
+  for (i = 0; i < CHUNK; i++) {
+    unsigned u = in32[i];
+    if (float_to_half(u) != ref_to_half(u))
+      errors += report(reports, "float_to_half", u, float_to_half(u), ref_to_half(u));
+    if (float_to_bf16(u) != ref_to_bf16(u))
+      errors += report(reports, "float_to_bf16", u, float_to_bf16(u), ref_to_bf16(u));
+  }
+  for (isa = F16_ISA_SCALAR; isa < F16_NISAS; isa++) {
+    if (!float16_set_isa(isa))
+      continue;
+    float_to_half_batch(in32, out16, CHUNK);
+    for (i = 0; i < CHUNK; i++)
+      if (out16[i] != float_to_half(in32[i]))
+        errors += report(reports, "float_to_half_batch", in32[i], out16[i], float_to_half(in32[i]));
+    float_to_bf16_batch(in32, out16, CHUNK);
+    for (i = 0; i < CHUNK; i++)
+      if (out16[i] != float_to_bf16(in32[i]))
+        errors += report(reports, "float_to_bf16_batch", in32[i], out16[i], float_to_bf16(in32[i]));
+  }
+  return errors;
+}
+
+static long check_narrow(int all)
+{
+  long errors = 0;
+  long long hi;
+  int i, k, reports = 0;
+
+  if (all) {
+    for (hi = 0; hi < (1LL << 32); hi += CHUNK) {
+      for (i = 0; i < CHUNK; i++)
+        in32[i] = (unsigned) (hi + i);
+      errors += check_narrow_chunk(&reports);
+    }
+    return errors;
+  }
+  for (k = 0; k < NLOW; k++) {
+    for (i = 0; i < CHUNK; i++)
+      in32[i] = ((unsigned) i << 16) | low_patterns[k];
+    errors += check_narrow_chunk(&reports);
+  }
+  return errors;
+}
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * time_kernel - Best time per element of one batch function, in ns
+ */
+static double time_kernel(int which)
+{
+  double best = 1e30, start = now(), t;
+
+  do {
+    t = now();
+    switch (which) {
+    case 0: float_to_half_batch(in32, out16, CHUNK); break;
+    case 1: half_to_float_batch(in16, out32, CHUNK); break;
+    case 2: float_to_bf16_batch(in32, out16, CHUNK); break;
+    default: bf16_to_float_batch(in16, out32, CHUNK);
+    }
+    t = now() - t;
+    if (t < best)
+      best = t;
+  } while (now() - start < MIN_SECS);
+  return best * 1e9 / CHUNK;
+}
+
+static void usage(char *cmd)
+{
+  printf("Usage: %s [-hx]\n", cmd);
+  printf("  -h  Print this message\n");
+  printf("  -x  Check narrowing on all 2^32 floats\n");
+  exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+  char c;
+  int all = 0, isa, i;
+  long errors;
+  double t;
+  unsigned seed = 1;
+
+  while ((c = getopt(argc, argv, "hx")) != -1) {
+    switch (c) {
+    case 'x':
+      all = 1;
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+
+  t = now();
+  errors = check_widen();
+  printf("Widening: %ld errors in all 65536 inputs\n", errors);
+  errors += check_narrow(all);
+  printf("Narrowing: %ld errors in %s (%.1f s)\n", errors,
+         all ? "all 2^32 inputs" : "inputs around the rounding points", now() - t);
+
+  /* Random floats in the half range, and halves, for the timings */
+  for (i = 0; i < CHUNK; i++) {
+    seed = seed * 1103515245 + 12345;
+    in32[i] = f2u(((int) (seed >> 8) - (1 << 23)) / 1024.0f);
+    in16[i] = seed >> 16;
+  }
+  printf("\n%-8s %10s %10s %10s %10s  (ns per element)\n", "Kernel",
+         "to half", "from half", "to bf16", "from bf16");
+  for (isa = F16_ISA_SCALAR; isa < F16_NISAS; isa++) {
+    if (!float16_set_isa(isa)) {
+      printf("%-8s not supported by this CPU\n", float16_isa_name(isa));
+      continue;
+    }
+    printf("%-8s %10.3f %10.3f %10.3f %10.3f\n", float16_isa_name(isa),
+           time_kernel(0), time_kernel(1), time_kernel(2), time_kernel(3));
+  }
+  return errors ? 1 : 0;
+}
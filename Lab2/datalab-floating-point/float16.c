@@ -0,0 +1,314 @@
+/*
+ * CS:APP Data Lab
+ *
+ * float16.c - Conversions between float and the 16-bit float formats
+ *
+ * The conversions are written without branches, in the style of the
+ * float puzzles: every case is computed and the answer picked with a
+ * select, and subnormal halves are normalized with a fixed binary search
+ * instead of a loop. That makes the scalar functions constant-time, and
+ * lets gcc vectorize the batch loops that call them. The F16C and
+ * AVX-512 kernels use the hardware conversions, which give the same
+ * bits, and fall back to the scalar code for the last few elements.
+ */
+#include <immintrin.h>
+#include "float16.h"
+
+#define BATCH __attribute__((target_clones("avx2", "default")))
+
+/* Convert n elements: narrowing and widening kernels */
+typedef void (*narrow_fn)(const unsigned *in, unsigned short *out, size_t n);
+typedef void (*widen_fn)(const unsigned short *in, unsigned *out, size_t n);
+
+static int cur_isa = F16_ISA_AUTO;
+static narrow_fn cur_to_half, cur_to_bf16;
+static widen_fn cur_from_half, cur_from_bf16;
+
+static const char *isa_names[F16_NISAS] = { "auto", "scalar", "f16c", "avx512" };
+
+static inline unsigned to_half(unsigned uf)
+{
+    unsigned s = (uf >> 16) & 0x8000;
+    unsigned a = uf & 0x7fffffff;
+    unsigned m = (a & 0x7fffff) | 0x800000;
+    unsigned shift = (126 - (a >> 23)) & 31;
+    unsigned norm, q, rem, half, r;
+
+    /* Normal: rebias the exponent (127 - 15 = 112) and round off 13 bits */
+    norm = a - (112 << 23);
+    norm = (norm + 0xfff + ((norm >> 13) & 1)) >> 13;
+
+    /* Subnormal: the significand in units of 2^-24, rounded */
+    q = m >> shift;
+    rem = m & ((1u << shift) - 1);
+    half = (1u << shift) >> 1;
+    q += (rem > half) | ((rem == half) & q & 1);
+
+    r = a >= 0x38800000 ? norm : q;             /* 2^-14 */
+    r = a <= 0x33000000 ? 0 : r;                /* 2^-25 rounds to even 0 */
+    r = a >= 0x477ff000 ? 0x7c00 : r;           /* 65520 rounds to infinity */
+    r = a > 0x7f800000 ? 0x7e00 | ((a >> 13) & 0x3ff) : r;
+    return s | r;
+}
+
+static inline unsigned from_half(unsigned uh)
+{
+    unsigned s = (uh & 0x8000) << 16;
+    unsigned e = (uh >> 10) & 0x1f;
+    unsigned f = uh & 0x3ff;
+    unsigned x = f << 22, lz = 0, t, sub, r;
+
+    /* Subnormal: move the leading one of f from bit 22..31 of x to 31 */
+    t = (x >> 24) == 0 ? 8 : 0; lz += t; x <<= t;
+    t = (x >> 28) == 0 ? 4 : 0; lz += t; x <<= t;
+    t = (x >> 30) == 0 ? 2 : 0; lz += t; x <<= t;
+    t = (x >> 31) == 0 ? 1 : 0; lz += t; x <<= t;
+    sub = ((112 - lz) << 23) | ((x << 1) >> 9);
+
+    r = ((e + 112) << 23) | (f << 13);
+    r = e == 0 ? (f ? sub : 0) : r;
+    r = e == 31 ? 0x7f800000 | (f << 13) | (f ? 0x400000 : 0) : r;
+    return s | r;
+}
+
+static inline unsigned to_bf16(unsigned uf)
+{
+    unsigned r = (uf + 0x7fff + ((uf >> 16) & 1)) >> 16;
+    return (uf & 0x7fffffff) > 0x7f800000 ? (uf >> 16) | 0x40 : r;
+}
+
+static inline unsigned from_bf16(unsigned ub)
+{
+    return ub << 16;
+}
+
+/*
+ * float_to_half - Return the half nearest to float uf
+ */
+unsigned float_to_half(unsigned uf)
+{
+    return to_half(uf);
+}
+
+/*
+ * half_to_float - Return the float equal to half uh
+ */
+unsigned half_to_float(unsigned uh)
+{
+    return from_half(uh);
+}
+
+/*
+ * float_to_bf16 - Return the bf16 nearest to float uf
+ */
+unsigned float_to_bf16(unsigned uf)
+{
+    return to_bf16(uf);
+}
+
+/*
+ * bf16_to_float - Return the float equal to bf16 ub
+ */
+unsigned bf16_to_float(unsigned ub)
+{
+    return from_bf16(ub & 0xffff);
+}
+
+/*
+ * Scalar kernels
+ */
+BATCH static void to_half_scalar(const unsigned *restrict in, unsigned short *restrict out, size_t n)
+{
+    size_t i;
+    for (i = 0; i < n; i++)
+        out[i] = to_half(in[i]);
+}
+
+BATCH static void from_half_scalar(const unsigned short *restrict in, unsigned *restrict out, size_t n)
+{
+    size_t i;
+    for (i = 0; i < n; i++)
+        out[i] = from_half(in[i]);
+}
+
+BATCH static void to_bf16_scalar(const unsigned *restrict in, unsigned short *restrict out, size_t n)
+{
+    size_t i;
+    for (i = 0; i < n; i++)
+        out[i] = to_bf16(in[i]);
+}
+
+BATCH static void from_bf16_scalar(const unsigned short *restrict in, unsigned *restrict out, size_t n)
+{
+    size_t i;
+    for (i = 0; i < n; i++)
+        out[i] = from_bf16(in[i]);
+}
+
+/*
+ * F16C kernels: 8 floats at a time. Rounding comes from the immediate,
+ * not the MXCSR. bf16 has no F16C instruction and uses the scalar code
+ */
+__attribute__((target("avx,f16c")))
+static void to_half_f16c(const unsigned *in, unsigned short *out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps((const float *) (in + i));
+        _mm_storeu_si128((__m128i *) (out + i), _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+    }
+    for (; i < n; i++)
+        out[i] = to_half(in[i]);
+}
+
+__attribute__((target("avx,f16c")))
+static void from_half_f16c(const unsigned short *in, unsigned *out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (in + i));
+        _mm256_storeu_ps((float *) (out + i), _mm256_cvtph_ps(v));
+    }
+    for (; i < n; i++)
+        out[i] = from_half(in[i]);
+}
+
+/*
+ * AVX-512 kernels: 16 floats at a time. The bf16 conversion in
+ * AVX512_BF16 (vcvtneps2bf16) flushes subnormals to zero, so bf16 is
+ * rounded with integer instructions instead, as in to_bf16()
+ */
+__attribute__((target("avx512f")))
+static void to_half_avx512(const unsigned *in, unsigned short *out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m512 v = _mm512_loadu_ps((const float *) (in + i));
+        _mm256_storeu_si256((__m256i *) (out + i),
+                            _mm512_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+    }
+    for (; i < n; i++)
+        out[i] = to_half(in[i]);
+}
+
+__attribute__((target("avx512f")))
+static void from_half_avx512(const unsigned short *in, unsigned *out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (in + i));
+        _mm512_storeu_ps((float *) (out + i), _mm512_cvtph_ps(v));
+    }
+    for (; i < n; i++)
+        out[i] = from_half(in[i]);
+}
+
+__attribute__((target("avx512f")))
+static void to_bf16_avx512(const unsigned *in, unsigned short *out, size_t n)
+{
+    const __m512i one = _mm512_set1_epi32(1), bias = _mm512_set1_epi32(0x7fff);
+    const __m512i abs_mask = _mm512_set1_epi32(0x7fffffff), inf = _mm512_set1_epi32(0x7f800000);
+    const __m512i quiet = _mm512_set1_epi32(0x40);
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m512i u = _mm512_loadu_si512((const void *) (in + i));
+        __m512i hi = _mm512_srli_epi32(u, 16);
+        __m512i r = _mm512_add_epi32(_mm512_add_epi32(u, bias), _mm512_and_si512(hi, one));
+        __mmask16 nan = _mm512_cmpgt_epu32_mask(_mm512_and_si512(u, abs_mask), inf);
+        r = _mm512_mask_mov_epi32(_mm512_srli_epi32(r, 16), nan, _mm512_or_si512(hi, quiet));
+        _mm256_storeu_si256((__m256i *) (out + i), _mm512_cvtepi32_epi16(r));
+    }
+    for (; i < n; i++)
+        out[i] = to_bf16(in[i]);
+}
+
+__attribute__((target("avx512f")))
+static void from_bf16_avx512(const unsigned short *in, unsigned *out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (in + i));
+        _mm512_storeu_si512((void *) (out + i), _mm512_slli_epi32(_mm512_cvtepu16_epi32(v), 16));
+    }
+    for (; i < n; i++)
+        out[i] = from_bf16(in[i]);
+}
+
+int float16_isa_supported(int isa)
+{
+    __builtin_cpu_init();
+    switch (isa) {
+    case F16_ISA_AUTO:
+    case F16_ISA_SCALAR:
+        return 1;
+    case F16_ISA_F16C:
+        return __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+    case F16_ISA_AVX512:
+        return __builtin_cpu_supports("avx512f");
+    default:
+        return 0;
+    }
+}
+
+int float16_set_isa(int isa)
+{
+    if (!float16_isa_supported(isa))
+        return 0;
+    if (isa == F16_ISA_AUTO) {
+        isa = F16_ISA_SCALAR;
+        if (float16_isa_supported(F16_ISA_F16C))
+            isa = F16_ISA_F16C;
+        if (float16_isa_supported(F16_ISA_AVX512))
+            isa = F16_ISA_AVX512;
+    }
+    cur_isa = isa;
+    cur_to_half = (isa == F16_ISA_AVX512) ? to_half_avx512 :
+                  (isa == F16_ISA_F16C) ? to_half_f16c : to_half_scalar;
+    cur_from_half = (isa == F16_ISA_AVX512) ? from_half_avx512 :
+                    (isa == F16_ISA_F16C) ? from_half_f16c : from_half_scalar;
+    cur_to_bf16 = (isa == F16_ISA_AVX512) ? to_bf16_avx512 : to_bf16_scalar;
+    cur_from_bf16 = (isa == F16_ISA_AVX512) ? from_bf16_avx512 : from_bf16_scalar;
+    return 1;
+}
+
+int float16_isa(void)
+{
+    if (cur_isa == F16_ISA_AUTO)
+        float16_set_isa(F16_ISA_AUTO);
+    return cur_isa;
+}
+
+const char *float16_isa_name(int isa)
+{
+    return (isa >= 0 && isa < F16_NISAS) ? isa_names[isa] : "unknown";
+}
+
+void float_to_half_batch(const unsigned *uf, unsigned short *out, size_t n)
+{
+    float16_isa();
+    cur_to_half(uf, out, n);
+}
+
+void half_to_float_batch(const unsigned short *uh, unsigned *out, size_t n)
+{
+    float16_isa();
+    cur_from_half(uh, out, n);
+}
+
+void float_to_bf16_batch(const unsigned *uf, unsigned short *out, size_t n)
+{
+    float16_isa();
+    cur_to_bf16(uf, out, n);
+}
+
+void bf16_to_float_batch(const unsigned short *ub, unsigned *out, size_t n)
+{
+    float16_isa();
+    cur_from_bf16(ub, out, n);
+}
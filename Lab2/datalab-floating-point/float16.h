@@ -0,0 +1,51 @@
+/*
+ * CS:APP Data Lab
+ *
+ * float16.h - Conversions between float and the 16-bit float formats
+ *
+ * half is IEEE binary16 (1 sign, 5 exponent, 10 fraction bits) and bf16
+ * is bfloat16 (1 sign, 8 exponent, 7 fraction bits: the top half of a
+ * float). As in bits.c, floats are passed as the unsigned ints holding
+ * their bits, and 16-bit values in the low bits of an unsigned or in an
+ * unsigned short.
+ *
+ * Narrowing rounds to nearest even, keeps subnormals, and turns values
+ * too large for the format into infinity. A NaN keeps its sign and the
+ * top bits of its payload and is quieted, which is what the F16C
+ * instructions do. Widening is exact; half NaNs are quieted like F16C,
+ * and bf16 values are just shifted.
+ */
+#ifndef FLOAT16_H
+#define FLOAT16_H
+
+#include <stddef.h>
+
+/* Instruction sets for the batch functions */
+#define F16_ISA_AUTO   0    /* best one the CPU supports */
+#define F16_ISA_SCALAR 1    /* the bit-level code, vectorized by gcc */
+#define F16_ISA_F16C   2    /* vcvtps2ph/vcvtph2ps on 8 floats at a time */
+#define F16_ISA_AVX512 3    /* the same on 16 floats, and bf16 in AVX-512 */
+#define F16_NISAS      4
+
+unsigned float_to_half(unsigned uf);
+unsigned half_to_float(unsigned uh);
+unsigned float_to_bf16(unsigned uf);
+unsigned bf16_to_float(unsigned ub);
+
+void float_to_half_batch(const unsigned *uf, unsigned short *out, size_t n);
+void half_to_float_batch(const unsigned short *uh, unsigned *out, size_t n);
+void float_to_bf16_batch(const unsigned *uf, unsigned short *out, size_t n);
+void bf16_to_float_batch(const unsigned short *ub, unsigned *out, size_t n);
+
+/* Select the batch kernels. Returns 0 if the CPU does not support isa */
+int float16_set_isa(int isa);
+
+/* The instruction set in use (never F16_ISA_AUTO) */
+int float16_isa(void);
+
+/* Nonzero if the CPU supports isa */
+int float16_isa_supported(int isa);
+
+const char *float16_isa_name(int isa);
+
+#endif /* FLOAT16_H */
@@ -2,6 +2,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include "valstream.h"
 float strtof(const char *nptr, char **endptr);
 
 #define FLOAT_SIZE 32
@@ -11,6 +13,8 @@ float strtof(const char *nptr, char **endptr);
 #define FRAC_MASK ((1<<FRAC_SIZE)-1)
 #define EXP_MASK ((1<<EXP_SIZE)-1)
 
+#define BATCH __attribute__((target_clones("avx2","default")))
+
 /* Floating point helpers */
 unsigned f2u(float f)
 {
@@ -106,7 +110,7 @@ static int get_num_val(char *sval, unsigned *valp) {
   if (isfloat) {
     float fval = strtof(sval, &endp);
     if (!*endp) {
-      *valp = *(unsigned *) &fval;
+      *valp = f2u(fval);
       return 1;
     }
     return 0;
@@ -114,18 +118,235 @@ static int get_num_val(char *sval, unsigned *valp) {
     long long int llval = strtoll(sval, &endp, 0);
     long long int upperbits = llval >> 31;
     /* will give -1 for negative, 0 or 1 for positive */
-    if (valp && (upperbits == 0 || upperbits == -1 || upperbits == 1)) {
-      *valp = (unsigned) llval;
+    if (valp && !*endp && (upperbits == 0 || upperbits == -1 || upperbits == 1)) {
+      /* -0 is the float, not the bit pattern 0 */
+      *valp = (llval == 0 && sval[0] == '-') ? f2u(-0.0f) : (unsigned) llval;
       return 1;
     }
+    if (!ishex && *endp) {
+      /* nan, inf, -inf and infinity, as text dumps of floats print them */
+      float fval = strtof(sval, &endp);
+      if (valp && endp != sval && !*endp) {
+        *valp = f2u(fval);
+        return 1;
+      }
+    }
     return 0;
   }
 }
 
 
+/*
+ * Streaming mode: statistics of a file of values
+ */
+
+/* Distinct NaNs counted one by one; the rest are lumped together. A NaN
+   that finds neither its slot nor a free one in NAN_PROBES tries is one
+   of the rest, so a full table costs no more than a busy one */
+#define NAN_SLOTS 4096
+#define NAN_PROBES 8
+#define NAN_TOP 10
+
+typedef struct {
+  unsigned long long n, neg, zero, denorm, inf, nan, qnan;
+  unsigned long long exp_hist[4][EXP_MASK+1];  /* 4 copies: see float_block */
+  int min_key, max_key;         /* finite values, as ordered integers */
+  unsigned nan_bits[NAN_SLOTS];
+  unsigned long long nan_count[NAN_SLOTS], nan_other;
+} fstats_t;
+
+/* An integer that orders like the float with bits u: -0 just below +0 */
+static int order_key(unsigned u)
+{
+  return (int) (u ^ ((unsigned) ((int) u >> 31) >> 1));
+}
+
+static unsigned key_bits(int key)
+{
+  return (unsigned) key ^ ((unsigned) (key >> 31) >> 1);
+}
+
+static void count_nan(fstats_t *s, unsigned u)
+{
+  unsigned h = (u * 0x9e3779b1u) >> 20, k;
+
+  for (k = 0; k < NAN_PROBES; k++, h = (h + 1) % NAN_SLOTS) {
+    if (s->nan_count[h] && s->nan_bits[h] == u) {
+      s->nan_count[h]++;
+      return;
+    }
+    if (!s->nan_count[h]) {
+      s->nan_bits[h] = u;
+      s->nan_count[h] = 1;
+      return;
+    }
+  }
+  s->nan_other++;
+}
+
+/*
+ * float_block - Add a block of values to the statistics. The fields are
+ *     extracted and classified in one pass that gcc vectorizes, and the
+ *     exponents are counted in a second pass into four histograms in
+ *     turn, so that runs of one exponent do not wait on each other's
+ *     increments
+ */
+BATCH static void float_block(const unsigned *v, size_t n, void *ctx)
+{
+  fstats_t *s = ctx;
+  unsigned e[STREAM_BLOCK];
+  unsigned neg = 0, zero = 0, den = 0, inf = 0, nan = 0;
+  int lo = s->min_key, hi = s->max_key;
+  size_t i;
+
+  for (i = 0; i < n; i++) {
+    unsigned u = v[i];
+    unsigned exp = (u >> FRAC_SIZE) & EXP_MASK, frac = u & FRAC_MASK;
+    unsigned low = exp == 0 ? 1 : 0, high = exp == EXP_MASK ? 1 : 0;
+    unsigned some = frac != 0 ? 1 : 0;
+    int key = order_key(u), skip = -(int) high;
+    /* Infinities and NaNs drop out of the range: written without a
+       select so that gcc sees plain min and max reductions */
+    int klo = key ^ ((0x7fffffff ^ key) & skip);
+    int khi = key ^ (((int) 0x80000000 ^ key) & skip);
+
+    e[i] = exp;
+    neg += u >> (FLOAT_SIZE-1);
+    zero += low & (some ^ 1);
+    den += low & some;
+    inf += high & (some ^ 1);
+    nan += high & some;
+    lo = klo < lo ? klo : lo;
+    hi = khi > hi ? khi : hi;
+  }
+  for (i = 0; i + 4 <= n; i += 4) {
+    s->exp_hist[0][e[i]]++;
+    s->exp_hist[1][e[i+1]]++;
+    s->exp_hist[2][e[i+2]]++;
+    s->exp_hist[3][e[i+3]]++;
+  }
+  for (; i < n; i++)
+    s->exp_hist[0][e[i]]++;
+
+  if (nan)
+    for (i = 0; i < n; i++)
+      if (((v[i] >> FRAC_SIZE) & EXP_MASK) == EXP_MASK && get_frac(v[i])) {
+        s->qnan += (v[i] >> (FRAC_SIZE-1)) & 1;
+        count_nan(s, v[i]);
+      }
+
+  s->n += n;
+  s->neg += neg;
+  s->zero += zero;
+  s->denorm += den;
+  s->inf += inf;
+  s->nan += nan;
+  s->min_key = lo;
+  s->max_key = hi;
+}
+
+static void show_class(const char *name, unsigned long long count,
+                       unsigned long long n)
+{
+  printf("  %-10s %14llu  %7.3f%%\n", name, count, n ? 100.0 * count / n : 0.0);
+}
+
+static void show_stats(fstats_t *s, long long bad)
+{
+  unsigned long long hist[EXP_MASK+1], max = 0, normal;
+  unsigned top[NAN_TOP];
+  char bar[51];
+  int i, k, ntop = 0;
+
+  printf("%llu values", s->n);
+  if (bad)
+    printf(", %lld bad tokens or trailing bytes skipped", bad);
+  printf("\n\n");
+  if (s->n == 0)
+    return;
+
+  normal = s->n - s->zero - s->denorm - s->inf - s->nan;
+  show_class("Negative", s->neg, s->n);
+  show_class("Zero", s->zero, s->n);
+  show_class("Denormal", s->denorm, s->n);
+  show_class("Normal", normal, s->n);
+  show_class("Infinity", s->inf, s->n);
+  show_class("NaN", s->nan, s->n);
+  if (s->nan)
+    printf("  %-10s %14llu quiet, %llu signaling\n", "", s->qnan, s->nan - s->qnan);
+  if (s->min_key <= s->max_key)
+    printf("\nFinite values from %.9g (0x%.8x) to %.9g (0x%.8x)\n",
+           u2f(key_bits(s->min_key)), key_bits(s->min_key),
+           u2f(key_bits(s->max_key)), key_bits(s->max_key));
+
+  for (i = 0; i <= EXP_MASK; i++) {
+    hist[i] = s->exp_hist[0][i] + s->exp_hist[1][i] + s->exp_hist[2][i] +
+      s->exp_hist[3][i];
+    max = hist[i] > max ? hist[i] : max;
+  }
+  printf("\nExponent field    2^e           count   percent\n");
+  for (i = 0; i <= EXP_MASK; i++) {
+    if (!hist[i])
+      continue;
+    stream_bar(bar, 50, hist[i], max);
+    if (i == 0)
+      printf("  0x%.2x   %10s %14llu  %7.3f%%  %s\n", i, "zero/den",
+             hist[i], 100.0 * hist[i] / s->n, bar);
+    else if (i == EXP_MASK)
+      printf("  0x%.2x   %10s %14llu  %7.3f%%  %s\n", i, "inf/nan",
+             hist[i], 100.0 * hist[i] / s->n, bar);
+    else
+      printf("  0x%.2x   %10d %14llu  %7.3f%%  %s\n", i, i - BIAS,
+             hist[i], 100.0 * hist[i] / s->n, bar);
+  }
+
+  if (!s->nan)
+    return;
+  /* The most common NaNs, by insertion into a short sorted list */
+  for (i = 0; i < NAN_SLOTS; i++) {
+    if (!s->nan_count[i])
+      continue;
+    for (k = ntop; k > 0 && s->nan_count[top[k-1]] < s->nan_count[i]; k--)
+      if (k < NAN_TOP)
+        top[k] = top[k-1];
+    if (k < NAN_TOP) {
+      top[k] = i;
+      ntop += ntop < NAN_TOP;
+    }
+  }
+  printf("\nMost common NaNs\n");
+  for (k = 0; k < ntop; k++) {
+    unsigned u = s->nan_bits[top[k]];
+    printf("  0x%.8x  %c %-9s  payload 0x%.6x %14llu\n", u, get_sign(u) ? '-' : '+',
+           (u >> (FRAC_SIZE-1)) & 1 ? "quiet" : "signaling",
+           u & (FRAC_MASK >> 1), s->nan_count[top[k]]);
+  }
+  if (s->nan_other)
+    printf("  %-40s %14llu\n", "others", s->nan_other);
+}
+
+static int show_stream(int argc, char *argv[], int binary)
+{
+  static fstats_t s;
+  long long bad = 0;
+  int i;
+
+  s.min_key = 0x7fffffff;
+  s.max_key = -0x7fffffff - 1;
+  for (i = 2; i < argc; i++)
+    if (stream_values(argv[i], binary, get_num_val, float_block, &s, &bad) < 0)
+      return 1;
+  show_stats(&s, bad);
+  return 0;
+}
+
+
 void usage(char *fname) {
   printf("Usage: %s val1 val2 ...\n", fname);
+  printf("       %s -s|-b file ...\n", fname);
   printf("Values may be given as hex patterns or as floating point numbers\n");
+  printf("With -s, print statistics of the values in text files; with -b,\n");
+  printf("of the 32-bit words in binary files. '-' reads standard input\n");
   exit(0);
 }
 
@@ -136,6 +357,11 @@ int main(int argc, char *argv[])
   unsigned uf;
   if (argc < 2)
     usage(argv[0]);
+  if (!strcmp(argv[1], "-s") || !strcmp(argv[1], "-b")) {
+    if (argc < 3)
+      usage(argv[0]);
+    return show_stream(argc, argv, argv[1][1] == 'b');
+  }
   for (i = 1; i < argc; i++) {
     char *sval = argv[i];
     if (get_num_val(sval, &uf)) {
@@ -0,0 +1,26 @@
+/*
+ * CS:APP Data Lab
+ *
+ * i2f.h - Faster versions of float_i2f for code outside the lab
+ *
+ * All three return the bits of (float) x, rounded to nearest even, and
+ * take the same time for every x. float_i2f in bits.c keeps to the
+ * datalab rules, so it finds the leading one with a binary search and is
+ * no faster on average than a loop. The versions here are free of the
+ * rules: float_i2f_clz counts the leading zeros with one instruction
+ * where the compiler has one, and float_i2f_smear with a portable
+ * bit-smearing count. Use float_i2f_clz unless you are timing the two.
+ */
+#ifndef I2F_H
+#define I2F_H
+
+/* The datalab-legal version, in bits.c */
+unsigned float_i2f(int x);
+
+/* Leading zeros with __builtin_clz (lzcnt or bsr), else the smear below */
+unsigned float_i2f_clz(int x);
+
+/* Leading zeros with an OR-smear and a SWAR population count */
+unsigned float_i2f_smear(int x);
+
+#endif /* I2F_H */
@@ -0,0 +1,232 @@
+/*
+ * CS:APP Data Lab
+ *
+ * i2fbench.c - Latency of float_i2f across the input range
+ *
+ * Inputs are grouped by the position of their leading one. For each
+ * group, i2fbench measures the latency of several ways of computing
+ * (float) x in cycles: the leading-zero loop float_i2f used to have,
+ * the fixed binary search in bits.c, the count-leading-zeros and
+ * bit-smearing versions in i2f.c, and the hardware conversion. Each call
+ * depends on the result of the one before, so the times are latencies,
+ * not throughputs. A constant-time version has the same latency for
+ * every group. All versions are first checked against the reference.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "i2f.h"
+
+/* Inputs per group, and timed passes over them */
+#define NINPUTS 1024
+#define NPASSES 200
+
+/* Groups: 0 for x == 0, then 1..32 for a leading one at bit 0..31 of |x| */
+#define NGROUPS 33
+
+unsigned test_float_i2f(int x);
+
+/*
+ * i2f_loop - float_i2f as it was, with a loop that shifts |x| up one bit
+ *     at a time until the leading one reaches bit 31
+ */
+__attribute__((noinline)) static unsigned i2f_loop(int x)
+{
+  unsigned s = x < 0;
+  unsigned f, exp, ux, round;
+  unsigned check = 0x80000000u;
+  int length = 32;
+
+  if (x == 0) return 0;
+
+  ux = s ? -(unsigned) x : (unsigned) x;
+  for (; length && !(ux & check); length--, ux <<= 1);
+
+  f = ux >> 7;
+  round = ((ux << 25) != 0) | ((f >> 1) & 1);
+  round &= (f & 1);
+  f += round;
+  f = (f << 8) >> 9;
+  exp = 126 + length;
+  return (s << 31) | ((exp + (round & !f)) << 23) | f;
+}
+
+__attribute__((noinline)) static unsigned i2f_bits(int x)
+{
+  return float_i2f(x);
+}
+
+__attribute__((noinline)) static unsigned i2f_hw(int x)
+{
+  float f = (float) x;
+  unsigned u;
+  memcpy(&u, &f, sizeof(u));
+  return u;
+}
+
+typedef struct {
+  char *name;
+  unsigned (*f)(int);
+} variant_t;
+
+static variant_t variants[] = {
+  {"loop", i2f_loop},
+  {"bits.c", i2f_bits},
+  {"clz", float_i2f_clz},
+  {"smear", float_i2f_smear},
+  {"hardware", i2f_hw},
+  {NULL, NULL}
+};
+
+static int inputs[NGROUPS][NINPUTS];
+
+/* Always 0, but the compiler cannot know that */
+static volatile unsigned zero = 0;
+
+static unsigned long long ticks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+/*
+ * latency - Best time per call on one group, in cycles. The next input
+ *     is combined with the last result (times zero) to chain the calls
+ */
+static double latency(unsigned (*f)(int), const int *in)
+{
+  unsigned long long best = ~0ULL, t;
+  unsigned r = 0, z = zero;
+  int pass, i;
+
+  for (pass = 0; pass < NPASSES; pass++) {
+    t = ticks();
+    for (i = 0; i < NINPUTS; i++)
+      r = f(in[i] ^ (int) (r & z));
+    t = ticks() - t;
+    if (t < best)
+      best = t;
+  }
+  return (double) best / NINPUTS;
+}
+
+/*
+ * check - Compare a variant with the reference on the grouped inputs, or
+ *     on every 32-bit input if all is set
+ */
+static int check(variant_t *v, int all)
+{
+  long long i;
+  int g;
+
+  if (all) {
+    for (i = 0; i < (1LL << 32); i++) {
+      int x = (int) (unsigned) i;
+      if (v->f(x) != test_float_i2f(x)) {
+        printf("ERROR: %s(0x%x) gives 0x%x, should be 0x%x\n",
+               v->name, x, v->f(x), test_float_i2f(x));
+        return 0;
+      }
+    }
+    return 1;
+  }
+  for (g = 0; g < NGROUPS; g++) {
+    for (i = 0; i < NINPUTS; i++) {
+      int x = inputs[g][i];
+      if (v->f(x) != test_float_i2f(x)) {
+        printf("ERROR: %s(0x%x) gives 0x%x, should be 0x%x\n",
+               v->name, x, v->f(x), test_float_i2f(x));
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+static void usage(char *cmd)
+{
+  printf("Usage: %s [-hvx]\n", cmd);
+  printf("  -h  Print this message\n");
+  printf("  -v  Print the latency of every group\n");
+  printf("  -x  Check every version on all 2^32 inputs first\n");
+  exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+  char c;
+  int verbose = 0, all = 0, g, i, errors = 0;
+  unsigned seed = 1;
+  double lat[NGROUPS];
+  variant_t *v;
+
+  while ((c = getopt(argc, argv, "hvx")) != -1) {
+    switch (c) {
+    case 'v':
+      verbose = 1;
+      break;
+    case 'x':
+      all = 1;
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+
+  /* Random values with the leading one of |x| at bit g-1, half negative */
+  for (g = 0; g < NGROUPS; g++) {
+    for (i = 0; i < NINPUTS; i++) {
+      unsigned u;
+      seed = seed * 1103515245 + 12345;
+      u = seed ^ (seed >> 16);
+      if (g == 0)
+        u = 0;
+      else if (g == 32)
+        u = 0x80000000u;    /* the only |x| with bit 31 set */
+      else
+        u = (u & ((1u << (g - 1)) - 1)) | (1u << (g - 1));
+      inputs[g][i] = (i & 1) ? (int) -u : (int) u;
+    }
+  }
+
+  printf("Cycles per call (%s)\n",
+#if defined(__x86_64__) || defined(__i386__)
+         "TSC ticks"
+#else
+         "nanoseconds"
+#endif
+         );
+  printf("%-10s %8s %8s %8s %8s\n", "Version", "min", "mean", "max", "spread");
+  for (v = variants; v->name; v++) {
+    double min = 1e30, max = 0, sum = 0;
+
+    if (!check(v, all)) {
+      errors++;
+      continue;
+    }
+    for (g = 0; g < NGROUPS; g++) {
+      lat[g] = latency(v->f, inputs[g]);
+      min = lat[g] < min ? lat[g] : min;
+      max = lat[g] > max ? lat[g] : max;
+      sum += lat[g];
+    }
+    printf("%-10s %8.2f %8.2f %8.2f %8.2f\n", v->name, min, sum / NGROUPS, max, max - min);
+    if (verbose) {
+      for (g = 0; g < NGROUPS; g++)
+        printf("    %s %2d: %6.2f\n", g ? "leading one at bit" : "zero              ",
+               g ? g - 1 : 0, lat[g]);
+    }
+  }
+  return errors ? 1 : 0;
+}
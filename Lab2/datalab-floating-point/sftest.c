@@ -0,0 +1,386 @@
+/*
+ * CS:APP Data Lab
+ *
+ * sftest.c - Check softfloat.c against the SSE unit, and time it
+ *
+ * For every operation and rounding mode, sftest runs the softfloat.c
+ * function and the matching SSE instruction on the same random inputs
+ * and compares the result bits and the exception flags. The inputs
+ * favor the cases where bugs hide: zeros, subnormals, infinities, NaNs,
+ * extreme exponents, fractions of all zeros or all ones, and operands
+ * whose exponents are close enough for the sum to cancel. With -x,
+ * float_sqrt is instead checked on all 2^32 inputs. Then every
+ * operation is timed against the instruction.
+ *
+ * Must be built with SSE math (-msse2 -mfpmath=sse); x86 only.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "softfloat.h"
+
+#if !defined(__SSE2__)
+#error "sftest must be built with -msse2"
+#endif
+
+/* Random cases per operation and rounding mode */
+#define DEFAULT_CASES (1 << 20)
+
+/* Mismatches printed per operation and rounding mode */
+#define MAX_REPORTS 5
+
+/* Elements per timing pass, and the least time spent timing each op */
+#define NTIME 4096
+#define MIN_SECS 0.1
+
+/* MXCSR: all exceptions masked, and the flags the SSE unit reports
+   that softfloat.c models (all but the denormal-operand flag) */
+#define MXCSR_MASKED 0x1f80
+#define MXCSR_FLAGS 0x3d
+
+enum { OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_SQRT, OP_FMA, OP_EQ, OP_LT, OP_LE, NOPS };
+
+typedef struct {
+  char *name;
+  int args;
+} op_t;
+
+static op_t ops[NOPS] = {
+  {"add", 2}, {"sub", 2}, {"mul", 2}, {"div", 2}, {"sqrt", 1},
+  {"fma", 3}, {"eq", 2}, {"lt", 2}, {"le", 2}
+};
+
+static char *mode_names[] = {"nearest", "down", "up", "zero"};
+
+static int have_fma;
+
+static unsigned soft(int op, unsigned a, unsigned b, unsigned c)
+{
+  switch (op) {
+  case OP_ADD: return float_add(a, b);
+  case OP_SUB: return float_sub(a, b);
+  case OP_MUL: return float_mul(a, b);
+  case OP_DIV: return float_div(a, b);
+  case OP_SQRT: return float_sqrt(a);
+  case OP_FMA: return float_fma(a, b, c);
+  case OP_EQ: return float_eq(a, b);
+  case OP_LT: return float_lt(a, b);
+  default: return float_le(a, b);
+  }
+}
+
+/* x = x op y, between loading and storing the MXCSR */
+#define SSE_OP(insn)                                              \
+  __asm__ volatile("ldmxcsr %[csr]\n\t" insn " %[y], %[x]\n\tstmxcsr %[out]" \
+                   : [x] "+x"(x), [out] "=m"(out)                       \
+                   : [y] "x"(y), [csr] "m"(csr))
+
+/* An (u)comiss followed by two setcc; the result is the and of both */
+#define SSE_CMP(insn, cc)                                         \
+  __asm__ volatile("ldmxcsr %[csr]\n\t" insn " %[y], %[x]\n\t"          \
+                   "set" cc " %[r]\n\tsetnp %[p]\n\tstmxcsr %[out]"     \
+                   : [r] "=q"(r), [p] "=q"(p), [out] "=m"(out)          \
+                   : [x] "x"(x), [y] "x"(y), [csr] "m"(csr) : "cc")
+
+/*
+ * hw - Run op on the SSE unit in the given rounding mode, and return the
+ *     result and the flags it raised
+ */
+static unsigned hw(int op, unsigned a, unsigned b, unsigned c, int mode, unsigned *flags)
+{
+  unsigned csr = MXCSR_MASKED | (mode << 13), out = 0, u;
+  float x, y, z;
+  unsigned char r = 0, p = 0;
+
+  memcpy(&x, &a, sizeof(x));
+  memcpy(&y, &b, sizeof(y));
+  memcpy(&z, &c, sizeof(z));
+  switch (op) {
+  case OP_ADD: SSE_OP("addss"); break;
+  case OP_SUB: SSE_OP("subss"); break;
+  case OP_MUL: SSE_OP("mulss"); break;
+  case OP_DIV: SSE_OP("divss"); break;
+  case OP_SQRT: y = x; SSE_OP("sqrtss"); break;
+  case OP_FMA:
+    /* y = x * y + z. NaNs are picked in the order x, y, z */
+    __asm__ volatile("ldmxcsr %[csr]\n\tvfmadd213ss %[z], %[x], %[y]\n\tstmxcsr %[out]"
+                     : [y] "+x"(y), [out] "=m"(out)
+                     : [x] "x"(x), [z] "x"(z), [csr] "m"(csr));
+    x = y;
+    break;
+  case OP_EQ: SSE_CMP("ucomiss", "e"); break;
+  case OP_LT: SSE_CMP("comiss", "b"); break;
+  case OP_LE: SSE_CMP("comiss", "be"); break;
+  }
+  *flags = out & MXCSR_FLAGS;
+  if (op >= OP_EQ)
+    return r & p;
+  memcpy(&u, &x, sizeof(u));
+  return u;
+}
+
+/* xorshift64* */
+static unsigned long long rng = 0x9e3779b97f4a7c15ULL;
+
+static unsigned rand32(void)
+{
+  rng ^= rng >> 12;
+  rng ^= rng << 25;
+  rng ^= rng >> 27;
+  return (unsigned) ((rng * 0x2545f4914f6cdd1dULL) >> 32);
+}
+
+/*
+ * gen_float - A random float, with the special exponents and fractions
+ *     much more likely than in uniform bits. If near >= 0, the exponent
+ *     is usually within 26 of near
+ */
+static unsigned gen_float(int near)
+{
+  unsigned r = rand32(), frac;
+  int exp;
+
+  if (near >= 0 && (r & 1)) {
+    exp = near + (int) (rand32() % 53) - 26;
+    exp = exp < 0 ? 0 : exp > 255 ? 255 : exp;
+  } else {
+    switch ((r >> 1) % 16) {
+    case 0: exp = 0; break;
+    case 1: exp = 255; break;
+    case 2: exp = 1; break;
+    case 3: exp = 254; break;
+    case 4: case 5: exp = 125 + (int) (rand32() % 5); break;
+    default: exp = rand32() & 0xff;
+    }
+  }
+  switch ((r >> 5) % 8) {
+  case 0: frac = 0; break;
+  case 1: frac = 1; break;
+  case 2: frac = 0x7fffff; break;
+  case 3: frac = 0x400000 | (rand32() & 1); break;
+  case 4: frac = 0x7fffff ^ (1u << (rand32() % 23)); break;
+  case 5: frac = (1u << (rand32() % 23)) | (rand32() & 1); break;
+  default: frac = rand32() & 0x7fffff;
+  }
+  return (r & 0x80000000) | ((unsigned) exp << 23) | frac;
+}
+
+static int exp_of(unsigned u)
+{
+  return (u >> 23) & 0xff;
+}
+
+/*
+ * check_case - Compare one case, and report it if it differs. Returns 1
+ *     if it differs
+ */
+static int check_case(int op, unsigned a, unsigned b, unsigned c, int mode, int *reports)
+{
+  unsigned want, want_flags, got, got_flags;
+
+  want = hw(op, a, b, c, mode, &want_flags);
+  float_rounding_mode = mode;
+  float_exception_flags = 0;
+  got = soft(op, a, b, c);
+  got_flags = float_exception_flags;
+  if (got == want && got_flags == want_flags)
+    return 0;
+  if ((*reports)++ < MAX_REPORTS) {
+    printf("ERROR: float_%s(0x%08x", ops[op].name, a);
+    if (ops[op].args > 1)
+      printf(", 0x%08x", b);
+    if (ops[op].args > 2)
+      printf(", 0x%08x", c);
+    printf(") rounding %s gives 0x%08x flags 0x%02x, should be 0x%08x flags 0x%02x\n",
+           mode_names[mode], got, got_flags, want, want_flags);
+  }
+  return 1;
+}
+
+/*
+ * check_random - Check op on ncases random inputs. Returns the number
+ *     of mismatches
+ */
+static long check_random(int op, int mode, long ncases)
+{
+  long i, errors = 0;
+  int reports = 0;
+  unsigned a, b, c;
+
+  for (i = 0; i < ncases; i++) {
+    a = gen_float(-1);
+    b = gen_float(exp_of(a));
+    c = gen_float(exp_of(a) + exp_of(b) - 127);
+    errors += check_case(op, a, b, c, mode, &reports);
+  }
+  return errors;
+}
+
+static long check_sqrt_all(int mode)
+{
+  long long u;
+  long errors = 0;
+  int reports = 0;
+
+  for (u = 0; u < (1LL << 32); u++)
+    errors += check_case(OP_SQRT, (unsigned) u, 0, 0, mode, &reports);
+  return errors;
+}
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static unsigned ta[NTIME], tb[NTIME], tc[NTIME];
+
+/* Results of the timed loops, so that they are not optimized away */
+static volatile unsigned sink;
+
+/*
+ * hw_fast - op on the SSE unit, without touching the MXCSR
+ */
+static unsigned hw_fast(int op, unsigned a, unsigned b, unsigned c)
+{
+  float x, y, z;
+  unsigned u;
+
+  memcpy(&x, &a, sizeof(x));
+  memcpy(&y, &b, sizeof(y));
+  memcpy(&z, &c, sizeof(z));
+  switch (op) {
+  case OP_ADD: __asm__("addss %1, %0" : "+x"(x) : "x"(y)); break;
+  case OP_SUB: __asm__("subss %1, %0" : "+x"(x) : "x"(y)); break;
+  case OP_MUL: __asm__("mulss %1, %0" : "+x"(x) : "x"(y)); break;
+  case OP_DIV: __asm__("divss %1, %0" : "+x"(x) : "x"(y)); break;
+  case OP_SQRT: __asm__("sqrtss %0, %0" : "+x"(x)); break;
+  case OP_FMA: __asm__("vfmadd213ss %2, %1, %0" : "+x"(y) : "x"(x), "x"(z)); x = y; break;
+  case OP_EQ: return x == y;
+  case OP_LT: return x < y;
+  default: return x <= y;
+  }
+  memcpy(&u, &x, sizeof(u));
+  return u;
+}
+
+/*
+ * time_op - Best time per operation in nanoseconds, in software if sw
+ *     is set and on the SSE unit otherwise
+ */
+static double time_op(int op, int sw)
+{
+  double best = 1e30, start = now(), t;
+  unsigned sum = 0;
+  int i;
+
+  do {
+    t = now();
+    if (sw)
+      for (i = 0; i < NTIME; i++)
+        sum += soft(op, ta[i], tb[i], tc[i]);
+    else
+      for (i = 0; i < NTIME; i++)
+        sum += hw_fast(op, ta[i], tb[i], tc[i]);
+    t = now() - t;
+    sink = sum;
+    if (t < best)
+      best = t;
+  } while (now() - start < MIN_SECS);
+  return best * 1e9 / NTIME;
+}
+
+static void usage(char *cmd)
+{
+  printf("Usage: %s [-hx] [-n <cases>] [-o <op>] [-r <mode>] [-s <seed>]\n", cmd);
+  printf("  -h        Print this message\n");
+  printf("  -n <n>    Random cases per operation and rounding mode (default %d)\n", DEFAULT_CASES);
+  printf("  -o <op>   Only check op: add, sub, mul, div, sqrt, fma, eq, lt or le\n");
+  printf("  -r <mode> Only check one rounding mode: nearest, down, up or zero\n");
+  printf("  -s <seed> Seed for the random inputs\n");
+  printf("  -x        Check sqrt on all 2^32 inputs instead of random ones\n");
+  exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+  char c;
+  long ncases = DEFAULT_CASES, errors = 0, e;
+  int op, mode, only_op = -1, only_mode = -1, exhaustive = 0, i;
+
+  while ((c = getopt(argc, argv, "hxn:o:r:s:")) != -1) {
+    switch (c) {
+    case 'x':
+      exhaustive = 1;
+      break;
+    case 'n':
+      ncases = atol(optarg);
+      break;
+    case 'o':
+      for (only_op = 0; only_op < NOPS; only_op++)
+        if (strcmp(optarg, ops[only_op].name) == 0)
+          break;
+      if (only_op == NOPS)
+        usage(argv[0]);
+      break;
+    case 'r':
+      for (only_mode = 0; only_mode < 4; only_mode++)
+        if (strcmp(optarg, mode_names[only_mode]) == 0)
+          break;
+      if (only_mode == 4)
+        usage(argv[0]);
+      break;
+    case 's':
+      rng = strtoull(optarg, NULL, 0) | 1;
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+  have_fma = __builtin_cpu_supports("fma");
+  if (exhaustive)
+    only_op = OP_SQRT;
+
+  for (op = 0; op < NOPS; op++) {
+    if (only_op >= 0 && op != only_op)
+      continue;
+    if (op == OP_FMA && !have_fma) {
+      printf("%-5s skipped: this CPU has no FMA instructions\n", ops[op].name);
+      continue;
+    }
+    for (mode = 0; mode < 4; mode++) {
+      double t;
+      if (only_mode >= 0 && mode != only_mode)
+        continue;
+      t = now();
+      e = exhaustive ? check_sqrt_all(mode) : check_random(op, mode, ncases);
+      printf("%-5s %-8s %ld errors in %lld%s cases (%.1f s)\n", ops[op].name,
+             mode_names[mode], e, exhaustive ? 1LL << 32 : (long long) ncases,
+             exhaustive ? "" : " random", now() - t);
+      fflush(stdout);
+      errors += e;
+    }
+  }
+
+  /* Throughput, on the same kind of inputs */
+  printf("\n%-5s %12s %12s %8s\n", "Op", "soft ns/op", "SSE ns/op", "ratio");
+  float_rounding_mode = FLOAT_ROUND_NEAREST;
+  for (i = 0; i < NTIME; i++) {
+    ta[i] = gen_float(-1);
+    tb[i] = gen_float(exp_of(ta[i]));
+    tc[i] = gen_float(exp_of(ta[i]) + exp_of(tb[i]) - 127);
+  }
+  for (op = 0; op < NOPS; op++) {
+    double ts, th;
+    if ((only_op >= 0 && op != only_op) || (op == OP_FMA && !have_fma))
+      continue;
+    ts = time_op(op, 1);
+    th = time_op(op, 0);
+    printf("%-5s %12.2f %12.2f %7.1fx\n", ops[op].name, ts, th, ts / th);
+  }
+  return errors ? 1 : 0;
+}
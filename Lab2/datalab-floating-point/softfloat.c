@@ -0,0 +1,514 @@
+/*
+ * CS:APP Data Lab
+ *
+ * softfloat.c - Single-precision arithmetic on bit-level floats
+ *
+ * The algorithms follow John Hauser's Berkeley SoftFloat (release 3),
+ * specialized for x86 SSE: tininess is detected after rounding, the
+ * default NaN is 0xffc00000, and an operation on NaNs returns the first
+ * NaN argument, quieted.
+ *
+ * Intermediate significands are kept in 32-bit (or, for products, 64-bit)
+ * unsigned ints with the leading one at bit 30 and 7 extra bits below
+ * the rounding position. Bits shifted out at the bottom are "jammed"
+ * into the lowest bit, so that rounding can tell an exact half from
+ * slightly more than a half.
+ */
+#include "softfloat.h"
+
+__thread int float_rounding_mode = FLOAT_ROUND_NEAREST;
+__thread unsigned float_exception_flags = 0;
+
+#define SIGN(u) ((u) >> 31)
+#define EXP(u) ((int) ((u) >> 23) & 0xff)
+#define FRAC(u) ((u) & 0x7fffff)
+
+/* The exponent is added to rather than or'ed in, so that a significand
+   with its leading one at bit 23 bumps it by one */
+#define PACK(s, e, f) (((unsigned) (s) << 31) + ((unsigned) (e) << 23) + (f))
+
+#define IS_NAN(u) (((u) & 0x7fffffff) > 0x7f800000)
+#define IS_SNAN(u) (IS_NAN(u) && !((u) & 0x400000))
+#define QUIET 0x400000
+#define DEFAULT_NAN 0xffc00000u
+
+static void set_flags(unsigned flags)
+{
+    float_exception_flags |= flags;
+}
+
+static int clz32(unsigned a)
+{
+    return a ? __builtin_clz(a) : 32;
+}
+
+static int clz64(unsigned long long a)
+{
+    return a ? __builtin_clzll(a) : 64;
+}
+
+/*
+ * jam32 - a >> dist, with the lowest bit set if any one was shifted out
+ */
+static unsigned jam32(unsigned a, int dist)
+{
+    if (dist <= 0)
+        return a;
+    if (dist >= 31)
+        return a != 0;
+    return (a >> dist) | ((a << (32 - dist)) != 0);
+}
+
+static unsigned long long jam64(unsigned long long a, int dist)
+{
+    if (dist <= 0)
+        return a;
+    if (dist >= 63)
+        return a != 0;
+    return (a >> dist) | ((a << (64 - dist)) != 0);
+}
+
+/*
+ * propagate_nan - The result of an operation on uf and ug when at least
+ *     one of them is a NaN: the first NaN, quieted
+ */
+static unsigned propagate_nan(unsigned uf, unsigned ug)
+{
+    if (IS_SNAN(uf) || IS_SNAN(ug))
+        set_flags(FLOAT_INVALID);
+    return (IS_NAN(uf) ? uf : ug) | QUIET;
+}
+
+static unsigned invalid(void)
+{
+    set_flags(FLOAT_INVALID);
+    return DEFAULT_NAN;
+}
+
+/*
+ * norm_subnormal - Shift the fraction of a subnormal until its leading
+ *     one is at bit 23, and set *exp to the matching exponent
+ */
+static unsigned norm_subnormal(unsigned frac, int *exp)
+{
+    int shift = clz32(frac) - 8;
+    *exp = 1 - shift;
+    return frac << shift;
+}
+
+/*
+ * round_pack - Round sig, whose leading one is at bit 30 (or lower, if
+ *     exp is 0), to 24 bits and assemble the float. exp is one less than
+ *     the biased exponent of the result
+ */
+static unsigned round_pack(unsigned s, int exp, unsigned sig)
+{
+    int mode = float_rounding_mode;
+    unsigned inc, round_bits = sig & 0x7f;
+
+    if (mode == FLOAT_ROUND_NEAREST)
+        inc = 0x40;
+    else
+        inc = (mode == (s ? FLOAT_ROUND_DOWN : FLOAT_ROUND_UP)) ? 0x7f : 0;
+
+    if ((unsigned) exp >= 0xfd) {
+        if (exp < 0) {
+            /* Subnormal. Tiny if still below 2^-126 after rounding */
+            int tiny = exp < -1 || sig + inc < 0x80000000;
+            sig = jam32(sig, -exp);
+            exp = 0;
+            round_bits = sig & 0x7f;
+            if (tiny && round_bits)
+                set_flags(FLOAT_UNDERFLOW);
+        } else if (exp > 0xfd || sig + inc >= 0x80000000) {
+            /* Infinity, or the largest finite float when rounding inward */
+            set_flags(FLOAT_OVERFLOW | FLOAT_INEXACT);
+            return PACK(s, 0xff, 0) - !inc;
+        }
+    }
+
+    sig = (sig + inc) >> 7;
+    if (round_bits)
+        set_flags(FLOAT_INEXACT);
+    if (round_bits == 0x40 && mode == FLOAT_ROUND_NEAREST)
+        sig &= ~1u;                     /* a tie: round to even */
+    if (!sig)
+        exp = 0;
+    return PACK(s, exp, sig);
+}
+
+/*
+ * norm_round_pack - round_pack() for a sig whose leading one can be
+ *     anywhere
+ */
+static unsigned norm_round_pack(unsigned s, int exp, unsigned sig)
+{
+    int shift = clz32(sig) - 1;
+
+    exp -= shift;
+    if (shift >= 7 && (unsigned) exp < 0xfd)
+        return PACK(s, sig ? exp : 0, sig << (shift - 7));   /* exact */
+    return round_pack(s, exp, sig << shift);
+}
+
+/*
+ * add_mags - |uf| + |ug|, with the sign of uf
+ */
+static unsigned add_mags(unsigned uf, unsigned ug)
+{
+    int ef = EXP(uf), eg = EXP(ug), ez, diff = ef - eg;
+    unsigned ff = FRAC(uf), fg = FRAC(ug), fz, s = SIGN(uf);
+
+    if (!diff) {
+        if (!ef)
+            return uf + fg;             /* subnormals add exactly */
+        if (ef == 0xff)
+            return (ff | fg) ? propagate_nan(uf, ug) : uf;
+        ez = ef;
+        fz = 0x01000000 + ff + fg;
+        if (!(fz & 1) && ez < 0xfe)
+            return PACK(s, ez, fz >> 1);
+        fz <<= 6;
+    } else {
+        ff <<= 6;
+        fg <<= 6;
+        if (diff < 0) {
+            if (eg == 0xff)
+                return fg ? propagate_nan(uf, ug) : PACK(s, 0xff, 0);
+            ez = eg;
+            ff += ef ? 0x20000000 : ff;
+            ff = jam32(ff, -diff);
+        } else {
+            if (ef == 0xff)
+                return ff ? propagate_nan(uf, ug) : uf;
+            ez = ef;
+            fg += eg ? 0x20000000 : fg;
+            fg = jam32(fg, diff);
+        }
+        fz = 0x20000000 + ff + fg;
+        if (fz < 0x40000000) {
+            ez--;
+            fz <<= 1;
+        }
+    }
+    return round_pack(s, ez, fz);
+}
+
+/*
+ * sub_mags - |uf| - |ug|, with the sign of uf flipped if |ug| is larger
+ */
+static unsigned sub_mags(unsigned uf, unsigned ug)
+{
+    int ef = EXP(uf), eg = EXP(ug), ez, diff = ef - eg, shift, fdiff;
+    unsigned ff = FRAC(uf), fg = FRAC(ug), fx, fy, s = SIGN(uf);
+
+    if (!diff) {
+        if (ef == 0xff)
+            return (ff | fg) ? propagate_nan(uf, ug) : invalid();
+        fdiff = (int) ff - (int) fg;
+        if (!fdiff)
+            return PACK(float_rounding_mode == FLOAT_ROUND_DOWN, 0, 0);
+        if (ef)
+            ef--;
+        if (fdiff < 0) {
+            s = !s;
+            fdiff = -fdiff;
+        }
+        /* The difference is exact; just normalize it */
+        shift = clz32(fdiff) - 8;
+        ez = ef - shift;
+        if (ez < 0) {
+            shift = ef;
+            ez = 0;
+        }
+        return PACK(s, ez, (unsigned) fdiff << shift);
+    }
+
+    ff <<= 7;
+    fg <<= 7;
+    if (diff < 0) {
+        s = !s;
+        if (eg == 0xff)
+            return fg ? propagate_nan(uf, ug) : PACK(s, 0xff, 0);
+        ez = eg - 1;
+        fx = fg | 0x40000000;
+        fy = ff + (ef ? 0x40000000 : ff);
+        diff = -diff;
+    } else {
+        if (ef == 0xff)
+            return ff ? propagate_nan(uf, ug) : uf;
+        ez = ef - 1;
+        fx = ff | 0x40000000;
+        fy = fg + (eg ? 0x40000000 : fg);
+    }
+    return norm_round_pack(s, ez, fx - jam32(fy, diff));
+}
+
+/*
+ * float_add - Return bit-level equivalent of uf + ug
+ */
+unsigned float_add(unsigned uf, unsigned ug)
+{
+    return SIGN(uf ^ ug) ? sub_mags(uf, ug) : add_mags(uf, ug);
+}
+
+/*
+ * float_sub - Return bit-level equivalent of uf - ug
+ */
+unsigned float_sub(unsigned uf, unsigned ug)
+{
+    return SIGN(uf ^ ug) ? add_mags(uf, ug) : sub_mags(uf, ug);
+}
+
+/*
+ * float_mul - Return bit-level equivalent of uf * ug
+ */
+unsigned float_mul(unsigned uf, unsigned ug)
+{
+    int ef = EXP(uf), eg = EXP(ug), ez;
+    unsigned ff = FRAC(uf), fg = FRAC(ug), fz, s = SIGN(uf ^ ug);
+    unsigned long long prod;
+
+    if (ef == 0xff || eg == 0xff) {
+        if (IS_NAN(uf) || IS_NAN(ug))
+            return propagate_nan(uf, ug);
+        if (!(ef | ff) || !(eg | fg))
+            return invalid();           /* infinity times zero */
+        return PACK(s, 0xff, 0);
+    }
+    if (!ef) {
+        if (!ff)
+            return PACK(s, 0, 0);
+        ff = norm_subnormal(ff, &ef);
+    }
+    if (!eg) {
+        if (!fg)
+            return PACK(s, 0, 0);
+        fg = norm_subnormal(fg, &eg);
+    }
+
+    ez = ef + eg - 0x7f;
+    ff = (ff | 0x800000) << 7;
+    fg = (fg | 0x800000) << 8;
+    prod = (unsigned long long) ff * fg;
+    fz = (unsigned) jam64(prod, 32);
+    if (fz < 0x40000000) {
+        ez--;
+        fz <<= 1;
+    }
+    return round_pack(s, ez, fz);
+}
+
+/*
+ * float_div - Return bit-level equivalent of uf / ug
+ */
+unsigned float_div(unsigned uf, unsigned ug)
+{
+    int ef = EXP(uf), eg = EXP(ug), ez;
+    unsigned ff = FRAC(uf), fg = FRAC(ug), fz, s = SIGN(uf ^ ug);
+    unsigned long long num;
+
+    if (ef == 0xff) {
+        if (IS_NAN(uf) || IS_NAN(ug))
+            return propagate_nan(uf, ug);
+        return eg == 0xff ? invalid() : PACK(s, 0xff, 0);
+    }
+    if (eg == 0xff)
+        return fg ? propagate_nan(uf, ug) : PACK(s, 0, 0);
+    if (!eg) {
+        if (!fg) {
+            if (!(ef | ff))
+                return invalid();       /* zero over zero */
+            set_flags(FLOAT_DIVBYZERO);
+            return PACK(s, 0xff, 0);
+        }
+        fg = norm_subnormal(fg, &eg);
+    }
+    if (!ef) {
+        if (!ff)
+            return PACK(s, 0, 0);
+        ff = norm_subnormal(ff, &ef);
+    }
+
+    ez = ef - eg + 0x7e;
+    ff |= 0x800000;
+    fg |= 0x800000;
+    if (ff < fg) {
+        ez--;
+        num = (unsigned long long) ff << 31;
+    } else {
+        num = (unsigned long long) ff << 30;
+    }
+    fz = (unsigned) (num / fg);
+    if (!(fz & 0x3f))
+        fz |= (unsigned long long) fg * fz != num;  /* the remainder */
+    return round_pack(s, ez, fz);
+}
+
+/*
+ * float_sqrt - Return bit-level equivalent of sqrt(uf)
+ */
+unsigned float_sqrt(unsigned uf)
+{
+    int ef = EXP(uf), ez;
+    unsigned ff = FRAC(uf);
+    unsigned long long m, r = 0, bit;
+
+    if (IS_NAN(uf))
+        return propagate_nan(uf, 0);
+    if (SIGN(uf))
+        return (ef | ff) ? invalid() : uf;      /* sqrt(-0) is -0 */
+    if (ef == 0xff || !(ef | ff))
+        return uf;
+    if (!ef)
+        ff = norm_subnormal(ff, &ef);
+
+    /* Scale the significand to [2^60, 2^62) so that the exponent left
+       over is even, and take the integer square root, one bit at a time */
+    m = (unsigned long long) (ff | 0x800000) << (38 - (ef & 1));
+    ez = (ef & 1) ? (ef - 1) / 2 + 63 : ef / 2 + 62;
+    for (bit = 1ULL << 62; bit; bit >>= 2) {
+        if (m >= r + bit) {
+            m -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+    }
+    return round_pack(0, ez, (unsigned) r | (m != 0));
+}
+
+/*
+ * float_fma - Return bit-level equivalent of uf * ug + uh, rounded once
+ */
+unsigned float_fma(unsigned uf, unsigned ug, unsigned uh)
+{
+    int ef = EXP(uf), eg = EXP(ug), eh = EXP(uh), ep, ez, diff, shift;
+    unsigned ff = FRAC(uf), fg = FRAC(ug), fh = FRAC(uh), fz;
+    unsigned sp = SIGN(uf ^ ug), sh = SIGN(uh), s;
+    unsigned long long prod, h64, z64;
+
+    /* Like vfmadd, the first NaN wins, and infinity times zero plus a
+       quiet NaN is not invalid */
+    if (IS_NAN(uf) || IS_NAN(ug) || IS_NAN(uh)) {
+        if (IS_SNAN(uf) || IS_SNAN(ug) || IS_SNAN(uh))
+            set_flags(FLOAT_INVALID);
+        return (IS_NAN(uf) ? uf : IS_NAN(ug) ? ug : uh) | QUIET;
+    }
+    if (ef == 0xff || eg == 0xff) {
+        if (!(ef | ff) || !(eg | fg) || (eh == 0xff && sp != sh))
+            return invalid();
+        return PACK(sp, 0xff, 0);
+    }
+    if (eh == 0xff)
+        return uh;
+    if ((!ef && !ff) || (!eg && !fg)) {
+        /* A zero product: the sum is exact */
+        if (!(eh | fh) && sp != sh)
+            return PACK(float_rounding_mode == FLOAT_ROUND_DOWN, 0, 0);
+        return uh;
+    }
+    if (!ef)
+        ff = norm_subnormal(ff, &ef);
+    if (!eg)
+        fg = norm_subnormal(fg, &eg);
+
+    /* The exact product, with its leading one at bit 61 */
+    ep = ef + eg - 0x7e;
+    ff = (ff | 0x800000) << 7;
+    fg = (fg | 0x800000) << 7;
+    prod = (unsigned long long) ff * fg;
+    if (prod < 0x2000000000000000ULL) {
+        ep--;
+        prod <<= 1;
+    }
+
+    s = sp;
+    if (!eh) {
+        if (!fh)
+            return round_pack(s, ep - 1, (unsigned) jam64(prod, 31));
+        fh = norm_subnormal(fh, &eh);
+    }
+    fh = (fh | 0x800000) << 6;
+    diff = ep - eh;
+
+    if (sp == sh) {
+        if (diff <= 0) {
+            ez = eh;
+            fz = fh + (unsigned) jam64(prod, 32 - diff);
+        } else {
+            ez = ep;
+            z64 = prod + jam64((unsigned long long) fh << 32, diff);
+            fz = (unsigned) jam64(z64, 32);
+        }
+        if (fz < 0x40000000) {
+            ez--;
+            fz <<= 1;
+        }
+    } else {
+        h64 = (unsigned long long) fh << 32;
+        if (diff < 0) {
+            s = sh;
+            ez = eh;
+            z64 = h64 - jam64(prod, -diff);
+        } else if (!diff) {
+            ez = ep;
+            z64 = prod - h64;
+            if (!z64)
+                return PACK(float_rounding_mode == FLOAT_ROUND_DOWN, 0, 0);
+            if (z64 >> 63) {
+                s = !s;
+                z64 = -z64;
+            }
+        } else {
+            ez = ep;
+            z64 = prod - jam64(h64, diff);
+        }
+        shift = clz64(z64) - 1;
+        ez -= shift;
+        shift -= 32;
+        fz = shift < 0 ? (unsigned) jam64(z64, -shift) : (unsigned) z64 << shift;
+    }
+    return round_pack(s, ez, fz);
+}
+
+/*
+ * float_eq - Return 1 if uf == ug, else 0
+ */
+int float_eq(unsigned uf, unsigned ug)
+{
+    if (IS_NAN(uf) || IS_NAN(ug)) {
+        if (IS_SNAN(uf) || IS_SNAN(ug))
+            set_flags(FLOAT_INVALID);
+        return 0;
+    }
+    return uf == ug || !((uf | ug) << 1);       /* +0 == -0 */
+}
+
+/*
+ * float_lt - Return 1 if uf < ug, else 0
+ */
+int float_lt(unsigned uf, unsigned ug)
+{
+    if (IS_NAN(uf) || IS_NAN(ug)) {
+        set_flags(FLOAT_INVALID);
+        return 0;
+    }
+    if (SIGN(uf) != SIGN(ug))
+        return SIGN(uf) && ((uf | ug) << 1) != 0;
+    return uf != ug && (SIGN(uf) ^ (uf < ug));
+}
+
+/*
+ * float_le - Return 1 if uf <= ug, else 0
+ */
+int float_le(unsigned uf, unsigned ug)
+{
+    if (IS_NAN(uf) || IS_NAN(ug)) {
+        set_flags(FLOAT_INVALID);
+        return 0;
+    }
+    if (SIGN(uf) != SIGN(ug))
+        return SIGN(uf) || !((uf | ug) << 1);
+    return uf == ug || (SIGN(uf) ^ (uf < ug));
+}
@@ -0,0 +1,52 @@
+/*
+ * CS:APP Data Lab
+ *
+ * softfloat.h - Single-precision arithmetic on bit-level floats
+ *
+ * Like the float_* puzzles in bits.c, these functions take and return
+ * floats as unsigned ints holding their bit patterns, and use only
+ * integer operations. Results, including the bits of NaNs, and the
+ * exception flags are those of the x86 SSE instructions (addss, mulss,
+ * divss, sqrtss, vfmadd, ucomiss/comiss) with denormals enabled, so
+ * they do not depend on the FPU mode of the machine running them.
+ */
+#ifndef SOFTFLOAT_H
+#define SOFTFLOAT_H
+
+/* Rounding modes. The values are those of the MXCSR rounding control */
+#define FLOAT_ROUND_NEAREST 0   /* to nearest, ties to even */
+#define FLOAT_ROUND_DOWN    1   /* toward -infinity */
+#define FLOAT_ROUND_UP      2   /* toward +infinity */
+#define FLOAT_ROUND_ZERO    3   /* toward zero */
+
+/* Exception flags, with the bit positions of the MXCSR status flags */
+#define FLOAT_INVALID   0x01
+#define FLOAT_DIVBYZERO 0x04
+#define FLOAT_OVERFLOW  0x08
+#define FLOAT_UNDERFLOW 0x10
+#define FLOAT_INEXACT   0x20
+
+/* Rounding mode for every operation of this thread (FLOAT_ROUND_NEAREST) */
+extern __thread int float_rounding_mode;
+
+/* Flags raised by this thread since they were last cleared. Operations
+   only ever set bits here */
+extern __thread unsigned float_exception_flags;
+
+unsigned float_add(unsigned uf, unsigned ug);
+unsigned float_sub(unsigned uf, unsigned ug);
+unsigned float_mul(unsigned uf, unsigned ug);
+unsigned float_div(unsigned uf, unsigned ug);
+unsigned float_sqrt(unsigned uf);
+
+/* uf * ug + uh with a single rounding */
+unsigned float_fma(unsigned uf, unsigned ug, unsigned uh);
+
+/* Comparisons return 0 when either argument is a NaN. float_eq only
+   raises FLOAT_INVALID for signaling NaNs (ucomiss); float_lt and
+   float_le raise it for any NaN (comiss) */
+int float_eq(unsigned uf, unsigned ug);
+int float_lt(unsigned uf, unsigned ug);
+int float_le(unsigned uf, unsigned ug);
+
+#endif /* SOFTFLOAT_H */
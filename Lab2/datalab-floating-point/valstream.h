@@ -0,0 +1,35 @@
+/*
+ * CS:APP Data Lab
+ *
+ * valstream.h - Streams of 32-bit values for fshow and ishow
+ */
+#ifndef VALSTREAM_H
+#define VALSTREAM_H
+
+#include <stddef.h>
+
+/* Parse one text token; returns nonzero and sets *valp if it is valid */
+typedef int (*parse_fn)(char *sval, unsigned *valp);
+
+/* Called with each block of values, in file order */
+typedef void (*block_fn)(const unsigned *vals, size_t n, void *ctx);
+
+/* Values passed to a block_fn at a time, at most */
+#define STREAM_BLOCK 4096
+
+/*
+ * stream_values - Read the values in file path ("-" for stdin) and pass
+ *     them to block in blocks. A binary file holds 32-bit words in host
+ *     byte order; a text file holds tokens separated by white space or
+ *     commas, each converted by parse. Returns the number of values, or
+ *     -1 if the file cannot be read. Tokens that do not parse, and
+ *     trailing bytes of a binary file, are counted in *nbad
+ */
+long long stream_values(const char *path, int binary, parse_fn parse,
+                        block_fn block, void *ctx, long long *nbad);
+
+/* A bar of up to width characters for count out of max */
+void stream_bar(char *buf, int width, unsigned long long count,
+                unsigned long long max);
+
+#endif
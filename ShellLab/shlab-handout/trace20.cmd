@@ -0,0 +1,12 @@
+# Commands for trace20.txt, run two at a time
+./myspin 1
+./myspin 3
+/bin/echo hello
+/bin/false
+./bogus
+jobs
+./myint 1
+/usr/bin/seq 3 | tee | /usr/bin/wc -l
+./myspin 5
+./myspin 5
+./myspin 5
@@ -0,0 +1,1611 @@
+/*
+ * tsh - A tiny shell program with job control
+ *
+ * Jobs are launched with posix_spawn, which the C library implements
+ * with a vfork-style clone: the child shares the shell's memory until
+ * it calls execve, so nothing is copied and the cost of a launch does
+ * not grow with the size of the shell. The child's process group,
+ * signal mask and signal dispositions are set through the spawn
+ * attributes instead of by code run in the child. The -f option
+ * launches with fork and execve instead, for comparison.
+ *
+ * The shell has no asynchronous signal handlers. SIGCHLD, SIGINT,
+ * SIGTSTP and SIGQUIT stay blocked and are read from a signalfd, and
+ * one epoll loop waits for them and for input at the prompt. While a
+ * foreground job runs only the signalfd is watched, so the shell wakes
+ * up as soon as the kernel queues the job's SIGCHLD, and the handlers
+ * run as ordinary code that can use stdio and change the job list
+ * without any masking.
+ *
+ * A command line can be a pipeline, a | b | c, and any command in it
+ * can redirect its input or output with < file, > file or >> file. The
+ * operators are words of their own, separated by spaces. A pipeline is
+ * one job: its processes share the process group of the first one, so
+ * a signal from the keyboard, fg or bg reaches all of them, and the
+ * job ends when the last of them is reaped. The tee built-in copies its
+ * input to its output and to files inside the kernel, with tee(2) and
+ * splice(2), in a child of the shell that joins the pipeline.
+ *
+ * With -b file, tsh runs the command lines of file as a batch instead of
+ * reading commands from stdin, keeping up to -j jobs running at once and
+ * starting the next line as each one ends, as xargs -P does. Each job is
+ * reported with its exit status and wall time as it ends, and a summary
+ * of throughput and of how busy the job slots were ends the batch.
+ * ctrl-c stops the batch: no more lines are started and the jobs running
+ * are interrupted. ctrl-z stops every job and then the shell itself, and
+ * all of them go on when the shell is continued.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <ctype.h>
+#include <signal.h>
+#include <spawn.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/epoll.h>
+#include <errno.h>
+
+/* Misc manifest constants */
+#define MAXLINE    1024   /* max line size */
+#define MAXARGS     128   /* max args on a command line */
+#define JOBCHUNK     64   /* job structs allocated at a time */
+#define MAXPROCS     16   /* max processes in a pipeline */
+#define TEECHUNK  65536   /* bytes the tee built-in moves at a time */
+
+/* Job states */
+#define UNDEF 0 /* undefined */
+#define FG 1    /* running in foreground */
+#define BG 2    /* running in background */
+#define ST 3    /* stopped */
+
+/*
+ * Jobs states: FG (foreground), BG (background), ST (stopped)
+ * Job state transitions and enabling actions:
+ *     FG -> ST  : ctrl-z
+ *     ST -> FG  : fg command
+ *     ST -> BG  : bg command
+ *     BG -> FG  : fg command
+ * At most 1 job can be in the FG state.
+ */
+
+/* Global variables */
+extern char **environ;      /* defined in libc */
+char prompt[] = "tsh> ";    /* command line prompt (DO NOT CHANGE) */
+int verbose = 0;            /* if true, print additional output */
+int use_fork = 0;           /* if true, launch with fork instead of posix_spawn */
+char sbuf[MAXLINE];         /* for composing sprintf messages */
+
+struct proc_t {             /* A process of a job */
+    pid_t pid;              /* its PID */
+    int state;              /* BG (running), ST, or UNDEF once reaped */
+    struct job_t *job;      /* the job it belongs to */
+    struct proc_t *next;    /* next in its PID hash chain */
+};
+
+struct job_t {              /* The job struct */
+    pid_t pid;              /* job PID: the first process, and the group */
+    int jid;                /* job ID [1, 2, ...] */
+    int state;              /* UNDEF, BG, FG, or ST */
+    char cmdline[MAXLINE];  /* command line */
+    struct proc_t procs[MAXPROCS]; /* the processes, in pipeline order */
+    int nprocs;
+    int live;               /* processes not yet reaped */
+    int running;            /* processes neither stopped nor reaped */
+    int status;             /* wait status of the last process */
+    double start;           /* when it was launched, in seconds */
+    int line;               /* its line in the batch file, or 0 */
+    struct job_t *next;     /* next free */
+};
+
+struct stage_t {            /* A command of a pipeline */
+    char **argv;
+    char *in;               /* file for < or NULL */
+    char *out;              /* file for > or >>, or NULL */
+    int append;             /* if true, out was given with >> */
+};
+
+/*
+ * The job list has no fixed size. The processes of the jobs are found
+ * by PID through a hash table, and jobs by JID through an array indexed
+ * by JID. Job structs are taken from a free list. A new job gets the
+ * largest JID in use plus one, as in the reference shell. Signals are
+ * handled synchronously (see main), so the tables are never seen half
+ * updated.
+ */
+struct joblist_t {
+    struct proc_t **pid_hash; /* hash chains; the size is a power of 2 */
+    int hash_size;
+    int nprocs;               /* processes in the hash table */
+    struct job_t **by_jid;    /* by_jid[jid], NULL if not in use */
+    int jid_size;
+    struct job_t *free;       /* unused job structs */
+    struct job_t *fg;         /* the foreground job, or NULL */
+    int count;                /* jobs in the list */
+    int maxjid;               /* largest JID in use, 0 if none */
+};
+struct joblist_t jobs;      /* The job list */
+
+posix_spawnattr_t spawn_attr; /* process group and signals of every job */
+sigset_t job_mask;          /* signal mask jobs start with */
+int sigfd = -1;             /* signalfd for the signals the shell handles */
+int epfd = -1;              /* epoll instance: sigfd and, if it can, stdin */
+int input_polled = 0;       /* if true, stdin is in the epoll set */
+
+struct batch_t {            /* A batch run with -b */
+    int slots;              /* jobs kept running at once; 0 if no batch */
+    int running;            /* jobs started and not yet over */
+    int stop;               /* if true, start no more jobs */
+    int started, ok, failed, killed, unstarted;
+    double busy;            /* sum of the wall times of the jobs */
+    double longest;         /* the longest wall time, and its line */
+    int longest_line;
+} batch;
+
+struct fgwait_t {           /* Foreground jobs timed with -t */
+    int on;                 /* if true, time them */
+    double chld;            /* when waitfg read a SIGCHLD, or 0 */
+    int n;                  /* jobs timed */
+    double sum, min, max;   /* SIGCHLD to prompt, in seconds */
+} fgwait;
+
+char inbuf[MAXLINE];        /* input read but not yet evaluated */
+int inlen = 0;
+int ineof = 0;              /* if true, stdin has ended */
+/* End global variables */
+
+
+/* Function prototypes */
+
+/* Here are the functions that you will implement */
+void eval(char *cmdline);
+int builtin_cmd(char **argv);
+int isbuiltin(char *name);
+void do_bgfg(char **argv);
+void waitfg(pid_t pid);
+
+void sigchld_handler(int sig);
+void sigtstp_handler(int sig);
+void sigint_handler(int sig);
+
+int parsepipe(char **argv, struct stage_t *stages);
+int runpipe(struct stage_t *stages, int n, pid_t *pids);
+struct job_t *startjob(struct stage_t *stages, int n, int state, char *cmdline);
+pid_t launch(char **argv, int in, int out, int next, pid_t pgid, const sigset_t *mask);
+int tee_builtin(char **argv);
+void init_spawn(void);
+void init_events(void);
+void handle_signals(void);
+int readline_events(char *cmdline);
+int run_batch(char *file);
+void batch_done(struct job_t *job);
+void signaljobs(int sig);
+double now(void);
+void fgwait_report(void);
+
+/* Here are helper routines that we've provided for you */
+int parseline(const char *cmdline, char **argv);
+void sigquit_handler(int sig);
+
+void clearjob(struct job_t *job);
+void initjobs(struct joblist_t *jobs);
+int maxjid(struct joblist_t *jobs);
+int addjob(struct joblist_t *jobs, pid_t *pids, int n, int state, char *cmdline);
+int deletejob(struct joblist_t *jobs, struct job_t *job);
+void unhashproc(struct joblist_t *jobs, struct proc_t *proc);
+void setjobstate(struct joblist_t *jobs, struct job_t *job, int state);
+void continuejob(struct joblist_t *jobs, struct job_t *job, int state);
+pid_t fgpid(struct joblist_t *jobs);
+struct proc_t *getproc(struct joblist_t *jobs, pid_t pid);
+struct job_t *getjobpid(struct joblist_t *jobs, pid_t pid);
+struct job_t *getjobjid(struct joblist_t *jobs, int jid);
+int pid2jid(pid_t pid);
+void listjobs(struct joblist_t *jobs);
+
+void usage(void);
+void unix_error(char *msg);
+void app_error(char *msg);
+typedef void handler_t(int);
+handler_t *Signal(int signum, handler_t *handler);
+
+/*
+ * main - The shell's main routine
+ */
+int main(int argc, char **argv)
+{
+    char c;
+    char cmdline[MAXLINE];
+    char *batch_file = NULL;
+    int emit_prompt = 1; /* emit prompt (default) */
+
+    /* Redirect stderr to stdout (so that driver will get all output
+     * on the pipe connected to stdout) */
+    dup2(1, 2);
+
+    /* Parse the command line */
+    while ((c = getopt(argc, argv, "hvpftb:j:")) != EOF) {
+        switch (c) {
+        case 'h':             /* print help message */
+            usage();
+	    break;
+        case 'v':             /* emit additional diagnostic info */
+            verbose = 1;
+	    break;
+        case 'p':             /* don't print a prompt */
+            emit_prompt = 0;  /* handy for automatic testing */
+	    break;
+        case 'f':             /* launch jobs with fork and execve */
+            use_fork = 1;
+	    break;
+        case 't':             /* time each foreground job's SIGCHLD to prompt */
+            if (!fgwait.on)
+		atexit(fgwait_report);
+            fgwait.on = 1;
+	    break;
+        case 'b':             /* run the commands in a file as a batch */
+            batch_file = optarg;
+	    break;
+        case 'j':             /* jobs a batch keeps running at once */
+            if ((batch.slots = atoi(optarg)) < 1)
+		usage();
+	    break;
+	default:
+            usage();
+	}
+    }
+    if (batch.slots && !batch_file)
+	usage();              /* -j is only for a batch */
+
+    /* Route the signals to the signalfd instead of handlers:
+     * SIGINT (ctrl-c), SIGTSTP (ctrl-z), SIGCHLD (terminated or
+     * stopped child), and SIGQUIT, a clean way to kill the shell */
+    init_events();
+
+    /* Initialize the job list and the spawn attributes */
+    initjobs(&jobs);
+    init_spawn();
+
+    /* Run a batch instead of reading commands */
+    if (batch_file) {
+	if (batch.slots == 0 && (batch.slots = sysconf(_SC_NPROCESSORS_ONLN)) < 1)
+	    batch.slots = 1;
+	exit(run_batch(batch_file));
+    }
+
+    /* Execute the shell's read/eval loop */
+    while (1) {
+
+	/* Read command line */
+	if (emit_prompt) {
+	    printf("%s", prompt);
+	    fflush(stdout);
+	}
+	if (!readline_events(cmdline)) { /* End of file (ctrl-d) */
+	    fflush(stdout);
+	    exit(0);
+	}
+
+	/* Evaluate the command line */
+	eval(cmdline);
+	fflush(stdout);
+	fflush(stdout);
+    }
+
+    exit(0); /* control never reaches here */
+}
+
+/*
+ * eval - Evaluate the command line that the user has just typed in
+ *
+ * If the user has requested a built-in command (quit, jobs, bg or fg)
+ * then execute it immediately. Otherwise, launch a child process and
+ * run the job in the context of the child. If the job is running in
+ * the foreground, wait for it to terminate and then return.  Note:
+ * each child process must have a unique process group ID so that our
+ * background children don't receive SIGINT (SIGTSTP) from the kernel
+ * when we type ctrl-c (ctrl-z) at the keyboard. The processes of a
+ * pipeline share one process group, that of the first.
+*/
+void eval(char *cmdline)
+{
+    char *argv[MAXARGS];
+    char buf[MAXLINE];
+    struct stage_t stages[MAXPROCS];
+    struct job_t *job;
+    int bg, n;
+
+    strcpy(buf, cmdline);
+    bg = parseline(buf, argv);
+    if (argv[0] == NULL)
+	return;   /* ignore empty lines */
+    if ((n = parsepipe(argv, stages)) < 0)
+	return;
+    if (n == 1 && (stages[0].in || stages[0].out) && isbuiltin(stages[0].argv[0])) {
+	printf("%s: cannot redirect a built-in command\n", stages[0].argv[0]);
+	return;
+    }
+    if (n == 1 && builtin_cmd(stages[0].argv))
+	return;
+
+    if ((job = startjob(stages, n, bg ? BG : FG, cmdline)) == NULL)
+	return;
+    if (!bg)
+	waitfg(job->pid);
+    else
+	printf("[%d] (%d) %s", job->jid, job->pid, cmdline);
+}
+
+/*
+ * startjob - Launch the n stages of a pipeline and add them to the job
+ *     list as one job in state state. Returns the job, or NULL if none
+ *     of its processes could be started
+ */
+struct job_t *startjob(struct stage_t *stages, int n, int state, char *cmdline)
+{
+    pid_t pids[MAXPROCS];
+    struct job_t *job;
+    double start = now();
+
+    /* A child that exits at once is not reaped until the next look at
+       the signalfd, by which time it is in the job list */
+    if ((n = runpipe(stages, n, pids)) == 0)
+	return NULL;
+    if (!addjob(&jobs, pids, n, state, cmdline)) {
+	kill(-pids[0], SIGKILL);
+	return NULL;
+    }
+    job = getjobpid(&jobs, pids[0]);
+    job->start = start;
+    return job;
+}
+
+/*
+ * parsepipe - Split argv at each | into the stages of a pipeline, and
+ *     take the redirections out of each stage's argv. argv is changed
+ *     in place. Returns the number of stages, or -1 after printing an
+ *     error
+ */
+int parsepipe(char **argv, struct stage_t *stages)
+{
+    struct stage_t *st = stages;
+    char **out = argv;     /* where the next word of a stage goes */
+    char **in, *word;
+
+    memset(st, 0, sizeof(*st));
+    st->argv = out;
+    for (in = argv; ; in++) {
+	word = *in;        /* out can catch up with in and overwrite it */
+	if (word == NULL || !strcmp(word, "|")) {
+	    if (out == st->argv) {
+		printf("tsh: missing command%s\n", word ? " before |" :
+		       (st > stages) ? " after |" : "");
+		return -1;
+	    }
+	    *out++ = NULL;
+	    if (word == NULL)
+		return st - stages + 1;
+	    if (++st == stages + MAXPROCS) {
+		printf("tsh: more than %d commands in a pipeline\n", MAXPROCS);
+		return -1;
+	    }
+	    memset(st, 0, sizeof(*st));
+	    st->argv = out;
+	} else if (!strcmp(word, "<") || !strcmp(word, ">") || !strcmp(word, ">>")) {
+	    if (in[1] == NULL || !strcmp(in[1], "|")) {
+		printf("tsh: missing file name after %s\n", word);
+		return -1;
+	    }
+	    if (*word == '<')
+		st->in = in[1];
+	    else {
+		st->out = in[1];
+		st->append = word[1] == '>';
+	    }
+	    in++;
+	} else
+	    *out++ = word;
+    }
+}
+
+/*
+ * openredir - Open a file named in a redirection, close-on-exec so that
+ *     only the process it is passed to keeps it. Returns -1 after
+ *     printing an error if it cannot be opened
+ */
+static int openredir(char *file, int flags)
+{
+    int fd = open(file, flags | O_CLOEXEC, 0666);
+
+    if (fd < 0)
+	printf("%s: %s\n", file, strerror(errno));
+    return fd;
+}
+
+/*
+ * runpipe - Start the n stages of a pipeline, each reading the output
+ *     of the one before, in the process group of the first. A stage
+ *     that cannot be started is left out, and its neighbours see the
+ *     end of their input or a broken pipe. Returns the number of
+ *     processes started, with their PIDs in pids
+ */
+int runpipe(struct stage_t *stages, int n, pid_t *pids)
+{
+    int i, in, out, next, fds[2], count = 0;
+    pid_t pid;
+
+    in = STDIN_FILENO;
+    for (i = 0; i < n; i++) {
+	/* The pipe to the next stage */
+	next = -1;
+	out = STDOUT_FILENO;
+	if (i < n - 1) {
+	    if (pipe2(fds, O_CLOEXEC) < 0)
+		unix_error("pipe error");
+	    next = fds[0];
+	    out = fds[1];
+	}
+
+	/* Redirections take the place of the pipe ends */
+	if (stages[i].in && in >= 0) {
+	    if (in != STDIN_FILENO)
+		close(in);
+	    in = openredir(stages[i].in, O_RDONLY);
+	}
+	if (stages[i].out && out >= 0) {
+	    if (out != STDOUT_FILENO)
+		close(out);
+	    out = openredir(stages[i].out, O_WRONLY | O_CREAT |
+			    (stages[i].append ? O_APPEND : O_TRUNC));
+	}
+
+	pid = -1;
+	if (in >= 0 && out >= 0)
+	    pid = launch(stages[i].argv, in, out, next, count ? pids[0] : 0, &job_mask);
+	if (pid > 0)
+	    pids[count++] = pid;
+
+	if (in > STDIN_FILENO)
+	    close(in);
+	if (out > STDOUT_FILENO)
+	    close(out);
+	in = next;
+    }
+    return count;
+}
+
+/*
+ * init_events - Block the signals the shell handles, remembering the
+ *     mask for jobs, and set up the signalfd and the epoll set. stdin
+ *     joins the epoll set unless it cannot be polled, like a regular
+ *     file, which is then read whenever the shell wants input
+ */
+void init_events(void)
+{
+    struct epoll_event ev;
+    sigset_t mask;
+
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTSTP);
+    sigaddset(&mask, SIGQUIT);
+    if (sigprocmask(SIG_BLOCK, &mask, &job_mask) < 0)
+	unix_error("sigprocmask error");
+    if ((sigfd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC)) < 0)
+	unix_error("signalfd error");
+    if ((epfd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+	unix_error("epoll_create1 error");
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = sigfd;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, sigfd, &ev) < 0)
+	unix_error("epoll_ctl error");
+    ev.data.fd = STDIN_FILENO;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, STDIN_FILENO, &ev) == 0)
+	input_polled = 1;
+    else if (errno != EPERM)
+	unix_error("epoll_ctl error");
+}
+
+/*
+ * handle_signals - Run the handler of every signal waiting on the
+ *     signalfd
+ */
+void handle_signals(void)
+{
+    struct signalfd_siginfo info[16];
+    ssize_t n;
+    int i;
+
+    while ((n = read(sigfd, info, sizeof(info))) > 0) {
+	for (i = 0; i < n / (ssize_t) sizeof(info[0]); i++) {
+	    switch (info[i].ssi_signo) {
+	    case SIGCHLD:
+		if (fgwait.on && jobs.fg)
+		    fgwait.chld = now();
+		sigchld_handler(SIGCHLD);
+		break;
+	    case SIGINT:
+		sigint_handler(SIGINT);
+		break;
+	    case SIGTSTP:
+		sigtstp_handler(SIGTSTP);
+		break;
+	    case SIGQUIT:
+		sigquit_handler(SIGQUIT);
+		break;
+	    }
+	}
+    }
+    if (n < 0 && errno != EAGAIN && errno != EINTR)
+	unix_error("signalfd read error");
+}
+
+/*
+ * read_input - Read what stdin has into inbuf
+ */
+static void read_input(void)
+{
+    ssize_t n = read(STDIN_FILENO, inbuf + inlen, MAXLINE - 1 - inlen);
+
+    if (n < 0 && errno != EINTR && errno != EAGAIN)
+	app_error("read error");
+    if (n == 0)
+	ineof = 1;
+    if (n > 0)
+	inlen += n;
+}
+
+/*
+ * readline_events - Wait for the next command line, handling signals
+ *     as they come, and copy it to cmdline with its newline. A line too
+ *     long for MAXLINE comes in pieces, as with fgets. Returns 0 at the
+ *     end of the input; a last line with no newline is dropped
+ */
+int readline_events(char *cmdline)
+{
+    struct epoll_event ev[2];
+    char *nl;
+    int i, n, len;
+
+    while (1) {
+	handle_signals();
+	nl = memchr(inbuf, '\n', inlen);
+	if (nl != NULL || inlen == MAXLINE - 1) {
+	    len = nl ? nl - inbuf + 1 : inlen;
+	    memcpy(cmdline, inbuf, len);
+	    cmdline[len] = '\0';
+	    memmove(inbuf, inbuf + len, inlen - len);
+	    inlen -= len;
+	    return 1;
+	}
+	if (ineof)
+	    return 0;
+
+	if (!input_polled) {
+	    read_input();
+	    continue;
+	}
+	if ((n = epoll_wait(epfd, ev, 2, -1)) < 0 && errno != EINTR)
+	    unix_error("epoll_wait error");
+	for (i = 0; i < n; i++)
+	    if (ev[i].data.fd == STDIN_FILENO)
+		read_input();
+    }
+}
+
+/*
+ * init_spawn - Set up the attributes every job is spawned with: a
+ *     process group of its own, and the signals the shell handles back
+ *     to their defaults. The signal mask is set per launch
+ */
+void init_spawn(void)
+{
+    sigset_t defaults;
+    int err;
+
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGINT);
+    sigaddset(&defaults, SIGTSTP);
+    sigaddset(&defaults, SIGCHLD);
+    sigaddset(&defaults, SIGQUIT);
+
+    if ((err = posix_spawnattr_init(&spawn_attr)) != 0 ||
+	(err = posix_spawnattr_setflags(&spawn_attr, POSIX_SPAWN_SETPGROUP |
+					POSIX_SPAWN_SETSIGMASK |
+					POSIX_SPAWN_SETSIGDEF)) != 0 ||
+	(err = posix_spawnattr_setpgroup(&spawn_attr, 0)) != 0 ||
+	(err = posix_spawnattr_setsigdefault(&spawn_attr, &defaults)) != 0) {
+	errno = err;
+	unix_error("posix_spawnattr error");
+    }
+}
+
+/*
+ * launch - Start the program argv[0] with in and out as its stdin and
+ *     stdout, in process group pgid (a new group if 0) and with the
+ *     signal mask mask. Returns its PID, or -1 if it cannot be started.
+ *     With posix_spawn a program that cannot be run is reported here and
+ *     never becomes a job; with fork the child reports it and exits.
+ *     The tee built-in always runs in a fork of the shell. next is the
+ *     read end of the pipe to the next stage, or -1; the child must not
+ *     keep it open
+ */
+pid_t launch(char **argv, int in, int out, int next, pid_t pgid, const sigset_t *mask)
+{
+    posix_spawn_file_actions_t actions, *ap = NULL;
+    int is_tee = !strcmp(argv[0], "tee");
+    pid_t pid;
+    int err;
+
+    if (use_fork || is_tee) {
+	fflush(stdout);
+	if ((pid = fork()) < 0)
+	    unix_error("fork error");
+	if (pid == 0) {
+	    sigprocmask(SIG_SETMASK, mask, NULL);
+	    setpgid(0, pgid);
+	    if (in != STDIN_FILENO)
+		dup2(in, STDIN_FILENO);
+	    if (out != STDOUT_FILENO)
+		dup2(out, STDOUT_FILENO);
+	    if (is_tee) {
+		/* No exec closes the shell's close-on-exec fds here. A
+		   reader of tee's own output pipe would keep tee from ever
+		   seeing EPIPE when the next stage exits */
+		if (in > STDERR_FILENO)
+		    close(in);
+		if (out > STDERR_FILENO)
+		    close(out);
+		if (next >= 0)
+		    close(next);
+		close(sigfd);
+		close(epfd);
+		_exit(tee_builtin(argv));
+	    }
+	    if (execve(argv[0], argv, environ) < 0) {
+		/* _exit, so that the child does not run the shell's
+		   atexit handlers (fgwait_report under -t) */
+		printf("%s: Command not found\n", argv[0]);
+		fflush(stdout);
+		_exit(0);
+	    }
+	}
+	/* Also set in the parent, so that the group exists before the
+	   next stage is started into it */
+	setpgid(pid, pgid ? pgid : pid);
+	return pid;
+    }
+
+    if (in != STDIN_FILENO || out != STDOUT_FILENO) {
+	ap = &actions;
+	posix_spawn_file_actions_init(ap);
+	if (in != STDIN_FILENO)
+	    posix_spawn_file_actions_adddup2(ap, in, STDIN_FILENO);
+	if (out != STDOUT_FILENO)
+	    posix_spawn_file_actions_adddup2(ap, out, STDOUT_FILENO);
+    }
+    posix_spawnattr_setpgroup(&spawn_attr, pgid);
+    posix_spawnattr_setsigmask(&spawn_attr, mask);
+    err = posix_spawn(&pid, argv[0], ap, &spawn_attr, argv, environ);
+    if (ap)
+	posix_spawn_file_actions_destroy(ap);
+    if (err == EAGAIN || err == ENOMEM) {
+	printf("%s: %s\n", argv[0], strerror(err));
+	return -1;
+    }
+    if (err != 0) {
+	printf("%s: Command not found\n", argv[0]);
+	return -1;
+    }
+    return pid;
+}
+
+/*
+ * ispipe - Return true if fd is a pipe
+ */
+static int ispipe(int fd)
+{
+    struct stat sb;
+
+    return fstat(fd, &sb) == 0 && S_ISFIFO(sb.st_mode);
+}
+
+/*
+ * drain - Move exactly n bytes out of the pipe from into fd to, with
+ *     splice, or with read and write if to cannot be spliced into (a
+ *     terminal, or a file opened for appending). Returns 0, or -1 on an
+ *     error
+ */
+static int drain(int from, int to, size_t n)
+{
+    char buf[4096];
+    ssize_t r, w, off;
+
+    while (n > 0) {
+	r = splice(from, NULL, to, NULL, n, SPLICE_F_MOVE);
+	if (r < 0 && errno == EINVAL) {
+	    if ((r = read(from, buf, n < sizeof(buf) ? n : sizeof(buf))) <= 0)
+		return -1;
+	    for (off = 0; off < r; off += w)
+		if ((w = write(to, buf + off, r - off)) < 0)
+		    return -1;
+	}
+	if (r <= 0)
+	    return -1;
+	n -= r;
+    }
+    return 0;
+}
+
+/*
+ * pass - Move what from has next, at most n bytes, into to, with
+ *     splice if it can. Returns the bytes moved, 0 at the end of the
+ *     input, or -1 on an error
+ */
+static ssize_t pass(int from, int to, size_t n)
+{
+    char buf[4096];
+    ssize_t r;
+
+    r = splice(from, NULL, to, NULL, n, SPLICE_F_MOVE);
+    if (r < 0 && errno == EINVAL &&
+	(r = read(from, buf, n < sizeof(buf) ? n : sizeof(buf))) > 0 &&
+	write(to, buf, r) != r)
+	return -1;
+    return r;
+}
+
+/*
+ * tee_builtin - tee [file...]: copy stdin to stdout and to each file.
+ *     Runs in a child of the shell and returns its exit status.
+ *
+ * Each chunk is duplicated with tee(2) into an empty pipe per file,
+ * which takes a reference to the pages rather than copying them, and
+ * then moved on with splice(2); stdout takes the chunk last, straight
+ * from the input. Input that is not a pipe is spliced into one first.
+ */
+int tee_builtin(char **argv)
+{
+    int nfiles = 0, files[MAXARGS], tmp[MAXARGS][2], src[2];
+    int in = STDIN_FILENO, i, status = 0;
+    ssize_t n;
+
+    for (i = 1; argv[i]; i++) {
+	if ((files[nfiles] = open(argv[i], O_WRONLY | O_CREAT | O_TRUNC, 0666)) < 0) {
+	    fprintf(stderr, "tee: %s: %s\n", argv[i], strerror(errno));
+	    status = 1;
+	    continue;
+	}
+	/* The pipe each copy of a chunk waits in, as large as the input */
+	if (pipe(tmp[nfiles]) < 0)
+	    goto fail;
+	fcntl(tmp[nfiles][1], F_SETPIPE_SZ, TEECHUNK);
+	nfiles++;
+    }
+    if (nfiles > 0 && !ispipe(STDIN_FILENO)) {
+	if (pipe(src) < 0)
+	    goto fail;
+	in = src[0];
+    }
+    fflush(stdout);
+
+    while (1) {
+	if (nfiles == 0) {
+	    /* Nothing to duplicate: pass the input on as it comes */
+	    if ((n = pass(STDIN_FILENO, STDOUT_FILENO, TEECHUNK)) <= 0)
+		break;
+	    continue;
+	}
+	if (in != STDIN_FILENO && (n = pass(STDIN_FILENO, src[1], TEECHUNK)) <= 0)
+	    break;
+
+	/* The first copy fixes the chunk; the other pipes are empty and
+	   as large, so each of them takes all of it */
+	if ((n = tee(in, tmp[0][1], TEECHUNK, 0)) <= 0)
+	    break;
+	for (i = 1; i < nfiles; i++)
+	    if (tee(in, tmp[i][1], n, 0) != n)
+		goto fail;
+	for (i = 0; i < nfiles; i++)
+	    if (drain(tmp[i][0], files[i], n) < 0)
+		goto fail;
+	if (drain(in, STDOUT_FILENO, n) < 0)
+	    goto fail;
+    }
+    if (n == 0)
+	return status;
+
+ fail:
+    if (errno != EPIPE)
+	fprintf(stderr, "tee: %s\n", strerror(errno));
+    return 1;
+}
+
+/*
+ * parseline - Parse the command line and build the argv array.
+ *
+ * Characters enclosed in single quotes are treated as a single
+ * argument.  Return true if the user has requested a BG job, false if
+ * the user has requested a FG job.
+ */
+int parseline(const char *cmdline, char **argv)
+{
+    static char array[MAXLINE]; /* holds local copy of command line */
+    char *buf = array;          /* ptr that traverses command line */
+    char *delim;                /* points to first space delimiter */
+    int argc;                   /* number of args */
+    int bg;                     /* background job? */
+
+    strcpy(buf, cmdline);
+    buf[strlen(buf)-1] = ' ';  /* replace trailing '\n' with space */
+    while (*buf && (*buf == ' ')) /* ignore leading spaces */
+	buf++;
+
+    /* Build the argv list */
+    argc = 0;
+    if (*buf == '\'') {
+	buf++;
+	delim = strchr(buf, '\'');
+    }
+    else {
+	delim = strchr(buf, ' ');
+    }
+
+    while (delim) {
+	argv[argc++] = buf;
+	*delim = '\0';
+	buf = delim + 1;
+	while (*buf && (*buf == ' ')) /* ignore spaces */
+	       buf++;
+
+	if (*buf == '\'') {
+	    buf++;
+	    delim = strchr(buf, '\'');
+	}
+	else {
+	    delim = strchr(buf, ' ');
+	}
+    }
+    argv[argc] = NULL;
+
+    if (argc == 0)  /* ignore blank line */
+	return 1;
+
+    /* should the job run in the background? */
+    if ((bg = (*argv[argc-1] == '&')) != 0) {
+	argv[--argc] = NULL;
+    }
+    return bg;
+}
+
+/*
+ * isbuiltin - Return true if name is a built-in command that
+ *    builtin_cmd runs in the shell itself
+ */
+int isbuiltin(char *name)
+{
+    return !strcmp(name, "quit") || !strcmp(name, "&") || !strcmp(name, "jobs") ||
+	!strcmp(name, "bg") || !strcmp(name, "fg");
+}
+
+/*
+ * builtin_cmd - If the user has typed a built-in command then execute
+ *    it immediately.
+ */
+int builtin_cmd(char **argv)
+{
+    if (!strcmp(argv[0], "quit"))
+	exit(0);
+    if (!strcmp(argv[0], "&"))    /* a lone & */
+	return 1;
+    if (!strcmp(argv[0], "jobs")) {
+	listjobs(&jobs);
+	return 1;
+    }
+    if (!strcmp(argv[0], "bg") || !strcmp(argv[0], "fg")) {
+	do_bgfg(argv);
+	return 1;
+    }
+    return 0;     /* not a builtin command */
+}
+
+/*
+ * do_bgfg - Execute the builtin bg and fg commands
+ */
+void do_bgfg(char **argv)
+{
+    struct job_t *job;
+    char *id = argv[1];
+    int is_fg = !strcmp(argv[0], "fg");
+    pid_t pid;
+
+    if (id == NULL) {
+	printf("%s command requires PID or %%jobid argument\n", argv[0]);
+	return;
+    }
+    if (!isdigit((unsigned char) id[id[0] == '%'])) {
+	printf("%s: argument must be a PID or %%jobid\n", argv[0]);
+	return;
+    }
+
+    if (id[0] == '%') {
+	if ((job = getjobjid(&jobs, atoi(id + 1))) == NULL) {
+	    printf("%s: No such job\n", id);
+	    return;
+	}
+    } else if ((job = getjobpid(&jobs, (pid_t) atoi(id))) == NULL) {
+	printf("(%s): No such process\n", id);
+	return;
+    }
+
+    pid = job->pid;
+    continuejob(&jobs, job, is_fg ? FG : BG);
+    if (!is_fg)
+	printf("[%d] (%d) %s", job->jid, job->pid, job->cmdline);
+    kill(-pid, SIGCONT);
+
+    if (is_fg)
+	waitfg(pid);
+}
+
+/*
+ * waitfg - Block until process pid is no longer the foreground process.
+ *     Input waits in the pipe or terminal until it is; only signals are
+ *     watched
+ */
+void waitfg(pid_t pid)
+{
+    struct pollfd pfd;
+    double t;
+
+    pfd.fd = sigfd;
+    pfd.events = POLLIN;
+    fflush(stdout);
+    fgwait.chld = 0;
+    while (1) {
+	handle_signals();
+	if (fgpid(&jobs) != pid) {
+	    /* With -t, from the SIGCHLD that ended the wait to the prompt,
+	       which the main loop prints next */
+	    if (fgwait.chld > 0) {
+		t = now() - fgwait.chld;
+		if (fgwait.n == 0 || t < fgwait.min)
+		    fgwait.min = t;
+		if (t > fgwait.max)
+		    fgwait.max = t;
+		fgwait.sum += t;
+		fgwait.n++;
+	    }
+	    return;
+	}
+	if (poll(&pfd, 1, -1) < 0 && errno != EINTR)
+	    unix_error("poll error");
+    }
+}
+
+/*
+ * now - The time in seconds, from a clock that only goes forward
+ */
+double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * fgwait_report - At exit, how long the shell took from the SIGCHLD of
+ *     a foreground job to the prompt, as timed with -t
+ */
+void fgwait_report(void)
+{
+    if (fgwait.n > 0)
+	printf("fg wait: %d jobs, SIGCHLD to prompt %.1f us mean, %.1f us min, %.1f us max\n",
+	       fgwait.n, fgwait.sum / fgwait.n * 1e6, fgwait.min * 1e6, fgwait.max * 1e6);
+    fflush(stdout);
+}
+
+/*
+ * signaljobs - Send sig to the process group of every job
+ */
+void signaljobs(int sig)
+{
+    int i;
+
+    for (i = 1; i <= jobs.maxjid; i++)
+	if (jobs.by_jid[i] != NULL)
+	    kill(-jobs.by_jid[i]->pid, sig);
+}
+
+/*
+ * batch_done - Report a job of the batch that is over, and count it
+ */
+void batch_done(struct job_t *job)
+{
+    double t = now() - job->start;
+
+    if (WIFEXITED(job->status)) {
+	printf("Line %d (%d) exited with status %d in %.3f s: %s", job->line,
+	       job->pid, WEXITSTATUS(job->status), t, job->cmdline);
+	if (WEXITSTATUS(job->status) == 0)
+	    batch.ok++;
+	else
+	    batch.failed++;
+    } else {
+	printf("Line %d (%d) terminated by signal %d in %.3f s: %s", job->line,
+	       job->pid, WTERMSIG(job->status), t, job->cmdline);
+	batch.killed++;
+    }
+    batch.busy += t;
+    if (t > batch.longest) {
+	batch.longest = t;
+	batch.longest_line = job->line;
+    }
+    batch.running--;
+}
+
+/*
+ * batch_line - Start the command on line line of a batch file as a
+ *     background job. Returns 0 if the line is quit, which ends the batch
+ */
+static int batch_line(char *cmdline, int line)
+{
+    char *args[MAXARGS], **argv = args;
+    struct stage_t stages[MAXPROCS];
+    struct job_t *job;
+    int n;
+
+    parseline(cmdline, args);   /* a trailing & changes nothing */
+    if (argv[0] == NULL || argv[0][0] == '#')
+	return 1;    /* blank lines and comments */
+    if (!strcmp(argv[0], "quit"))
+	return 0;
+    if ((n = parsepipe(argv, stages)) < 0) {
+	batch.unstarted++;
+	return 1;
+    }
+    argv = stages[0].argv;
+    if (n == 1 && (!strcmp(argv[0], "jobs") || !strcmp(argv[0], "bg") ||
+		   !strcmp(argv[0], "fg"))) {
+	printf("Line %d: %s: not available in a batch\n", line, argv[0]);
+	batch.unstarted++;
+	return 1;
+    }
+    if ((job = startjob(stages, n, BG, cmdline)) == NULL) {
+	batch.unstarted++;
+	return 1;
+    }
+    job->line = line;
+    batch.started++;
+    batch.running++;
+    return 1;
+}
+
+/*
+ * run_batch - Run the command lines of file as a batch, batch.slots
+ *     jobs at a time, and print a summary. Returns the shell's exit
+ *     status: 0 if every line ran and exited with status 0
+ */
+int run_batch(char *file)
+{
+    char cmdline[MAXLINE];
+    struct pollfd pfd;
+    struct rusage ru;
+    double start = now(), elapsed, cpu;
+    int line = 0, more = 1, len, fd, c;
+    FILE *fp;
+
+    if ((fp = fopen(file, "r")) == NULL) {
+	printf("%s: %s\n", file, strerror(errno));
+	return 1;
+    }
+    /* Jobs that run at once cannot share the input sensibly, so, as
+       with xargs, they get none */
+    if ((fd = open("/dev/null", O_RDONLY)) >= 0) {
+	dup2(fd, STDIN_FILENO);
+	close(fd);
+    }
+
+    pfd.fd = sigfd;
+    pfd.events = POLLIN;
+    while (1) {
+	/* Fill the free slots, then wait for a job to end */
+	while (more && !batch.stop && batch.running < batch.slots) {
+	    if (fgets(cmdline, MAXLINE, fp) == NULL) {
+		more = 0;
+		break;
+	    }
+	    line++;
+	    len = strlen(cmdline);
+	    if (cmdline[len - 1] != '\n' && len == MAXLINE - 1) {
+		/* Not a line to run in pieces: skip the rest of it */
+		printf("Line %d: longer than %d characters, not run\n", line, MAXLINE - 2);
+		while ((c = getc(fp)) != EOF && c != '\n')
+		    ;
+		batch.unstarted++;
+		continue;
+	    }
+	    if (cmdline[len - 1] != '\n')
+		strcpy(cmdline + len, "\n");
+	    more = batch_line(cmdline, line);
+	}
+	if (batch.running == 0)
+	    break;
+	fflush(stdout);
+	if (poll(&pfd, 1, -1) < 0 && errno != EINTR)
+	    unix_error("poll error");
+	handle_signals();
+    }
+    fclose(fp);
+
+    elapsed = now() - start;
+    getrusage(RUSAGE_CHILDREN, &ru);
+    cpu = ru.ru_utime.tv_sec + ru.ru_stime.tv_sec +
+	(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1e-6;
+    printf("Batch: %d jobs in %.3f s, %.1f jobs/s\n",
+	   batch.started, elapsed, batch.started / elapsed);
+    printf("  %d exited with status 0, %d with another status, %d terminated by a signal, "
+	   "%d not started\n", batch.ok, batch.failed, batch.killed, batch.unstarted);
+    if (batch.stop)
+	printf("  interrupted: no line after %d was run\n", line);
+    if (batch.started)
+	printf("  job time %.3f s in all, %.3f s mean, %.3f s longest (line %d)\n",
+	       batch.busy, batch.busy / batch.started, batch.longest, batch.longest_line);
+    printf("  %d slots %.1f%% busy, child CPU time %.3f s (%.1f%% of the slots)\n",
+	   batch.slots, 100 * batch.busy / (elapsed * batch.slots),
+	   cpu, 100 * cpu / (elapsed * batch.slots));
+    fflush(stdout);
+    return batch.ok == batch.started && !batch.unstarted && !batch.stop ? 0 : 1;
+}
+
+/*****************
+ * Signal handlers
+ *****************/
+
+/*
+ * sigchld_handler - The kernel sends a SIGCHLD to the shell whenever
+ *     a child job terminates (becomes a zombie), or stops because it
+ *     received a SIGSTOP or SIGTSTP signal. The handler reaps all
+ *     available zombie children, but doesn't wait for any other
+ *     currently running children to terminate. It runs from the event
+ *     loop, not as an asynchronous handler. A pipeline is stopped once
+ *     all of its live processes are, and is over once all are reaped,
+ *     ending the way its last process did; each is reported once,
+ *     under the job's PID.
+ */
+void sigchld_handler(int sig)
+{
+    struct proc_t *proc;
+    struct job_t *job;
+    int status;
+    pid_t pid;
+
+    while ((pid = waitpid(-1, &status, WNOHANG | WUNTRACED)) > 0) {
+	if ((proc = getproc(&jobs, pid)) == NULL)
+	    continue;
+	job = proc->job;
+	if (proc->state == BG)
+	    job->running--;
+	if (WIFSTOPPED(status)) {
+	    proc->state = ST;
+	} else {
+	    proc->state = UNDEF;
+	    unhashproc(&jobs, proc);	/* its PID may be reused now */
+	    job->live--;
+	    if (proc == &job->procs[job->nprocs - 1])
+		job->status = status;
+	}
+
+	if (job->live == 0) {
+	    if (batch.slots)
+		batch_done(job);
+	    else if (WIFSIGNALED(job->status))
+		printf("Job [%d] (%d) terminated by signal %d\n",
+		       job->jid, job->pid, WTERMSIG(job->status));
+	    deletejob(&jobs, job);
+	} else if (job->running == 0 && job->state != ST) {
+	    setjobstate(&jobs, job, ST);
+	    if (!batch.slots)	/* the batch reports its own stop */
+		printf("Job [%d] (%d) stopped by signal %d\n", job->jid, job->pid,
+		       WIFSTOPPED(status) ? WSTOPSIG(status) : SIGTSTP);
+	}
+    }
+    fflush(stdout);
+}
+
+/*
+ * sigint_handler - The kernel sends a SIGINT to the shell whenver the
+ *    user types ctrl-c at the keyboard.  Catch it and send it along
+ *    to the foreground job. In a batch every job is in the foreground:
+ *    they are all interrupted, and no more are started.
+ */
+void sigint_handler(int sig)
+{
+    pid_t pid = fgpid(&jobs);
+
+    if (batch.slots) {
+	batch.stop = 1;
+	signaljobs(sig);
+	signaljobs(SIGCONT);    /* a stopped job takes SIGINT when it goes on */
+	return;
+    }
+    if (pid != 0)
+	kill(-pid, sig);
+}
+
+/*
+ * sigtstp_handler - The kernel sends a SIGTSTP to the shell whenever
+ *     the user types ctrl-z at the keyboard. Catch it and suspend the
+ *     foreground job by sending it a SIGTSTP. A batch suspends every
+ *     job and then the shell, and continues them all when the shell
+ *     is continued.
+ */
+void sigtstp_handler(int sig)
+{
+    pid_t pid = fgpid(&jobs);
+    int i;
+
+    if (batch.slots) {
+	signaljobs(sig);
+	printf("Batch stopped by signal %d\n", sig);
+	fflush(stdout);
+	kill(getpid(), SIGSTOP);
+
+	/* Continued. A job stopped after its SIGCHLD was last read is
+	   found running again by waitpid, which no longer reports it */
+	for (i = 1; i <= jobs.maxjid; i++)
+	    if (jobs.by_jid[i] != NULL)
+		continuejob(&jobs, jobs.by_jid[i], BG);
+	signaljobs(SIGCONT);
+	printf("Batch continued\n");
+	fflush(stdout);
+	return;
+    }
+    if (pid != 0)
+	kill(-pid, sig);
+}
+
+/*********************
+ * End signal handlers
+ *********************/
+
+/***********************************************
+ * Helper routines that manipulate the job list
+ **********************************************/
+
+/* clearjob - Clear the entries in a job struct */
+void clearjob(struct job_t *job) {
+    job->pid = 0;
+    job->jid = 0;
+    job->state = UNDEF;
+    job->cmdline[0] = '\0';
+    job->nprocs = job->live = job->running = job->status = job->line = 0;
+}
+
+/* initjobs - Initialize the job list */
+void initjobs(struct joblist_t *jobs) {
+    memset(jobs, 0, sizeof(*jobs));
+}
+
+/* maxjid - Returns largest allocated job ID */
+int maxjid(struct joblist_t *jobs)
+{
+    return jobs->maxjid;
+}
+
+/* pidhash - The hash chain of PID pid */
+static struct proc_t **pidhash(struct joblist_t *jobs, pid_t pid)
+{
+    return &jobs->pid_hash[((unsigned) pid * 0x9e3779b1u) & (jobs->hash_size - 1)];
+}
+
+/*
+ * growjobs - Make room in the tables for one more job of n processes.
+ *     Returns 0 if there is no memory for it
+ */
+static int growjobs(struct joblist_t *jobs, int n)
+{
+    struct proc_t **table, *proc, *next;
+    struct job_t **jids, *job;
+    int i, size;
+
+    /* A block of job structs on the free list */
+    if (jobs->free == NULL) {
+	if ((job = malloc(JOBCHUNK * sizeof(struct job_t))) == NULL)
+	    return 0;
+	for (i = 0; i < JOBCHUNK; i++) {
+	    clearjob(&job[i]);
+	    job[i].next = jobs->free;
+	    jobs->free = &job[i];
+	}
+    }
+
+    /* The JID array covers the next JID */
+    if (jobs->maxjid + 1 >= jobs->jid_size) {
+	size = jobs->jid_size ? 2 * jobs->jid_size : JOBCHUNK;
+	if ((jids = realloc(jobs->by_jid, size * sizeof(*jids))) == NULL)
+	    return 0;
+	memset(jids + jobs->jid_size, 0, (size - jobs->jid_size) * sizeof(*jids));
+	jobs->by_jid = jids;
+	jobs->jid_size = size;
+    }
+
+    /* At most one process per hash chain on average */
+    if (jobs->nprocs + n > jobs->hash_size) {
+	size = jobs->hash_size ? jobs->hash_size : JOBCHUNK;
+	while (size < jobs->nprocs + n)
+	    size *= 2;
+	if ((table = calloc(size, sizeof(*table))) == NULL)
+	    return 0;
+	for (i = 0; i < jobs->hash_size; i++)
+	    for (proc = jobs->pid_hash[i]; proc; proc = next) {
+		next = proc->next;
+		proc->next = table[((unsigned) proc->pid * 0x9e3779b1u) & (size - 1)];
+		table[((unsigned) proc->pid * 0x9e3779b1u) & (size - 1)] = proc;
+	    }
+	free(jobs->pid_hash);
+	jobs->pid_hash = table;
+	jobs->hash_size = size;
+    }
+    return 1;
+}
+
+/*
+ * addjob - Add a job of n processes to the job list. pids[0] is the
+ *     job's PID and the process group of all of them
+ */
+int addjob(struct joblist_t *jobs, pid_t *pids, int n, int state, char *cmdline)
+{
+    struct proc_t *proc, **chain;
+    struct job_t *job;
+    int i;
+
+    if (n < 1 || n > MAXPROCS || pids[0] < 1)
+	return 0;
+    if (!growjobs(jobs, n)) {
+	printf("addjob: out of memory\n");
+	return 0;
+    }
+
+    job = jobs->free;
+    jobs->free = job->next;
+    job->pid = pids[0];
+    job->state = state;
+    job->jid = ++jobs->maxjid;
+    strcpy(job->cmdline, cmdline);
+    for (i = 0; i < n; i++) {
+	proc = &job->procs[i];
+	proc->pid = pids[i];
+	proc->state = BG;
+	proc->job = job;
+	chain = pidhash(jobs, pids[i]);
+	proc->next = *chain;
+	*chain = proc;
+    }
+    job->nprocs = job->live = job->running = n;
+    job->status = job->line = 0;
+    jobs->by_jid[job->jid] = job;
+    jobs->nprocs += n;
+    jobs->count++;
+    if (state == FG)
+	jobs->fg = job;
+    if(verbose){
+	printf("Added job [%d] %d %s\n", job->jid, job->pid, job->cmdline);
+    }
+    return 1;
+}
+
+/*
+ * unhashproc - Take a process out of the PID hash table, once it has
+ *     been reaped and its PID can belong to someone else
+ */
+void unhashproc(struct joblist_t *jobs, struct proc_t *proc)
+{
+    struct proc_t **link;
+
+    for (link = pidhash(jobs, proc->pid); *link != NULL; link = &(*link)->next)
+	if (*link == proc) {
+	    *link = proc->next;
+	    jobs->nprocs--;
+	    return;
+	}
+}
+
+/* deletejob - Delete a job from the job list */
+int deletejob(struct joblist_t *jobs, struct job_t *job)
+{
+    int i;
+
+    if (job == NULL || job->state == UNDEF)
+	return 0;
+
+    for (i = 0; i < job->nprocs; i++)
+	if (job->procs[i].state != UNDEF)
+	    unhashproc(jobs, &job->procs[i]);
+    jobs->by_jid[job->jid] = NULL;
+    /* Each step down is paid for by the addjob that stepped up */
+    while (jobs->maxjid > 0 && jobs->by_jid[jobs->maxjid] == NULL)
+	jobs->maxjid--;
+    if (jobs->fg == job)
+	jobs->fg = NULL;
+    jobs->count--;
+    clearjob(job);
+    job->next = jobs->free;
+    jobs->free = job;
+    return 1;
+}
+
+/* setjobstate - Change the state of a job in the list */
+void setjobstate(struct joblist_t *jobs, struct job_t *job, int state)
+{
+    if (jobs->fg == job)
+	jobs->fg = NULL;
+    job->state = state;
+    if (state == FG)
+	jobs->fg = job;
+}
+
+/*
+ * continuejob - Mark a job and its stopped processes running again,
+ *     in state FG or BG, before it is sent SIGCONT
+ */
+void continuejob(struct joblist_t *jobs, struct job_t *job, int state)
+{
+    int i;
+
+    for (i = 0; i < job->nprocs; i++)
+	if (job->procs[i].state == ST)
+	    job->procs[i].state = BG;
+    job->running = job->live;
+    setjobstate(jobs, job, state);
+}
+
+/* fgpid - Return PID of current foreground job, 0 if no such job */
+pid_t fgpid(struct joblist_t *jobs) {
+    return jobs->fg ? jobs->fg->pid : 0;
+}
+
+/* getproc - Find a process of a job (by PID) on the job list */
+struct proc_t *getproc(struct joblist_t *jobs, pid_t pid) {
+    struct proc_t *proc;
+
+    if (pid < 1 || jobs->count == 0)
+	return NULL;
+    for (proc = *pidhash(jobs, pid); proc; proc = proc->next)
+	if (proc->pid == pid)
+	    return proc;
+    return NULL;
+}
+
+/* getjobpid  - Find a job (by the PID of any of its processes) on the job list */
+struct job_t *getjobpid(struct joblist_t *jobs, pid_t pid) {
+    struct proc_t *proc = getproc(jobs, pid);
+
+    return proc ? proc->job : NULL;
+}
+
+/* getjobjid  - Find a job (by JID) on the job list */
+struct job_t *getjobjid(struct joblist_t *jobs, int jid)
+{
+    if (jid < 1 || jid > jobs->maxjid)
+	return NULL;
+    return jobs->by_jid[jid];
+}
+
+/* pid2jid - Map process ID to job ID */
+int pid2jid(pid_t pid)
+{
+    struct job_t *job = getjobpid(&jobs, pid);
+
+    return job ? job->jid : 0;
+}
+
+/* listjobs - Print the job list, in JID order */
+void listjobs(struct joblist_t *jobs)
+{
+    struct job_t *job;
+    int i;
+
+    for (i = 1; i <= jobs->maxjid; i++) {
+	if ((job = jobs->by_jid[i]) != NULL) {
+	    printf("[%d] (%d) ", job->jid, job->pid);
+	    switch (job->state) {
+		case BG:
+		    printf("Running ");
+		    break;
+		case FG:
+		    printf("Foreground ");
+		    break;
+		case ST:
+		    printf("Stopped ");
+		    break;
+	    default:
+		    printf("listjobs: Internal error: job[%d].state=%d ",
+			   i, job->state);
+	    }
+	    printf("%s", job->cmdline);
+	}
+    }
+}
+/******************************
+ * end job list helper routines
+ ******************************/
+
+
+/***********************
+ * Other helper routines
+ ***********************/
+
+/*
+ * usage - print a help message
+ */
+void usage(void)
+{
+    printf("Usage: shell [-hvpft] [-b <file> [-j <jobs>]]\n");
+    printf("   -h   print this message\n");
+    printf("   -v   print additional diagnostic information\n");
+    printf("   -p   do not emit a command prompt\n");
+    printf("   -f   launch jobs with fork and execve instead of posix_spawn\n");
+    printf("   -t   at exit, print the time from SIGCHLD to prompt of fg jobs\n");
+    printf("   -b   run the commands in a file as a batch, then exit\n");
+    printf("   -j   jobs a batch keeps running at once (default: CPUs)\n");
+    exit(1);
+}
+
+/*
+ * unix_error - unix-style error routine
+ */
+void unix_error(char *msg)
+{
+    fprintf(stdout, "%s: %s\n", msg, strerror(errno));
+    exit(1);
+}
+
+/*
+ * app_error - application-style error routine
+ */
+void app_error(char *msg)
+{
+    fprintf(stdout, "%s\n", msg);
+    exit(1);
+}
+
+/*
+ * Signal - wrapper for the sigaction function
+ */
+handler_t *Signal(int signum, handler_t *handler)
+{
+    struct sigaction action, old_action;
+
+    action.sa_handler = handler;
+    sigemptyset(&action.sa_mask); /* block sigs of type being handled */
+    action.sa_flags = SA_RESTART; /* restart syscalls if possible */
+
+    if (sigaction(signum, &action, &old_action) < 0)
+	unix_error("Signal error");
+    return (old_action.sa_handler);
+}
+
+/*
+ * sigquit_handler - The driver program can gracefully terminate the
+ *    child shell by sending it a SIGQUIT signal.
+ */
+void sigquit_handler(int sig)
+{
+    printf("Terminating after receipt of SIGQUIT signal\n");
+    exit(1);
+}
+
+
+
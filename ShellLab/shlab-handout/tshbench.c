@@ -0,0 +1,193 @@
+/*
+ * tshbench.c - Measure how fast a shell launches jobs
+ *
+ * usage: tshbench [-l] [-n <cmds>] [-r <runs>] [-c <cmdline>] [-e <cmdline>]
+ *                 <shell> [<args>...]
+ * Runs <shell> -p <args> with a script of <cmds> copies of <cmdline>
+ * (default /bin/true, a foreground job) on its standard input, and
+ * reports the best rate of <runs> runs in commands per second. Each
+ * command is launched, waited for and reaped before the next, so the
+ * rate is the shell's whole round trip per job. For example:
+ *
+ *     ./tshbench ./tsh          posix_spawn launches
+ *     ./tshbench ./tsh -f       fork launches
+ *     ./tshbench ./tshref       the reference shell
+ *
+ * With -e, the script ends with one more command before quit. The job
+ * table is measured with many background jobs alive at once: each one
+ * must spin for longer than launching all of them takes (a few ms per
+ * job), and a last foreground job must outlive them so that all are
+ * reaped. As in "make benchjobs", where the table peaks at 2000 jobs:
+ *
+ *     ./tshbench -n 2000 -r 1 -c './myspin 30 &' -e './myspin 35' ./tsh
+ *
+ * With -l, the shell also gets -t, and the line it prints at exit with
+ * the time from each foreground job's SIGCHLD to the prompt is shown
+ * for the best run. That is the part of the round trip that is the
+ * shell's own after the job is over; tshref has no -t.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#define MAXARGS 64
+#define MAXREPORT 256
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void usage(char *cmd)
+{
+    fprintf(stderr, "Usage: %s [-l] [-n <cmds>] [-r <runs>] [-c <cmdline>] [-e <cmdline>] "
+	    "<shell> [<args>...]\n", cmd);
+    exit(1);
+}
+
+/*
+ * run_shell - Run the shell once with the script on its standard
+ *     input and its output in out. Returns the elapsed time
+ */
+static double run_shell(char **argv, int script, int out)
+{
+    double start = now();
+    int status;
+    pid_t pid;
+
+    lseek(script, 0, SEEK_SET);
+    lseek(out, 0, SEEK_SET);
+    if (ftruncate(out, 0) < 0 && errno != EINVAL) {
+	perror("ftruncate");
+	exit(1);
+    }
+    if ((pid = fork()) < 0) {
+	perror("fork");
+	exit(1);
+    }
+    if (pid == 0) {
+	dup2(script, 0);
+	dup2(out, 1);
+	dup2(out, 2);
+	execv(argv[0], argv);
+	perror(argv[0]);
+	exit(1);
+    }
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status)) {
+	fprintf(stderr, "%s did not exit cleanly\n", argv[0]);
+	exit(1);
+    }
+    return now() - start;
+}
+
+/*
+ * find_report - The line of the shell's output in out that starts
+ *     with "fg wait:", in report, or an empty string
+ */
+static void find_report(int out, char *report)
+{
+    char line[MAXREPORT];
+    FILE *fp;
+
+    report[0] = '\0';
+    lseek(out, 0, SEEK_SET);
+    if ((fp = fdopen(dup(out), "r")) == NULL)
+	return;
+    while (fgets(line, sizeof(line), fp))
+	if (strncmp(line, "fg wait:", 8) == 0)
+	    strcpy(report, line);
+    fclose(fp);
+}
+
+int main(int argc, char **argv)
+{
+    char *cmdline = "/bin/true", *last = NULL, *shell_argv[MAXARGS];
+    char path[] = "/tmp/tshbenchXXXXXX", outpath[] = "/tmp/tshbenchXXXXXX";
+    char report[MAXREPORT] = "";
+    int ncmds = 2000, runs = 3, latency = 0, i, c, script, out;
+    double t, best = 0;
+    FILE *fp;
+
+    while ((c = getopt(argc, argv, "+ln:r:c:e:")) != -1) {
+	switch (c) {
+	case 'l':
+	    latency = 1;
+	    break;
+	case 'n':
+	    ncmds = atoi(optarg);
+	    break;
+	case 'r':
+	    runs = atoi(optarg);
+	    break;
+	case 'c':
+	    cmdline = optarg;
+	    break;
+	case 'e':
+	    last = optarg;
+	    break;
+	default:
+	    usage(argv[0]);
+	}
+    }
+    if (optind >= argc || ncmds < 1 || runs < 1 || argc - optind + 3 > MAXARGS)
+	usage(argv[0]);
+
+    /* The shell, -p, -t with -l, then its own arguments */
+    shell_argv[0] = argv[optind];
+    shell_argv[1] = latency ? "-pt" : "-p";
+    for (i = optind + 1; i < argc; i++)
+	shell_argv[i - optind + 1] = argv[i];
+    shell_argv[argc - optind + 1] = NULL;
+
+    /* The script: the command over and over, the last one, then quit */
+    if ((script = mkstemp(path)) < 0 || (fp = fdopen(dup(script), "w")) == NULL) {
+	perror(path);
+	exit(1);
+    }
+    unlink(path);
+    if (latency) {
+	if ((out = mkstemp(outpath)) < 0) {
+	    perror(outpath);
+	    exit(1);
+	}
+	unlink(outpath);
+    } else if ((out = open("/dev/null", O_WRONLY)) < 0) {
+	perror("/dev/null");
+	exit(1);
+    }
+    for (i = 0; i < ncmds; i++)
+	fprintf(fp, "%s\n", cmdline);
+    if (last)
+	fprintf(fp, "%s\n", last);
+    fprintf(fp, "quit\n");
+    fclose(fp);
+
+    for (i = 0; i < runs; i++) {
+	t = run_shell(shell_argv, script, out);
+	if (i == 0 || t < best) {
+	    best = t;
+	    if (latency)
+		find_report(out, report);
+	}
+    }
+    printf("%s", shell_argv[0]);
+    for (i = 2; shell_argv[i]; i++)
+	printf(" %s", shell_argv[i]);
+    printf(": %d x '%s'", ncmds, cmdline);
+    if (last)
+	printf(" then '%s'", last);
+    printf(" in %.3f s, %.0f commands/s (%.1f us each)\n",
+	   best, ncmds / best, best / ncmds * 1e6);
+    if (latency)
+	printf("  %s", report[0] ? report : "no fg wait line: does the shell have -t?\n");
+    return 0;
+}